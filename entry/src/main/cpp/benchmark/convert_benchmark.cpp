@@ -0,0 +1,218 @@
+// YUV转RGB微基准：对比color/yuv_to_rgb各指令集实现与sws_scale的耗时，并检查与标量实现、sws_scale结果的最大差值。
+//
+// 用法：convert_benchmark [选项]
+//   --size WxH         图像尺寸，默认1920x1080
+//   --format F         i420|nv12|nv21，默认i420
+//   --output F         rgba|bgra|rgb24，默认rgba
+//   --bt709            使用BT.709矩阵，默认BT.601
+//   --full-range       全范围输入，默认有限范围
+//   --threads N        转换线程数，默认1，0按CPU核数
+//   --iterations N     每个实现的转换次数，默认200
+
+#include "color/yuv_to_rgb.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libswscale/swscale.h>
+#include <libavutil/pixfmt.h>
+}
+
+namespace {
+const int DEFAULT_WIDTH = 1920;
+const int DEFAULT_HEIGHT = 1080;
+const int DEFAULT_ITERATIONS = 200;
+
+struct BenchmarkConfig {
+    int width = DEFAULT_WIDTH;
+    int height = DEFAULT_HEIGHT;
+    AVPixelFormat format = AV_PIX_FMT_YUV420P;
+    RgbFormat output = RgbFormat::RGBA;
+    YuvToRgbOptions options;
+    int iterations = DEFAULT_ITERATIONS;
+};
+
+// 连续存放的源图像
+struct SourceImage {
+    std::vector<uint8_t> buffer;
+    YuvPlanes planes;
+};
+
+void PrintUsage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--size WxH] [--format i420|nv12|nv21] [--output rgba|bgra|rgb24] [--bt709] [--full-range]\n"
+            "          [--threads N] [--iterations N]\n",
+            program);
+}
+
+bool ParseArguments(int argc, char **argv, BenchmarkConfig &config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--size" && hasValue) {
+            if (sscanf(argv[++i], "%dx%d", &config.width, &config.height) != 2) {
+                return false;
+            }
+        } else if (arg == "--format" && hasValue) {
+            std::string format = argv[++i];
+            if (format == "nv12") {
+                config.format = AV_PIX_FMT_NV12;
+            } else if (format == "nv21") {
+                config.format = AV_PIX_FMT_NV21;
+            } else if (format == "i420") {
+                config.format = AV_PIX_FMT_YUV420P;
+            } else {
+                return false;
+            }
+        } else if (arg == "--output" && hasValue) {
+            std::string output = argv[++i];
+            if (output == "bgra") {
+                config.output = RgbFormat::BGRA;
+            } else if (output == "rgb24") {
+                config.output = RgbFormat::RGB24;
+            } else if (output == "rgba") {
+                config.output = RgbFormat::RGBA;
+            } else {
+                return false;
+            }
+        } else if (arg == "--bt709") {
+            config.options.matrix = YuvMatrix::BT709;
+        } else if (arg == "--full-range") {
+            config.options.range = YuvRange::Full;
+        } else if (arg == "--threads" && hasValue) {
+            config.options.threads = atoi(argv[++i]);
+        } else if (arg == "--iterations" && hasValue) {
+            config.iterations = atoi(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return config.width > 0 && config.height > 0 && config.iterations > 0;
+}
+
+// 渐变加伪随机噪声，覆盖整个取值范围，同时保留一定的空间相关性
+SourceImage MakeSource(const BenchmarkConfig &config) {
+    int chromaWidth = (config.width + 1) / 2;
+    int chromaHeight = (config.height + 1) / 2;
+    bool semiPlanar = config.format != AV_PIX_FMT_YUV420P;
+    int chromaLinesize = semiPlanar ? chromaWidth * 2 : chromaWidth;
+    size_t lumaSize = static_cast<size_t>(config.width) * config.height;
+    size_t chromaSize = static_cast<size_t>(chromaLinesize) * chromaHeight;
+
+    SourceImage image;
+    image.buffer.resize(lumaSize + chromaSize * (semiPlanar ? 1 : 2));
+    uint32_t seed = 1;
+    for (size_t i = 0; i < image.buffer.size(); i++) {
+        seed = seed * 1103515245 + 12345;
+        image.buffer[i] = static_cast<uint8_t>((i % 251) + (seed >> 27));
+    }
+    uint8_t *base = image.buffer.data();
+    image.planes.data[0] = base;
+    image.planes.data[1] = base + lumaSize;
+    image.planes.data[2] = semiPlanar ? nullptr : base + lumaSize + chromaSize;
+    image.planes.linesize[0] = config.width;
+    image.planes.linesize[1] = chromaLinesize;
+    image.planes.linesize[2] = semiPlanar ? 0 : chromaLinesize;
+    image.planes.width = config.width;
+    image.planes.height = config.height;
+    image.planes.format = config.format;
+    return image;
+}
+
+AVPixelFormat SwsOutputFormat(RgbFormat format) {
+    switch (format) {
+    case RgbFormat::BGRA:
+        return AV_PIX_FMT_BGRA;
+    case RgbFormat::RGB24:
+        return AV_PIX_FMT_RGB24;
+    default:
+        return AV_PIX_FMT_RGBA;
+    }
+}
+
+int MaxDifference(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b) {
+    int difference = 0;
+    for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+        difference = std::max(difference, std::abs(a[i] - b[i]));
+    }
+    return difference;
+}
+
+template <typename Function> double MeasureMs(int iterations, Function convert) {
+    convert(); // 预热：分配、缓存和执行器线程
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        convert();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+void PrintResult(const char *name, double ms, double baselineMs, const BenchmarkConfig &config, const char *diff) {
+    double megapixels = static_cast<double>(config.width) * config.height / 1e6;
+    printf("  %-10s %8.3f ms  %8.1f Mpix/s  %6.2fx  %s\n", name, ms, megapixels / (ms / 1000), baselineMs / ms, diff);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    BenchmarkConfig config;
+    if (!ParseArguments(argc, argv, config)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    SourceImage source = MakeSource(config);
+    int dstLinesize = config.width * RgbBytesPerPixel(config.output);
+    size_t dstSize = static_cast<size_t>(dstLinesize) * config.height;
+
+    // sws_scale：单线程，按同样的矩阵和范围设置系数
+    SwsContext *sws = sws_getContext(config.width, config.height, config.format, config.width, config.height,
+                                     SwsOutputFormat(config.output), SWS_POINT, nullptr, nullptr, nullptr);
+    if (!sws) {
+        fprintf(stderr, "sws_getContext failed\n");
+        return 1;
+    }
+    const int *coefficients = sws_getCoefficients(config.options.matrix == YuvMatrix::BT709 ? SWS_CS_ITU709
+                                                                                           : SWS_CS_ITU601);
+    sws_setColorspaceDetails(sws, coefficients, config.options.range == YuvRange::Full ? 1 : 0, coefficients, 1, 0,
+                             1 << 16, 1 << 16);
+    std::vector<uint8_t> swsOutput(dstSize);
+    uint8_t *swsDst[4] = {swsOutput.data(), nullptr, nullptr, nullptr};
+    int swsDstLinesize[4] = {dstLinesize, 0, 0, 0};
+    double swsMs = MeasureMs(config.iterations, [&]() {
+        sws_scale(sws, source.planes.data, source.planes.linesize, 0, config.height, swsDst, swsDstLinesize);
+    });
+    sws_freeContext(sws);
+
+    printf("%dx%d %s -> %s, %s %s range, %d threads, %d iterations\n", config.width, config.height,
+           config.format == AV_PIX_FMT_NV12 ? "nv12" : (config.format == AV_PIX_FMT_NV21 ? "nv21" : "i420"),
+           config.output == RgbFormat::RGB24 ? "rgb24" : (config.output == RgbFormat::BGRA ? "bgra" : "rgba"),
+           config.options.matrix == YuvMatrix::BT709 ? "BT.709" : "BT.601",
+           config.options.range == YuvRange::Full ? "full" : "limited", config.options.threads, config.iterations);
+    printf("  %-10s %11s  %15s  %7s  %s\n", "impl", "per frame", "throughput", "vs sws", "max diff (scalar / sws)");
+    PrintResult("sws_scale", swsMs, swsMs, config, "");
+
+    std::vector<uint8_t> reference;
+    for (YuvToRgbIsa isa : {YuvToRgbIsa::Scalar, YuvToRgbIsa::Sse41, YuvToRgbIsa::Avx2, YuvToRgbIsa::Neon}) {
+        if (!IsYuvToRgbIsaSupported(isa)) {
+            continue;
+        }
+        YuvToRgbOptions options = config.options;
+        options.isa = isa;
+        std::vector<uint8_t> output(dstSize);
+        double ms = MeasureMs(config.iterations, [&]() {
+            ConvertYuvToRgb(source.planes, output.data(), dstLinesize, config.output, options);
+        });
+        if (reference.empty()) {
+            reference = output;
+        }
+        char diff[48];
+        snprintf(diff, sizeof(diff), "%d / %d", MaxDifference(output, reference), MaxDifference(output, swsOutput));
+        PrintResult(YuvToRgbIsaName(isa), ms, swsMs, config, diff);
+    }
+    printf("  auto selects %s\n", YuvToRgbIsaName(ResolveYuvToRgbIsa(YuvToRgbIsa::Auto)));
+    return 0;
+}
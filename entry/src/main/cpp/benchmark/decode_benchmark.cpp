@@ -0,0 +1,334 @@
+// 主机端（Linux）解码流水线基准。
+// 把文件或本地流送入VideoStreamHandler的解复用、解码和出帧阶段（不渲染，也不按pts节奏呈现），
+// 输出帧率、逐帧延迟（数据包到达到交给订阅者）的分位数、CPU时间和内存分配次数，用于每次改动的回归对比。
+//
+// 用法：decode_benchmark [选项] <url>...
+//   多个url同时播放，模拟多路宫格
+//   --seconds N        最长运行时间，默认读完输入为止
+//   --threads N        解码线程数，默认按CPU核数
+//   --thread-mode M    auto|frame|slice
+//   --shared           使用多路共享的解码执行器
+//   --software         只用软件解码
+//   --low-latency      低延迟模式
+//   --reconnect        断线后自动重连（默认读完或断开即结束），配合impairment_proxy测量恢复时间
+//   --report-interval S  每S秒输出一次各路的帧率、延迟和重连情况，观察损伤期间的延迟增长
+//   --verbose          输出核心库的INFO日志
+
+#include "common/log.h"
+#include "video_stream_handler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <cerrno>
+
+// 替换malloc系列入口统计分配次数和字节数，实际分配转给glibc。
+// FFmpeg的av_malloc走posix_memalign，C++的operator new走malloc，均被计入
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+}
+
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_allocatedBytes{0};
+
+inline void CountAllocation(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+} // namespace
+
+extern "C" {
+void *malloc(size_t size) {
+    CountAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    CountAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    CountAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+    CountAllocation(size);
+    void *result = __libc_memalign(alignment, size);
+    if (!result) {
+        return ENOMEM;
+    }
+    *ptr = result;
+    return 0;
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    CountAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+    CountAllocation(size);
+    return __libc_memalign(alignment, size);
+}
+}
+
+#define ALLOCATION_COUNTING 1
+#else
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_allocatedBytes{0};
+} // namespace
+#define ALLOCATION_COUNTING 0
+#endif
+
+namespace {
+// 等待流结束时检查的间隔
+const auto POLL_INTERVAL = std::chrono::milliseconds(20);
+
+// 预留的延迟样本数，避免测量期间扩容的分配计入统计
+const size_t RESERVED_SAMPLES = 1 << 16;
+
+struct BenchmarkConfig {
+    std::vector<std::string> urls;
+    double seconds = 0; // 0表示读完为止
+    double reportInterval = 0; // 0表示只输出汇总
+    StreamOptions options;
+    bool verbose = false;
+};
+
+// 一路流：handler加一个只记录延迟、不持有帧的订阅者
+struct StreamRun {
+    std::string url;
+    std::unique_ptr<VideoStreamHandler> handler;
+    std::vector<int64_t> latenciesMs; // 只由该流的出帧线程写入，停止后读取
+    std::atomic<uint64_t> frames{0};
+    // 当前报告区间内的统计，输出后清零
+    std::atomic<uint64_t> intervalFrames{0};
+    std::atomic<int64_t> intervalLatencySumMs{0};
+    std::atomic<int64_t> intervalMaxLatencyMs{0};
+    std::string lastError;
+};
+
+struct CpuTime {
+    double userSeconds = 0;
+    double systemSeconds = 0;
+};
+
+CpuTime GetCpuTime() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    CpuTime time;
+    time.userSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+    time.systemSeconds = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    return time;
+}
+
+// 最近秩法取分位数，samples须已排序
+int64_t Percentile(const std::vector<int64_t> &samples, double percent) {
+    if (samples.empty()) {
+        return -1;
+    }
+    size_t rank = static_cast<size_t>(percent / 100.0 * (samples.size() - 1) + 0.5);
+    return samples[std::min(rank, samples.size() - 1)];
+}
+
+void PrintUsage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--seconds N] [--threads N] [--thread-mode auto|frame|slice] [--shared] [--software]\n"
+            "          [--low-latency] [--reconnect] [--report-interval S] [--verbose] <url>...\n",
+            program);
+}
+
+bool ParseArguments(int argc, char **argv, BenchmarkConfig &config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seconds" && hasValue) {
+            config.seconds = atof(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            config.options.decodeThreadCount = atoi(argv[++i]);
+        } else if (arg == "--thread-mode" && hasValue) {
+            std::string mode = argv[++i];
+            if (mode == "frame") {
+                config.options.decodeThreadMode = DecodeThreadMode::Frame;
+            } else if (mode == "slice") {
+                config.options.decodeThreadMode = DecodeThreadMode::Slice;
+            } else {
+                config.options.decodeThreadMode = DecodeThreadMode::Auto;
+            }
+        } else if (arg == "--shared") {
+            config.options.sharedDecoder = true;
+        } else if (arg == "--software") {
+            config.options.decoderBackend = DecoderBackendMode::Software;
+        } else if (arg == "--low-latency") {
+            config.options.lowLatency = true;
+        } else if (arg == "--reconnect") {
+            config.options.autoReconnect = true;
+        } else if (arg == "--report-interval" && hasValue) {
+            config.reportInterval = atof(argv[++i]);
+        } else if (arg == "--verbose") {
+            config.verbose = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            return false;
+        } else {
+            config.urls.push_back(arg);
+        }
+    }
+    return !config.urls.empty();
+}
+
+void PrintLatency(const char *label, std::vector<int64_t> &latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    printf("  %-10s frames %zu, latency ms p50 %" PRId64 ", p90 %" PRId64 ", p99 %" PRId64 ", max %" PRId64 "\n",
+           label, latencies.size(), Percentile(latencies, 50), Percentile(latencies, 90), Percentile(latencies, 99),
+           latencies.empty() ? -1 : latencies.back());
+}
+
+// 区间报告：帧率、平均和最大延迟、累计重连和关键帧重同步次数
+void PrintInterval(double elapsed, double interval, size_t index, StreamRun &run) {
+    uint64_t frames = run.intervalFrames.exchange(0);
+    int64_t latencySum = run.intervalLatencySumMs.exchange(0);
+    int64_t maxLatency = run.intervalMaxLatencyMs.exchange(0);
+    ReconnectStats reconnect = run.handler->getReconnectStats();
+    KeyframeSyncStats keyframe = run.handler->getKeyframeSyncStats();
+    printf("[%7.2f] stream %zu: fps %.1f, latency avg %" PRId64 " max %" PRId64
+           " ms, reconnects %d (last recovery %.0f ms)%s, keyframe resyncs %d\n",
+           elapsed, index, frames / interval, frames > 0 ? latencySum / static_cast<int64_t>(frames) : -1,
+           frames > 0 ? maxLatency : -1, reconnect.reconnects, reconnect.lastRecoveryMs,
+           reconnect.reconnecting ? " reconnecting" : "", keyframe.resyncs);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    BenchmarkConfig config;
+    // 默认读完即结束，--reconnect时保持重连
+    config.options.autoReconnect = false;
+    if (!ParseArguments(argc, argv, config)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    HostLogSetLevel(config.verbose ? LOG_INFO : LOG_WARN);
+
+    // 测吞吐：解码出的帧立即交出，不按pts节奏等待；只测量延迟，不做追赶丢帧
+    config.options.framePacing = false;
+    config.options.targetLatencyMs = 0;
+
+    std::vector<std::unique_ptr<StreamRun>> runs;
+    for (const std::string &url : config.urls) {
+        auto run = std::make_unique<StreamRun>();
+        run->url = url;
+        run->latenciesMs.reserve(RESERVED_SAMPLES);
+        run->handler = std::make_unique<VideoStreamHandler>();
+        runs.push_back(std::move(run));
+    }
+
+    uint64_t allocationsBefore = g_allocations.load();
+    uint64_t bytesBefore = g_allocatedBytes.load();
+    CpuTime cpuBefore = GetCpuTime();
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (auto &run : runs) {
+        StreamRun *current = run.get();
+        VideoStreamHandler *handler = current->handler.get();
+        handler->addFrameSubscriber(0, [current, handler](const VideoFrame &frame) {
+            const AVFrame *avFrame = frame.avFrame();
+            int64_t receivedMs = avFrame ? static_cast<int64_t>(reinterpret_cast<intptr_t>(avFrame->opaque)) : 0;
+            if (receivedMs > 0) {
+                int64_t latencyMs = handler->elapsedMs() - receivedMs;
+                current->latenciesMs.push_back(latencyMs);
+                current->intervalLatencySumMs += latencyMs;
+                if (latencyMs > current->intervalMaxLatencyMs) {
+                    current->intervalMaxLatencyMs = latencyMs;
+                }
+                current->intervalFrames++;
+            }
+            current->frames++;
+        });
+        handler->setErrorCallback([current](const std::string &message) { current->lastError = message; });
+        if (!handler->startStream(current->url, config.options)) {
+            fprintf(stderr, "Failed to start %s\n", current->url.c_str());
+        }
+    }
+
+    // 等所有流读完，或到达时间上限
+    double lastReport = 0;
+    while (true) {
+        bool active = std::any_of(runs.begin(), runs.end(), [](const std::unique_ptr<StreamRun> &run) {
+            return run->handler->isActive();
+        });
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        if (!active || (config.seconds > 0 && elapsed >= config.seconds)) {
+            break;
+        }
+        if (config.reportInterval > 0 && elapsed - lastReport >= config.reportInterval) {
+            for (size_t i = 0; i < runs.size(); i++) {
+                PrintInterval(elapsed, elapsed - lastReport, i, *runs[i]);
+            }
+            fflush(stdout);
+            lastReport = elapsed;
+        }
+        std::this_thread::sleep_for(POLL_INTERVAL);
+    }
+    for (auto &run : runs) {
+        run->handler->stopStream();
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    CpuTime cpuAfter = GetCpuTime();
+    uint64_t allocations = g_allocations.load() - allocationsBefore;
+    uint64_t allocatedBytes = g_allocatedBytes.load() - bytesBefore;
+
+    uint64_t totalFrames = 0;
+    std::vector<int64_t> allLatencies;
+    printf("Streams:\n");
+    for (auto &run : runs) {
+        DecoderInfo decoder = run->handler->getDecoderInfo();
+        PipelineStats pipeline = run->handler->getPipelineStats();
+        printf("%s\n", run->url.c_str());
+        printf("  decoder %s (%s), threads %s x%d, fps %.1f, dropped %d\n",
+               decoder.codecName.empty() ? "none" : decoder.codecName.c_str(),
+               decoder.backend.empty() ? "none" : decoder.backend.c_str(), decoder.threadMode.c_str(),
+               decoder.threadCount, run->frames / wallSeconds, pipeline.droppedFrames);
+        if (!run->lastError.empty()) {
+            printf("  error: %s\n", run->lastError.c_str());
+        }
+        allLatencies.insert(allLatencies.end(), run->latenciesMs.begin(), run->latenciesMs.end());
+        PrintLatency("stream", run->latenciesMs);
+        totalFrames += run->frames;
+    }
+
+    double userSeconds = cpuAfter.userSeconds - cpuBefore.userSeconds;
+    double systemSeconds = cpuAfter.systemSeconds - cpuBefore.systemSeconds;
+    double cpuSeconds = userSeconds + systemSeconds;
+    printf("Total:\n");
+    printf("  wall %.2f s, frames %" PRIu64 ", fps %.1f\n", wallSeconds, totalFrames, totalFrames / wallSeconds);
+    PrintLatency("all", allLatencies);
+    printf("  cpu %.2f s (user %.2f, system %.2f), %.0f%% of one core, %.2f ms per frame\n", cpuSeconds,
+           userSeconds, systemSeconds, cpuSeconds / wallSeconds * 100,
+           totalFrames > 0 ? cpuSeconds * 1000 / totalFrames : 0.0);
+    if (ALLOCATION_COUNTING) {
+        printf("  allocations %" PRIu64 " (%.1f MiB), %.1f per frame\n", allocations, allocatedBytes / 1048576.0,
+               totalFrames > 0 ? static_cast<double>(allocations) / totalFrames : 0.0);
+    } else {
+        printf("  allocations: not available on this libc\n");
+    }
+
+    runs.clear();
+    return totalFrames > 0 ? 0 : 1;
+}
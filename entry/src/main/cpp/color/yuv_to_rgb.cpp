@@ -0,0 +1,243 @@
+#include "color/yuv_to_rgb.h"
+#include "color/yuv_to_rgb_kernels.h"
+#include "stream_executor.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixfmt.h>
+}
+
+#if defined(__arm__) && defined(__ARM_NEON)
+#include <sys/auxv.h>
+#ifndef HWCAP_NEON
+#define HWCAP_NEON (1 << 12)
+#endif
+#endif
+
+namespace {
+// 每个分块至少的行数，更小的图像分块的调度开销超过并行收益
+const int MIN_BAND_ROWS = 64;
+
+// 亮度、色度有限范围的量化区间
+const double LIMITED_Y_SCALE = 255.0 / 219.0;
+const double LIMITED_C_SCALE = 255.0 / 224.0;
+const int LIMITED_Y_OFFSET = 16;
+
+template <RgbFormat F>
+void ScalarPlanarRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst, int width,
+                     const YuvCoefficients &c) {
+    ScalarYuvRow<F>(y, u, v, 1, dst, width, c);
+}
+
+template <RgbFormat F>
+void ScalarSemiPlanarRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst, int width,
+                         const YuvCoefficients &c) {
+    ScalarYuvRow<F>(y, u, v, 2, dst, width, c);
+}
+
+const YuvRowKernels SCALAR_KERNELS = {
+    {ScalarPlanarRow<RgbFormat::RGBA>, ScalarPlanarRow<RgbFormat::BGRA>, ScalarPlanarRow<RgbFormat::RGB24>},
+    {ScalarSemiPlanarRow<RgbFormat::RGBA>, ScalarSemiPlanarRow<RgbFormat::BGRA>,
+     ScalarSemiPlanarRow<RgbFormat::RGB24>},
+};
+
+YuvCoefficients MakeCoefficients(YuvMatrix matrix, YuvRange range) {
+    // Kr、Kb取自ITU-R BT.601/BT.709
+    double kr = matrix == YuvMatrix::BT709 ? 0.2126 : 0.299;
+    double kb = matrix == YuvMatrix::BT709 ? 0.0722 : 0.114;
+    double kg = 1.0 - kr - kb;
+    bool limited = range == YuvRange::Limited;
+    double yScale = limited ? LIMITED_Y_SCALE : 1.0;
+    double cScale = limited ? LIMITED_C_SCALE : 1.0;
+    int yOffset = limited ? LIMITED_Y_OFFSET : 0;
+
+    YuvCoefficients c;
+    c.yMul = static_cast<int16_t>(std::lround(yScale * 16384));
+    c.bias = static_cast<int16_t>(32 - ((yOffset * c.yMul + 128) >> 8));
+    c.crR = static_cast<int16_t>(std::lround(2 * (1 - kr) * cScale * 8192));
+    c.cbG = static_cast<int16_t>(std::lround(2 * kb * (1 - kb) / kg * cScale * 8192));
+    c.crG = static_cast<int16_t>(std::lround(2 * kr * (1 - kr) / kg * cScale * 8192));
+    c.cbB = static_cast<int16_t>(std::lround(2 * (1 - kb) * cScale * 8192));
+    return c;
+}
+
+const YuvRowKernels *KernelsFor(YuvToRgbIsa isa) {
+    switch (isa) {
+    case YuvToRgbIsa::Scalar:
+        return &SCALAR_KERNELS;
+    case YuvToRgbIsa::Sse41:
+        return GetSse41YuvKernels();
+    case YuvToRgbIsa::Avx2:
+        return GetAvx2YuvKernels();
+    case YuvToRgbIsa::Neon:
+        return GetNeonYuvKernels();
+    default:
+        return nullptr;
+    }
+}
+
+bool CpuSupports(YuvToRgbIsa isa) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (isa == YuvToRgbIsa::Avx2) {
+        return __builtin_cpu_supports("avx2");
+    }
+    if (isa == YuvToRgbIsa::Sse41) {
+        return __builtin_cpu_supports("sse4.1");
+    }
+#elif defined(__aarch64__)
+    if (isa == YuvToRgbIsa::Neon) {
+        return true; // ARMv8必备
+    }
+#elif defined(__arm__) && defined(__ARM_NEON)
+    if (isa == YuvToRgbIsa::Neon) {
+        return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+    }
+#endif
+    return isa == YuvToRgbIsa::Scalar;
+}
+
+YuvToRgbIsa DetectBestIsa() {
+    for (YuvToRgbIsa isa : {YuvToRgbIsa::Avx2, YuvToRgbIsa::Neon, YuvToRgbIsa::Sse41}) {
+        if (IsYuvToRgbIsaSupported(isa)) {
+            return isa;
+        }
+    }
+    return YuvToRgbIsa::Scalar;
+}
+
+bool IsSemiPlanar(int format) { return format == AV_PIX_FMT_NV12 || format == AV_PIX_FMT_NV21; }
+
+struct ConvertJob {
+    const YuvPlanes *src;
+    uint8_t *dst;
+    int dstLinesize;
+    YuvRowFunction row;
+    YuvCoefficients coefficients;
+};
+
+void ConvertRows(const ConvertJob &job, int firstRow, int lastRow) {
+    const YuvPlanes &src = *job.src;
+    bool semiPlanar = IsSemiPlanar(src.format);
+    for (int row = firstRow; row < lastRow; row++) {
+        const uint8_t *y = src.data[0] + static_cast<ptrdiff_t>(row) * src.linesize[0];
+        const uint8_t *u;
+        const uint8_t *v;
+        if (semiPlanar) {
+            const uint8_t *uv = src.data[1] + static_cast<ptrdiff_t>(row / 2) * src.linesize[1];
+            bool vFirst = src.format == AV_PIX_FMT_NV21;
+            u = uv + (vFirst ? 1 : 0);
+            v = uv + (vFirst ? 0 : 1);
+        } else {
+            u = src.data[1] + static_cast<ptrdiff_t>(row / 2) * src.linesize[1];
+            v = src.data[2] + static_cast<ptrdiff_t>(row / 2) * src.linesize[2];
+        }
+        job.row(y, u, v, job.dst + static_cast<ptrdiff_t>(row) * job.dstLinesize, src.width, job.coefficients);
+    }
+}
+
+// 分块状态由调用线程和执行器任务共享；任务可能在转换完成后才被调度，因此以shared_ptr持有
+struct BandState {
+    ConvertJob job;
+    int bandRows = 0;
+    int bandCount = 0;
+    std::atomic<int> nextBand{0};
+    std::mutex mutex;
+    std::condition_variable done;
+    int finishedBands = 0;
+};
+
+// 领取并转换剩余的分块，调用线程和执行器任务都执行同一循环：
+// 没有空闲工作线程时调用线程自己转换全部分块，不会因等待排队中的任务而阻塞
+void RunBands(BandState &state) {
+    int band;
+    while ((band = state.nextBand.fetch_add(1)) < state.bandCount) {
+        int firstRow = band * state.bandRows;
+        ConvertRows(state.job, firstRow, std::min(firstRow + state.bandRows, state.job.src->height));
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (++state.finishedBands == state.bandCount) {
+            state.done.notify_all();
+        }
+    }
+}
+} // namespace
+
+int RgbBytesPerPixel(RgbFormat format) { return format == RgbFormat::RGB24 ? 3 : 4; }
+
+bool IsYuvToRgbIsaSupported(YuvToRgbIsa isa) { return KernelsFor(isa) != nullptr && CpuSupports(isa); }
+
+YuvToRgbIsa ResolveYuvToRgbIsa(YuvToRgbIsa isa) {
+    static const YuvToRgbIsa best = DetectBestIsa();
+    return isa != YuvToRgbIsa::Auto && IsYuvToRgbIsaSupported(isa) ? isa : best;
+}
+
+const char *YuvToRgbIsaName(YuvToRgbIsa isa) {
+    switch (isa) {
+    case YuvToRgbIsa::Scalar:
+        return "scalar";
+    case YuvToRgbIsa::Sse41:
+        return "sse4.1";
+    case YuvToRgbIsa::Avx2:
+        return "avx2";
+    case YuvToRgbIsa::Neon:
+        return "neon";
+    default:
+        return "auto";
+    }
+}
+
+YuvToRgbOptions YuvToRgbOptionsForFrame(const AVFrame *frame) {
+    YuvToRgbOptions options;
+    if (!frame) {
+        return options;
+    }
+    if (frame->colorspace == AVCOL_SPC_BT709) {
+        options.matrix = YuvMatrix::BT709;
+    }
+    if (frame->color_range == AVCOL_RANGE_JPEG || frame->format == AV_PIX_FMT_YUVJ420P) {
+        options.range = YuvRange::Full;
+    }
+    return options;
+}
+
+bool ConvertYuvToRgb(const YuvPlanes &src, uint8_t *dst, int dstLinesize, RgbFormat dstFormat,
+                     const YuvToRgbOptions &options) {
+    bool planar = src.format == AV_PIX_FMT_YUV420P || src.format == AV_PIX_FMT_YUVJ420P;
+    if ((!planar && !IsSemiPlanar(src.format)) || src.width <= 0 || src.height <= 0 || !dst || !src.data[0] ||
+        !src.data[1] || (planar && !src.data[2]) || dstLinesize < src.width * RgbBytesPerPixel(dstFormat)) {
+        return false;
+    }
+
+    const YuvRowKernels *kernels = KernelsFor(ResolveYuvToRgbIsa(options.isa));
+    int formatIndex = static_cast<int>(dstFormat);
+    ConvertJob job;
+    job.src = &src;
+    job.dst = dst;
+    job.dstLinesize = dstLinesize;
+    job.row = planar ? kernels->planar[formatIndex] : kernels->semiPlanar[formatIndex];
+    job.coefficients = MakeCoefficients(options.matrix, options.range);
+
+    int threads = options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency());
+    int bandCount = std::min(threads, src.height / MIN_BAND_ROWS);
+    if (bandCount <= 1) {
+        ConvertRows(job, 0, src.height);
+        return true;
+    }
+
+    auto state = std::make_shared<BandState>();
+    state->job = job;
+    // 分块行数取偶数，使每个分块从色度行的起点开始
+    state->bandRows = ((src.height + bandCount - 1) / bandCount + 1) & ~1;
+    state->bandCount = (src.height + state->bandRows - 1) / state->bandRows;
+    for (int i = 1; i < state->bandCount; i++) {
+        StreamExecutor::shared().submit([state]() { RunBands(*state); }, StreamPriority::Normal);
+    }
+    RunBands(*state);
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state]() { return state->finishedBands == state->bandCount; });
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef COLOR_YUV_TO_RGB_H
+#define COLOR_YUV_TO_RGB_H
+
+#include <cstdint>
+
+struct AVFrame;
+
+// CPU上的YUV转RGB，供截图、分析和软件渲染等不经过GPU着色器的场景使用。
+// 输入为I420（YUV420P/YUVJ420P）、NV12或NV21，输出RGBA、BGRA或RGB24；
+// 按运行时检测到的指令集选择NEON、AVX2、SSE4.1或标量实现，各实现的结果逐字节一致。
+enum class RgbFormat {
+    RGBA,
+    BGRA,
+    RGB24,
+};
+
+// YUV到RGB的转换矩阵
+enum class YuvMatrix {
+    BT601,
+    BT709,
+};
+
+enum class YuvRange {
+    Limited, // Y取16-235，UV取16-240
+    Full,    // 0-255（JPEG）
+};
+
+// 转换实现，Auto选择当前CPU支持的最快实现
+enum class YuvToRgbIsa {
+    Auto,
+    Scalar,
+    Sse41,
+    Avx2,
+    Neon,
+};
+
+struct YuvToRgbOptions {
+    YuvMatrix matrix = YuvMatrix::BT601;
+    YuvRange range = YuvRange::Limited;
+    // 按行分块并行的线程数，分块在共享的StreamExecutor上执行，调用线程也参与；1只用调用线程，0按CPU核数
+    int threads = 1;
+    YuvToRgbIsa isa = YuvToRgbIsa::Auto; // 指定的实现不受支持时回退到可用的最快实现
+};
+
+// 源图像平面，format为AVPixelFormat。NV12/NV21时data[1]为交错的色度平面，data[2]不使用
+struct YuvPlanes {
+    const uint8_t *data[3];
+    int linesize[3];
+    int width;
+    int height;
+    int format;
+};
+
+// 转换整幅图像，dst至少dstLinesize * height字节；格式不支持或尺寸无效时返回false
+bool ConvertYuvToRgb(const YuvPlanes &src, uint8_t *dst, int dstLinesize, RgbFormat dstFormat,
+                     const YuvToRgbOptions &options);
+
+// 按帧携带的色彩空间和范围选择矩阵：BT.709以外按BT.601处理，YUVJ420P或JPEG范围为全范围
+YuvToRgbOptions YuvToRgbOptionsForFrame(const AVFrame *frame);
+
+int RgbBytesPerPixel(RgbFormat format);
+
+bool IsYuvToRgbIsaSupported(YuvToRgbIsa isa);
+
+// Auto解析为实际使用的实现
+YuvToRgbIsa ResolveYuvToRgbIsa(YuvToRgbIsa isa);
+
+const char *YuvToRgbIsaName(YuvToRgbIsa isa);
+
+#endif // COLOR_YUV_TO_RGB_H
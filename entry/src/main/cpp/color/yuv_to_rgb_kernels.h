@@ -0,0 +1,73 @@
+#ifndef COLOR_YUV_TO_RGB_KERNELS_H
+#define COLOR_YUV_TO_RGB_KERNELS_H
+
+#include "color/yuv_to_rgb.h"
+
+// 各指令集实现共用的定点系数和逐行转换接口，只在color/内部使用。
+//
+// 所有实现按同一套16位定点运算逐位复现，结果与标量实现一致：
+//   yTerm = (Y * yMul) >> 8                      Q6，yMul为Q14
+//   cTerm = (((C - 128) * k) >> 8) * 2           Q6，k为Q13（有限范围下B的系数超过2，Q14放不进int16）
+//   R = (yTerm + rTerm + bias) >> 6，G、B同理，最后饱和到0-255
+// SIMD中yTerm + rTerm可能超出int16，用饱和加法；饱和只发生在结果本来就大于255时，不影响输出。
+struct YuvCoefficients {
+    int16_t yMul;
+    int16_t bias; // 亮度偏移和舍入，Q6
+    int16_t crR;  // V对R
+    int16_t cbG;  // U对G（取正值，计算时减去）
+    int16_t crG;  // V对G（取正值，计算时减去）
+    int16_t cbB;  // U对B
+};
+
+// 转换一行。u、v为色度行中第一个样本的地址：I420时为各自平面，NV12/NV21时指向交错平面中的U、V字节
+using YuvRowFunction = void (*)(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst, int width,
+                                const YuvCoefficients &coefficients);
+
+const int RGB_FORMAT_COUNT = 3;
+
+struct YuvRowKernels {
+    YuvRowFunction planar[RGB_FORMAT_COUNT];     // I420
+    YuvRowFunction semiPlanar[RGB_FORMAT_COUNT]; // NV12/NV21
+};
+
+inline uint8_t ClampToByte(int value) { return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value)); }
+
+template <RgbFormat F> inline void StoreRgbPixel(uint8_t *dst, int r, int g, int b) {
+    if (F == RgbFormat::BGRA) {
+        dst[0] = ClampToByte(b);
+        dst[1] = ClampToByte(g);
+        dst[2] = ClampToByte(r);
+        dst[3] = 255;
+    } else {
+        dst[0] = ClampToByte(r);
+        dst[1] = ClampToByte(g);
+        dst[2] = ClampToByte(b);
+        if (F == RgbFormat::RGBA) {
+            dst[3] = 255;
+        }
+    }
+}
+
+// 标量参考实现，也用于SIMD实现处理行尾不足一组的像素；chromaStep为同一平面相邻色度样本的间距
+template <RgbFormat F>
+inline void ScalarYuvRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, int chromaStep, uint8_t *dst,
+                         int width, const YuvCoefficients &c) {
+    const int bytesPerPixel = F == RgbFormat::RGB24 ? 3 : 4;
+    for (int x = 0; x < width; x++) {
+        int chroma = (x >> 1) * chromaStep;
+        int cb = u[chroma] - 128;
+        int cr = v[chroma] - 128;
+        int yTerm = (y[x] * c.yMul) >> 8;
+        int r = yTerm + ((cr * c.crR) >> 8) * 2 + c.bias;
+        int g = yTerm - (((cb * c.cbG) >> 8) + ((cr * c.crG) >> 8)) * 2 + c.bias;
+        int b = yTerm + ((cb * c.cbB) >> 8) * 2 + c.bias;
+        StoreRgbPixel<F>(dst + x * bytesPerPixel, r >> 6, g >> 6, b >> 6);
+    }
+}
+
+// 指令集实现，未编译进当前架构时返回nullptr
+const YuvRowKernels *GetSse41YuvKernels();
+const YuvRowKernels *GetAvx2YuvKernels();
+const YuvRowKernels *GetNeonYuvKernels();
+
+#endif // COLOR_YUV_TO_RGB_KERNELS_H
@@ -0,0 +1,107 @@
+#include "color/yuv_to_rgb_kernels.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+
+namespace {
+// 只用ARMv7与AArch64共有的指令，arm64-v8a和armeabi-v7a共用同一份实现。
+// vqdmulhq_s16(a, b)为(2 * a * b) >> 16，输入取C << 7即与x86的_mm_mulhi_epi16(C << 8, b)逐位相同
+struct NeonChroma {
+    int16x8_t r;
+    int16x8_t g;
+    int16x8_t b;
+};
+
+// cb、cr为8个色度样本
+inline NeonChroma NeonChromaTerms(uint8x8_t cb, uint8x8_t cr, const YuvCoefficients &c) {
+    const int16x8_t center = vdupq_n_s16(128 << 7);
+    int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vshll_n_u8(cb, 7)), center);
+    int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vshll_n_u8(cr, 7)), center);
+    NeonChroma chroma;
+    chroma.r = vqdmulhq_s16(v, vdupq_n_s16(c.crR));
+    chroma.g = vaddq_s16(vqdmulhq_s16(u, vdupq_n_s16(c.cbG)), vqdmulhq_s16(v, vdupq_n_s16(c.crG)));
+    chroma.b = vqdmulhq_s16(u, vdupq_n_s16(c.cbB));
+    chroma.r = vaddq_s16(chroma.r, chroma.r);
+    chroma.g = vaddq_s16(chroma.g, chroma.g);
+    chroma.b = vaddq_s16(chroma.b, chroma.b);
+    return chroma;
+}
+
+inline uint8x8_t NeonCombine(int16x8_t yTerm, int16x8_t chroma, int16x8_t bias) {
+    return vqmovun_s16(vshrq_n_s16(vqaddq_s16(vqaddq_s16(yTerm, chroma), bias), 6));
+}
+
+inline uint8x8_t NeonCombineGreen(int16x8_t yTerm, int16x8_t chroma, int16x8_t bias) {
+    return vqmovun_s16(vshrq_n_s16(vaddq_s16(vsubq_s16(yTerm, chroma), bias), 6));
+}
+
+// 16个像素，chroma为其对应的8个色度样本
+template <RgbFormat F>
+inline void NeonConvert16(const uint8_t *y, const NeonChroma &chroma, const YuvCoefficients &c, uint8_t *dst) {
+    const int16x8_t yMul = vdupq_n_s16(c.yMul);
+    const int16x8_t bias = vdupq_n_s16(c.bias);
+    uint8x16_t luma = vld1q_u8(y);
+    int16x8_t y0 = vqdmulhq_s16(vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(luma), 7)), yMul);
+    int16x8_t y1 = vqdmulhq_s16(vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(luma), 7)), yMul);
+
+    // 每个色度样本对应水平相邻的两个像素
+    int16x8x2_t r = vzipq_s16(chroma.r, chroma.r);
+    int16x8x2_t g = vzipq_s16(chroma.g, chroma.g);
+    int16x8x2_t b = vzipq_s16(chroma.b, chroma.b);
+    uint8x16_t red = vcombine_u8(NeonCombine(y0, r.val[0], bias), NeonCombine(y1, r.val[1], bias));
+    uint8x16_t green = vcombine_u8(NeonCombineGreen(y0, g.val[0], bias), NeonCombineGreen(y1, g.val[1], bias));
+    uint8x16_t blue = vcombine_u8(NeonCombine(y0, b.val[0], bias), NeonCombine(y1, b.val[1], bias));
+
+    if (F == RgbFormat::RGB24) {
+        uint8x16x3_t pixels = {{red, green, blue}};
+        vst3q_u8(dst, pixels);
+    } else if (F == RgbFormat::BGRA) {
+        uint8x16x4_t pixels = {{blue, green, red, vdupq_n_u8(255)}};
+        vst4q_u8(dst, pixels);
+    } else {
+        uint8x16x4_t pixels = {{red, green, blue, vdupq_n_u8(255)}};
+        vst4q_u8(dst, pixels);
+    }
+}
+
+template <RgbFormat F>
+void NeonPlanarRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst, int width,
+                   const YuvCoefficients &c) {
+    const int bytesPerPixel = F == RgbFormat::RGB24 ? 3 : 4;
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        NeonConvert16<F>(y + x, NeonChromaTerms(vld1_u8(u + x / 2), vld1_u8(v + x / 2), c), c,
+                         dst + x * bytesPerPixel);
+    }
+    ScalarYuvRow<F>(y + x, u + x / 2, v + x / 2, 1, dst + x * bytesPerPixel, width - x, c);
+}
+
+template <RgbFormat F>
+void NeonSemiPlanarRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst, int width,
+                       const YuvCoefficients &c) {
+    const int bytesPerPixel = F == RgbFormat::RGB24 ? 3 : 4;
+    const uint8_t *interleaved = u < v ? u : v;
+    bool vFirst = v < u;
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        uint8x8x2_t pairs = vld2_u8(interleaved + x);
+        NeonChroma chroma = vFirst ? NeonChromaTerms(pairs.val[1], pairs.val[0], c)
+                                   : NeonChromaTerms(pairs.val[0], pairs.val[1], c);
+        NeonConvert16<F>(y + x, chroma, c, dst + x * bytesPerPixel);
+    }
+    ScalarYuvRow<F>(y + x, u + x, v + x, 2, dst + x * bytesPerPixel, width - x, c);
+}
+
+const YuvRowKernels NEON_KERNELS = {
+    {NeonPlanarRow<RgbFormat::RGBA>, NeonPlanarRow<RgbFormat::BGRA>, NeonPlanarRow<RgbFormat::RGB24>},
+    {NeonSemiPlanarRow<RgbFormat::RGBA>, NeonSemiPlanarRow<RgbFormat::BGRA>, NeonSemiPlanarRow<RgbFormat::RGB24>},
+};
+} // namespace
+
+const YuvRowKernels *GetNeonYuvKernels() { return &NEON_KERNELS; }
+
+#else
+
+const YuvRowKernels *GetNeonYuvKernels() { return nullptr; }
+
+#endif
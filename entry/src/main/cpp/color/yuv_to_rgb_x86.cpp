@@ -0,0 +1,256 @@
+#include "color/yuv_to_rgb_kernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+// 用函数级target属性编译SSE4.1/AVX2代码，不给整个文件加-mavx2，避免公共内联函数被编译成AVX2指令后在旧CPU上被链接使用
+#define SSE41_TARGET __attribute__((target("sse4.1")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+namespace {
+// 8个色度样本对应的R、G、B分量（Q6，已乘2）
+struct Sse41Chroma {
+    __m128i r;
+    __m128i g;
+    __m128i b;
+};
+
+// u、v为(C - 128) << 8的8个16位值
+SSE41_TARGET inline Sse41Chroma Sse41ChromaTerms(__m128i u, __m128i v, const YuvCoefficients &c) {
+    Sse41Chroma chroma;
+    chroma.r = _mm_mulhi_epi16(v, _mm_set1_epi16(c.crR));
+    chroma.g = _mm_add_epi16(_mm_mulhi_epi16(u, _mm_set1_epi16(c.cbG)), _mm_mulhi_epi16(v, _mm_set1_epi16(c.crG)));
+    chroma.b = _mm_mulhi_epi16(u, _mm_set1_epi16(c.cbB));
+    chroma.r = _mm_add_epi16(chroma.r, chroma.r);
+    chroma.g = _mm_add_epi16(chroma.g, chroma.g);
+    chroma.b = _mm_add_epi16(chroma.b, chroma.b);
+    return chroma;
+}
+
+// 8个像素：yTerm与各自的色度分量相加后右移并饱和到字节
+SSE41_TARGET inline void Sse41Combine(__m128i yTerm, __m128i r, __m128i g, __m128i b, __m128i bias, __m128i &rOut,
+                                      __m128i &gOut, __m128i &bOut) {
+    rOut = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(yTerm, r), bias), 6);
+    gOut = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(yTerm, g), bias), 6);
+    bOut = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(yTerm, b), bias), 6);
+}
+
+template <RgbFormat F> SSE41_TARGET inline void Sse41Store(uint8_t *dst, __m128i r, __m128i g, __m128i b) {
+    if (F == RgbFormat::BGRA) {
+        __m128i swap = r;
+        r = b;
+        b = swap;
+    }
+    const __m128i alpha = _mm_set1_epi8(-1);
+    __m128i rg0 = _mm_unpacklo_epi8(r, g);
+    __m128i rg1 = _mm_unpackhi_epi8(r, g);
+    __m128i ba0 = _mm_unpacklo_epi8(b, alpha);
+    __m128i ba1 = _mm_unpackhi_epi8(b, alpha);
+    __m128i rgba0 = _mm_unpacklo_epi16(rg0, ba0);
+    __m128i rgba1 = _mm_unpackhi_epi16(rg0, ba0);
+    __m128i rgba2 = _mm_unpacklo_epi16(rg1, ba1);
+    __m128i rgba3 = _mm_unpackhi_epi16(rg1, ba1);
+    if (F == RgbFormat::RGB24) {
+        // 每4个像素去掉alpha得到12字节，再拼接成3个16字节
+        const __m128i dropAlpha = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+        rgba0 = _mm_shuffle_epi8(rgba0, dropAlpha);
+        rgba1 = _mm_shuffle_epi8(rgba1, dropAlpha);
+        rgba2 = _mm_shuffle_epi8(rgba2, dropAlpha);
+        rgba3 = _mm_shuffle_epi8(rgba3, dropAlpha);
+        __m128i *out = reinterpret_cast<__m128i *>(dst);
+        _mm_storeu_si128(out, _mm_or_si128(rgba0, _mm_slli_si128(rgba1, 12)));
+        _mm_storeu_si128(out + 1, _mm_or_si128(_mm_srli_si128(rgba1, 4), _mm_slli_si128(rgba2, 8)));
+        _mm_storeu_si128(out + 2, _mm_or_si128(_mm_srli_si128(rgba2, 8), _mm_slli_si128(rgba3, 4)));
+        return;
+    }
+    __m128i *out = reinterpret_cast<__m128i *>(dst);
+    _mm_storeu_si128(out, rgba0);
+    _mm_storeu_si128(out + 1, rgba1);
+    _mm_storeu_si128(out + 2, rgba2);
+    _mm_storeu_si128(out + 3, rgba3);
+}
+
+// 16个像素，chroma为其对应的8个色度样本
+template <RgbFormat F>
+SSE41_TARGET inline void Sse41Convert16(const uint8_t *y, const Sse41Chroma &chroma, const YuvCoefficients &c,
+                                        uint8_t *dst) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i yMul = _mm_set1_epi16(c.yMul);
+    const __m128i bias = _mm_set1_epi16(c.bias);
+    __m128i luma = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y));
+    __m128i y0 = _mm_mulhi_epu16(_mm_unpacklo_epi8(zero, luma), yMul);
+    __m128i y1 = _mm_mulhi_epu16(_mm_unpackhi_epi8(zero, luma), yMul);
+
+    // 每个色度样本对应水平相邻的两个像素
+    __m128i r0, g0, b0, r1, g1, b1;
+    Sse41Combine(y0, _mm_unpacklo_epi16(chroma.r, chroma.r), _mm_unpacklo_epi16(chroma.g, chroma.g),
+                 _mm_unpacklo_epi16(chroma.b, chroma.b), bias, r0, g0, b0);
+    Sse41Combine(y1, _mm_unpackhi_epi16(chroma.r, chroma.r), _mm_unpackhi_epi16(chroma.g, chroma.g),
+                 _mm_unpackhi_epi16(chroma.b, chroma.b), bias, r1, g1, b1);
+    Sse41Store<F>(dst, _mm_packus_epi16(r0, r1), _mm_packus_epi16(g0, g1), _mm_packus_epi16(b0, b1));
+}
+
+template <RgbFormat F>
+SSE41_TARGET void Sse41PlanarRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst, int width,
+                                 const YuvCoefficients &c) {
+    const int bytesPerPixel = F == RgbFormat::RGB24 ? 3 : 4;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i signFlip = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        // (C << 8) ^ 0x8000即(C - 128) << 8
+        __m128i cb = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(u + x / 2));
+        __m128i cr = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(v + x / 2));
+        cb = _mm_xor_si128(_mm_unpacklo_epi8(zero, cb), signFlip);
+        cr = _mm_xor_si128(_mm_unpacklo_epi8(zero, cr), signFlip);
+        Sse41Convert16<F>(y + x, Sse41ChromaTerms(cb, cr, c), c, dst + x * bytesPerPixel);
+    }
+    ScalarYuvRow<F>(y + x, u + x / 2, v + x / 2, 1, dst + x * bytesPerPixel, width - x, c);
+}
+
+template <RgbFormat F>
+SSE41_TARGET void Sse41SemiPlanarRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst, int width,
+                                     const YuvCoefficients &c) {
+    const int bytesPerPixel = F == RgbFormat::RGB24 ? 3 : 4;
+    const __m128i highByte = _mm_set1_epi16(static_cast<int16_t>(0xFF00));
+    const __m128i signFlip = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+    const uint8_t *interleaved = u < v ? u : v;
+    bool vFirst = v < u;
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        // 交错平面每16位中低字节在前：低字节左移8位、高字节屏蔽低8位，即得到两个分量的C << 8
+        __m128i pairs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(interleaved + x));
+        __m128i first = _mm_xor_si128(_mm_slli_epi16(pairs, 8), signFlip);
+        __m128i second = _mm_xor_si128(_mm_and_si128(pairs, highByte), signFlip);
+        Sse41Chroma chroma = vFirst ? Sse41ChromaTerms(second, first, c) : Sse41ChromaTerms(first, second, c);
+        Sse41Convert16<F>(y + x, chroma, c, dst + x * bytesPerPixel);
+    }
+    ScalarYuvRow<F>(y + x, u + x, v + x, 2, dst + x * bytesPerPixel, width - x, c);
+}
+
+// AVX2：一次32个像素，按128位通道分别运算，存储时再把两个通道的结果按像素顺序重排
+struct Avx2Chroma {
+    __m256i r;
+    __m256i g;
+    __m256i b;
+};
+
+AVX2_TARGET inline Avx2Chroma Avx2ChromaTerms(__m256i u, __m256i v, const YuvCoefficients &c) {
+    Avx2Chroma chroma;
+    chroma.r = _mm256_mulhi_epi16(v, _mm256_set1_epi16(c.crR));
+    chroma.g = _mm256_add_epi16(_mm256_mulhi_epi16(u, _mm256_set1_epi16(c.cbG)),
+                                _mm256_mulhi_epi16(v, _mm256_set1_epi16(c.crG)));
+    chroma.b = _mm256_mulhi_epi16(u, _mm256_set1_epi16(c.cbB));
+    chroma.r = _mm256_add_epi16(chroma.r, chroma.r);
+    chroma.g = _mm256_add_epi16(chroma.g, chroma.g);
+    chroma.b = _mm256_add_epi16(chroma.b, chroma.b);
+    return chroma;
+}
+
+AVX2_TARGET inline void Avx2Combine(__m256i yTerm, __m256i r, __m256i g, __m256i b, __m256i bias, __m256i &rOut,
+                                    __m256i &gOut, __m256i &bOut) {
+    rOut = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(yTerm, r), bias), 6);
+    gOut = _mm256_srai_epi16(_mm256_add_epi16(_mm256_sub_epi16(yTerm, g), bias), 6);
+    bOut = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(yTerm, b), bias), 6);
+}
+
+// 32个像素，chroma为按顺序排列的16个色度样本。
+// 亮度按通道解包后y0为像素0-7|16-23、y1为8-15|24-31，色度按通道复制后恰好与之对应，
+// 打包回字节后每个通道内即为连续的16个像素
+template <RgbFormat F>
+AVX2_TARGET inline void Avx2Convert32(const uint8_t *y, const Avx2Chroma &chroma, const YuvCoefficients &c,
+                                      uint8_t *dst) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i yMul = _mm256_set1_epi16(c.yMul);
+    const __m256i bias = _mm256_set1_epi16(c.bias);
+    __m256i luma = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y));
+    __m256i y0 = _mm256_mulhi_epu16(_mm256_unpacklo_epi8(zero, luma), yMul);
+    __m256i y1 = _mm256_mulhi_epu16(_mm256_unpackhi_epi8(zero, luma), yMul);
+
+    __m256i r0, g0, b0, r1, g1, b1;
+    Avx2Combine(y0, _mm256_unpacklo_epi16(chroma.r, chroma.r), _mm256_unpacklo_epi16(chroma.g, chroma.g),
+                _mm256_unpacklo_epi16(chroma.b, chroma.b), bias, r0, g0, b0);
+    Avx2Combine(y1, _mm256_unpackhi_epi16(chroma.r, chroma.r), _mm256_unpackhi_epi16(chroma.g, chroma.g),
+                _mm256_unpackhi_epi16(chroma.b, chroma.b), bias, r1, g1, b1);
+    __m256i r = _mm256_packus_epi16(r0, r1);
+    __m256i g = _mm256_packus_epi16(g0, g1);
+    __m256i b = _mm256_packus_epi16(b0, b1);
+    if (F == RgbFormat::BGRA) {
+        __m256i swap = r;
+        r = b;
+        b = swap;
+    }
+
+    // 交错后各寄存器为像素0-3|16-19、4-7|20-23、8-11|24-27、12-15|28-31
+    const __m256i alpha = _mm256_set1_epi8(-1);
+    __m256i rg0 = _mm256_unpacklo_epi8(r, g);
+    __m256i rg1 = _mm256_unpackhi_epi8(r, g);
+    __m256i ba0 = _mm256_unpacklo_epi8(b, alpha);
+    __m256i ba1 = _mm256_unpackhi_epi8(b, alpha);
+    __m256i rgba0 = _mm256_unpacklo_epi16(rg0, ba0);
+    __m256i rgba1 = _mm256_unpackhi_epi16(rg0, ba0);
+    __m256i rgba2 = _mm256_unpacklo_epi16(rg1, ba1);
+    __m256i rgba3 = _mm256_unpackhi_epi16(rg1, ba1);
+    __m256i *out = reinterpret_cast<__m256i *>(dst);
+    _mm256_storeu_si256(out, _mm256_permute2x128_si256(rgba0, rgba1, 0x20));
+    _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(rgba2, rgba3, 0x20));
+    _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(rgba0, rgba1, 0x31));
+    _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(rgba2, rgba3, 0x31));
+}
+
+template <RgbFormat F>
+AVX2_TARGET void Avx2PlanarRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst, int width,
+                               const YuvCoefficients &c) {
+    const __m256i signFlip = _mm256_set1_epi16(static_cast<int16_t>(0x8000));
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i cb = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(u + x / 2)));
+        __m256i cr = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(v + x / 2)));
+        cb = _mm256_xor_si256(_mm256_slli_epi16(cb, 8), signFlip);
+        cr = _mm256_xor_si256(_mm256_slli_epi16(cr, 8), signFlip);
+        Avx2Convert32<F>(y + x, Avx2ChromaTerms(cb, cr, c), c, dst + x * 4);
+    }
+    Sse41PlanarRow<F>(y + x, u + x / 2, v + x / 2, dst + x * 4, width - x, c);
+}
+
+template <RgbFormat F>
+AVX2_TARGET void Avx2SemiPlanarRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, uint8_t *dst, int width,
+                                   const YuvCoefficients &c) {
+    const __m256i highByte = _mm256_set1_epi16(static_cast<int16_t>(0xFF00));
+    const __m256i signFlip = _mm256_set1_epi16(static_cast<int16_t>(0x8000));
+    const uint8_t *interleaved = u < v ? u : v;
+    bool vFirst = v < u;
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i pairs = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(interleaved + x));
+        __m256i first = _mm256_xor_si256(_mm256_slli_epi16(pairs, 8), signFlip);
+        __m256i second = _mm256_xor_si256(_mm256_and_si256(pairs, highByte), signFlip);
+        Avx2Chroma chroma = vFirst ? Avx2ChromaTerms(second, first, c) : Avx2ChromaTerms(first, second, c);
+        Avx2Convert32<F>(y + x, chroma, c, dst + x * 4);
+    }
+    Sse41SemiPlanarRow<F>(y + x, u + x, v + x, dst + x * 4, width - x, c);
+}
+
+const YuvRowKernels SSE41_KERNELS = {
+    {Sse41PlanarRow<RgbFormat::RGBA>, Sse41PlanarRow<RgbFormat::BGRA>, Sse41PlanarRow<RgbFormat::RGB24>},
+    {Sse41SemiPlanarRow<RgbFormat::RGBA>, Sse41SemiPlanarRow<RgbFormat::BGRA>, Sse41SemiPlanarRow<RgbFormat::RGB24>},
+};
+
+// RGB24的三字节交错在256位寄存器上需要跨通道重排，收益不大，沿用SSE4.1实现
+const YuvRowKernels AVX2_KERNELS = {
+    {Avx2PlanarRow<RgbFormat::RGBA>, Avx2PlanarRow<RgbFormat::BGRA>, Sse41PlanarRow<RgbFormat::RGB24>},
+    {Avx2SemiPlanarRow<RgbFormat::RGBA>, Avx2SemiPlanarRow<RgbFormat::BGRA>, Sse41SemiPlanarRow<RgbFormat::RGB24>},
+};
+} // namespace
+
+const YuvRowKernels *GetSse41YuvKernels() { return &SSE41_KERNELS; }
+
+const YuvRowKernels *GetAvx2YuvKernels() { return &AVX2_KERNELS; }
+
+#else
+
+const YuvRowKernels *GetSse41YuvKernels() { return nullptr; }
+
+const YuvRowKernels *GetAvx2YuvKernels() { return nullptr; }
+
+#endif
@@ -0,0 +1,45 @@
+//
+// Created on 2026/10/17.
+//
+// Node APIs are not fully supported. To solve the compilation error of the interface cannot be found,
+// please include "napi/native_api.h".
+
+#ifndef ARKUI_DEMO_FRAME_LOG_H
+#define ARKUI_DEMO_FRAME_LOG_H
+
+#include <atomic>
+#include "common/log.h"
+
+// 逐帧日志开关。
+// 编译期：FRAME_LOG_ENABLED为0时FRAME_LOG的条件恒为假，调用及其参数求值都会被编译器消除；
+// 运行期：默认关闭，SetLevel()打开后输出不低于该级别的逐帧日志，关闭时只多一次relaxed原子读。
+// 逐帧的统计改用原子计数器，由各模块定期输出汇总日志。
+#ifndef FRAME_LOG_ENABLED
+#ifdef NDEBUG
+#define FRAME_LOG_ENABLED 0
+#else
+#define FRAME_LOG_ENABLED 1
+#endif
+#endif
+
+namespace FrameLog {
+const int LEVEL_OFF = LOG_FATAL + 1;
+
+inline std::atomic<int> &Level() {
+    static std::atomic<int> level{LEVEL_OFF};
+    return level;
+}
+
+inline void SetLevel(int level) { Level().store(level, std::memory_order_relaxed); }
+
+inline bool IsEnabled(int level) { return level >= Level().load(std::memory_order_relaxed); }
+} // namespace FrameLog
+
+#define FRAME_LOG(type, level, domain, tag, ...)                                                                      \
+    do {                                                                                                               \
+        if (FRAME_LOG_ENABLED && FrameLog::IsEnabled(level)) {                                                         \
+            OH_LOG_Print(type, level, domain, tag, __VA_ARGS__);                                                       \
+        }                                                                                                              \
+    } while (0)
+
+#endif // ARKUI_DEMO_FRAME_LOG_H
@@ -0,0 +1,65 @@
+#include "common/log.h"
+
+#ifndef __OHOS__
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+
+namespace {
+std::atomic<int> g_minLevel{LOG_INFO};
+
+const char *LevelName(LogLevel level) {
+    switch (level) {
+    case LOG_DEBUG:
+        return "D";
+    case LOG_INFO:
+        return "I";
+    case LOG_WARN:
+        return "W";
+    case LOG_ERROR:
+        return "E";
+    default:
+        return "F";
+    }
+}
+
+// hilog的格式串在%后可带{public}/{private}，去掉后即为printf格式
+std::string StripPrivacyFlags(const char *fmt) {
+    std::string format;
+    for (const char *p = fmt; *p; p++) {
+        format += *p;
+        if (*p != '%') {
+            continue;
+        }
+        if (p[1] == '%') {
+            format += *++p;
+        } else if (p[1] == '{') {
+            while (*p && *p != '}') {
+                p++;
+            }
+            if (!*p) {
+                break;
+            }
+        }
+    }
+    return format;
+}
+} // namespace
+
+void HostLogSetLevel(LogLevel level) { g_minLevel.store(level, std::memory_order_relaxed); }
+
+int OH_LOG_Print(LogType, LogLevel level, unsigned int, const char *tag, const char *fmt, ...) {
+    if (level < g_minLevel.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    std::string format = StripPrivacyFlags(fmt);
+    char message[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), format.c_str(), args);
+    va_end(args);
+    // 一次写出整行，避免多线程日志交错
+    return fprintf(stderr, "%s/%s: %s\n", LevelName(level), tag ? tag : "", message);
+}
+#endif // __OHOS__
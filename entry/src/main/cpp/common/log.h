@@ -0,0 +1,42 @@
+//
+// Created on 2026/10/17.
+//
+// Node APIs are not fully supported. To solve the compilation error of the interface cannot be found,
+// please include "napi/native_api.h".
+
+#ifndef ARKUI_DEMO_LOG_H
+#define ARKUI_DEMO_LOG_H
+
+// 日志适配层。拉流和解码核心只通过本头文件记录日志：
+// OHOS构建直接使用hilog；主机构建（如基准测试）提供同名的类型和宏，由common/host_log.cpp输出到stderr。
+#ifdef __OHOS__
+#include <hilog/log.h>
+#else
+
+typedef enum {
+    LOG_APP = 0,
+} LogType;
+
+typedef enum {
+    LOG_DEBUG = 3,
+    LOG_INFO = 4,
+    LOG_WARN = 5,
+    LOG_ERROR = 6,
+    LOG_FATAL = 7,
+} LogLevel;
+
+// 与hilog同签名，格式串中的{public}/{private}修饰会被去掉
+int OH_LOG_Print(LogType type, LogLevel level, unsigned int domain, const char *tag, const char *fmt, ...);
+
+// 低于该级别的日志不输出，默认LOG_INFO
+void HostLogSetLevel(LogLevel level);
+
+#define OH_LOG_DEBUG(type, ...) ((void)OH_LOG_Print((type), LOG_DEBUG, LOG_DOMAIN, LOG_TAG, __VA_ARGS__))
+#define OH_LOG_INFO(type, ...) ((void)OH_LOG_Print((type), LOG_INFO, LOG_DOMAIN, LOG_TAG, __VA_ARGS__))
+#define OH_LOG_WARN(type, ...) ((void)OH_LOG_Print((type), LOG_WARN, LOG_DOMAIN, LOG_TAG, __VA_ARGS__))
+#define OH_LOG_ERROR(type, ...) ((void)OH_LOG_Print((type), LOG_ERROR, LOG_DOMAIN, LOG_TAG, __VA_ARGS__))
+#define OH_LOG_FATAL(type, ...) ((void)OH_LOG_Print((type), LOG_FATAL, LOG_DOMAIN, LOG_TAG, __VA_ARGS__))
+
+#endif // __OHOS__
+
+#endif // ARKUI_DEMO_LOG_H
@@ -0,0 +1,68 @@
+//
+// Created on 2026/10/17.
+//
+// Node APIs are not fully supported. To solve the compilation error of the interface cannot be found,
+// please include "napi/native_api.h".
+
+#ifndef ARKUI_DEMO_SPSC_QUEUE_H
+#define ARKUI_DEMO_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * Bounded single-producer/single-consumer ring buffer.
+ * tryPush must only be called from one thread and tryPop from one (other) thread; size() may be read anywhere.
+ */
+template <typename T> class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : capacity_(capacity > 0 ? capacity : 1), slots_(capacity_ + 1), head_(0), tail_(0) {}
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // 生产者：队列已满时返回false，item保持不变
+    bool tryPush(T &&item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t next = increment(tail);
+        if (next == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots_[tail] = std::move(item);
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者：队列为空时返回false
+    bool tryPop(T &item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(slots_[head]);
+        head_.store(increment(head), std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail >= head ? tail - head : tail + slots_.size() - head;
+    }
+
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size() == 0; }
+
+private:
+    size_t increment(size_t index) const { return index + 1 == slots_.size() ? 0 : index + 1; }
+
+    const size_t capacity_;
+    std::vector<T> slots_;
+    alignas(64) std::atomic<size_t> head_; // 仅消费者写
+    alignas(64) std::atomic<size_t> tail_; // 仅生产者写
+};
+
+#endif // ARKUI_DEMO_SPSC_QUEUE_H
@@ -0,0 +1,112 @@
+#include "decoder_backend.h"
+#include "common/log.h"
+
+extern "C" {
+#include <libavutil/hwcontext.h>
+}
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "DecoderBackend"
+
+namespace {
+// 纯软件解码，不依赖任何平台加速能力
+class SoftwareDecoderBackend : public DecoderBackend {
+public:
+    const char *name() const override { return "software"; }
+    bool isHardware() const override { return false; }
+    bool configure(AVCodecContext *) override { return true; }
+    int transfer(AVFrame *) override { return 0; }
+};
+
+// 基于AVHWDeviceContext的硬件解码：解码在设备上完成，输出帧下载到内存后交给渲染端
+class HwDeviceDecoderBackend : public DecoderBackend {
+public:
+    HwDeviceDecoderBackend(AVBufferRef *deviceContext, AVHWDeviceType type, AVPixelFormat hwFormat)
+        : deviceContext_(deviceContext), type_(type), hwFormat_(hwFormat), softwareFrame_(av_frame_alloc()) {}
+
+    ~HwDeviceDecoderBackend() override {
+        av_frame_free(&softwareFrame_);
+        av_buffer_unref(&deviceContext_);
+    }
+
+    const char *name() const override { return av_hwdevice_get_type_name(type_); }
+    bool isHardware() const override { return true; }
+
+    bool configure(AVCodecContext *context) override {
+        // 设置hw_device_ctx后默认的get_format优先选择该设备的硬件格式
+        context->hw_device_ctx = av_buffer_ref(deviceContext_);
+        return context->hw_device_ctx != nullptr;
+    }
+
+    int transfer(AVFrame *frame) override {
+        // 硬件加速初始化失败或当前profile不受支持时libavcodec已改选软件格式，按出错处理以便如实回退和上报
+        if (frame->format != hwFormat_) {
+            return AVERROR(ENOSYS);
+        }
+        if (!softwareFrame_) {
+            return AVERROR(ENOMEM);
+        }
+        // 渲染端直接支持NV12，设备不支持时由FFmpeg选择首个可下载的格式
+        softwareFrame_->format = AV_PIX_FMT_NV12;
+        int ret = av_hwframe_transfer_data(softwareFrame_, frame, 0);
+        if (ret < 0) {
+            av_frame_unref(softwareFrame_);
+            ret = av_hwframe_transfer_data(softwareFrame_, frame, 0);
+        }
+        if (ret >= 0) {
+            ret = av_frame_copy_props(softwareFrame_, frame);
+        }
+        if (ret < 0) {
+            av_frame_unref(softwareFrame_);
+            return ret;
+        }
+        av_frame_unref(frame);
+        av_frame_move_ref(frame, softwareFrame_);
+        return 0;
+    }
+
+private:
+    AVBufferRef *deviceContext_;
+    AVHWDeviceType type_;
+    AVPixelFormat hwFormat_;
+    AVFrame *softwareFrame_; // 下载用的临时帧，避免逐帧分配AVFrame结构
+};
+
+std::unique_ptr<DecoderBackend> CreateHwDeviceBackend(const AVCodec *codec) {
+    for (int i = 0;; i++) {
+        const AVCodecHWConfig *config = avcodec_get_hw_config(codec, i);
+        if (!config) {
+            break;
+        }
+        if (!(config->methods & AV_CODEC_HW_CONFIG_METHOD_HW_DEVICE_CTX)) {
+            continue;
+        }
+        AVBufferRef *deviceContext = nullptr;
+        int ret = av_hwdevice_ctx_create(&deviceContext, config->device_type, nullptr, nullptr, 0);
+        const char *typeName = av_hwdevice_get_type_name(config->device_type);
+        if (ret < 0) {
+            char error_str[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, error_str, AV_ERROR_MAX_STRING_SIZE);
+            OH_LOG_INFO(LOG_APP, "Hardware device %{public}s unavailable: %{public}s", typeName ? typeName : "unknown",
+                        error_str);
+            continue;
+        }
+        OH_LOG_INFO(LOG_APP, "Using hardware device %{public}s for %{public}s", typeName ? typeName : "unknown",
+                    codec->name);
+        return std::make_unique<HwDeviceDecoderBackend>(deviceContext, config->device_type, config->pix_fmt);
+    }
+    return nullptr;
+}
+} // namespace
+
+std::unique_ptr<DecoderBackend> CreateDecoderBackend(DecoderBackendMode mode, const AVCodec *codec) {
+    if (mode == DecoderBackendMode::Auto && codec) {
+        std::unique_ptr<DecoderBackend> backend = CreateHwDeviceBackend(codec);
+        if (backend) {
+            return backend;
+        }
+    }
+    return std::make_unique<SoftwareDecoderBackend>();
+}
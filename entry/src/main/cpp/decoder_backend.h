@@ -0,0 +1,40 @@
+#ifndef DECODER_BACKEND_H
+#define DECODER_BACKEND_H
+
+#include <functional>
+#include <memory>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 解码后端选择
+enum class DecoderBackendMode {
+    Auto,     // 平台提供可用的硬件解码设备时优先使用，不可用或出错时回退软件解码
+    Software, // 始终软件解码
+};
+
+// 解码后端。打开解码器前配置解码器上下文，解码后把输出帧转换为渲染端可直接上传的内存帧。
+// 同一时刻只由一个解码线程调用。
+class DecoderBackend {
+public:
+    virtual ~DecoderBackend() = default;
+
+    // 后端名称："software"或硬件设备类型名，如"vaapi"
+    virtual const char *name() const = 0;
+    virtual bool isHardware() const = 0;
+
+    // 在avcodec_open2之前调用，须在FramePool::attach之后
+    virtual bool configure(AVCodecContext *context) = 0;
+
+    // 硬件帧就地替换为下载到内存的帧，内存帧原样保留。返回负值表示后端出错，需要回退软件解码
+    virtual int transfer(AVFrame *frame) = 0;
+};
+
+// 按模式创建解码后端：Auto依次尝试解码器声明支持的硬件设备类型，全部不可用时返回软件后端
+std::unique_ptr<DecoderBackend> CreateDecoderBackend(DecoderBackendMode mode, const AVCodec *codec);
+
+// 按解码器创建后端，替代CreateDecoderBackend选择首选后端，如在测试中注入会出错的后端
+using DecoderBackendFactory = std::function<std::unique_ptr<DecoderBackend>(const AVCodec *codec)>;
+
+#endif // DECODER_BACKEND_H
@@ -0,0 +1,225 @@
+#include "frame_pool.h"
+#include "common/log.h"
+#include <cstdlib>
+#include <new>
+
+extern "C" {
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "FramePool"
+
+namespace {
+// 缓冲区、行大小和平面起始地址的对齐字节数
+const size_t BUFFER_ALIGNMENT = 64;
+
+// 每隔多少次分配按高水位线裁剪一次空闲缓冲区
+const uint64_t TRIM_INTERVAL = 256;
+
+size_t AlignUp(size_t value, size_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+} // namespace
+
+FramePool *FramePool::create() { return new FramePool(); }
+
+FramePool::FramePool()
+    : refCount_(1), bufferSize_(0), outstanding_(0), highWaterMark_(0), acquireCount_(0), hits_(0), misses_(0) {}
+
+FramePool::~FramePool() {
+    for (Block *block : freeBlocks_) {
+        freeBlock(block);
+    }
+    freeBlocks_.clear();
+}
+
+void FramePool::release() { unref(); }
+
+void FramePool::unref() {
+    if (refCount_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+void FramePool::attach(AVCodecContext *context) {
+    context->opaque = this;
+    context->get_buffer2 = &FramePool::getBuffer2;
+}
+
+FramePoolStats FramePool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FramePoolStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.bufferSize = bufferSize_;
+    stats.pooledBuffers = freeBlocks_.size();
+    stats.outstandingBuffers = outstanding_;
+    return stats;
+}
+
+int FramePool::getBuffer2(AVCodecContext *context, AVFrame *frame, int flags) {
+    FramePool *pool = static_cast<FramePool *>(context->opaque);
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+
+    // 硬件帧、调色板格式或不支持直接渲染的解码器走默认分配
+    if (!pool || !desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL)) ||
+        !(context->codec->capabilities & AV_CODEC_CAP_DR1)) {
+        return avcodec_default_get_buffer2(context, frame, flags);
+    }
+
+    int width = frame->width;
+    int height = frame->height;
+    int linesizeAlign[AV_NUM_DATA_POINTERS];
+    avcodec_align_dimensions2(context, &width, &height, linesizeAlign);
+
+    // 与libavcodec默认分配器一致：逐步放大宽度直到所有平面的行大小都满足对齐，保持各平面行大小的比例关系
+    AVPixelFormat format = static_cast<AVPixelFormat>(frame->format);
+    int linesizes[4] = {0};
+    bool unaligned = true;
+    int alignedWidth = width;
+    while (unaligned) {
+        if (av_image_fill_linesizes(linesizes, format, alignedWidth) < 0) {
+            return avcodec_default_get_buffer2(context, frame, flags);
+        }
+        alignedWidth += alignedWidth & ~(alignedWidth - 1);
+        unaligned = false;
+        for (int i = 0; i < 4; i++) {
+            unaligned |= (linesizes[i] % BUFFER_ALIGNMENT) != 0;
+        }
+    }
+
+    ptrdiff_t strides[4];
+    for (int i = 0; i < 4; i++) {
+        strides[i] = linesizes[i];
+    }
+    size_t planeSizes[4] = {0};
+    if (av_image_fill_plane_sizes(planeSizes, format, height, strides) < 0) {
+        return avcodec_default_get_buffer2(context, frame, flags);
+    }
+
+    // 每个平面起始地址64字节对齐，并在末尾预留对齐余量供SIMD越界读写
+    size_t totalSize = 0;
+    for (int i = 0; i < 4; i++) {
+        if (planeSizes[i] > 0) {
+            totalSize += AlignUp(planeSizes[i] + BUFFER_ALIGNMENT, BUFFER_ALIGNMENT);
+        }
+    }
+
+    Block *block = pool->acquire(totalSize);
+    if (!block) {
+        return AVERROR(ENOMEM);
+    }
+
+    frame->buf[0] = av_buffer_create(block->data, block->size, &FramePool::returnBuffer, block, 0);
+    if (!frame->buf[0]) {
+        pool->recycle(block);
+        return AVERROR(ENOMEM);
+    }
+
+    size_t offset = 0;
+    for (int i = 0; i < 4; i++) {
+        if (planeSizes[i] == 0) {
+            break;
+        }
+        frame->data[i] = block->data + offset;
+        frame->linesize[i] = linesizes[i];
+        offset += AlignUp(planeSizes[i] + BUFFER_ALIGNMENT, BUFFER_ALIGNMENT);
+    }
+    frame->extended_data = frame->data;
+    return 0;
+}
+
+void FramePool::returnBuffer(void *opaque, uint8_t * /* data */) {
+    Block *block = static_cast<Block *>(opaque);
+    block->pool->recycle(block);
+}
+
+FramePool::Block *FramePool::acquire(size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // 分辨率变化：旧尺寸的空闲缓冲区不再有用
+        if (size != bufferSize_) {
+            if (bufferSize_ != 0) {
+                OH_LOG_INFO(LOG_APP, "Buffer size changed %{public}zu -> %{public}zu, dropping %{public}zu buffers",
+                            bufferSize_, size, freeBlocks_.size());
+            }
+            for (Block *block : freeBlocks_) {
+                freeBlock(block);
+            }
+            freeBlocks_.clear();
+            bufferSize_ = size;
+            highWaterMark_ = 0;
+        }
+
+        acquireCount_++;
+        outstanding_++;
+        if (outstanding_ > highWaterMark_) {
+            highWaterMark_ = outstanding_;
+        }
+        if (acquireCount_ % TRIM_INTERVAL == 0) {
+            trim();
+        }
+
+        if (!freeBlocks_.empty()) {
+            Block *block = freeBlocks_.back();
+            freeBlocks_.pop_back();
+            hits_++;
+            refCount_.fetch_add(1, std::memory_order_relaxed);
+            return block;
+        }
+        misses_++;
+    }
+
+    // 未命中时在锁外分配
+    Block *block = new (std::nothrow) Block{this, nullptr, size};
+    void *memory = nullptr;
+    if (!block || posix_memalign(&memory, BUFFER_ALIGNMENT, size) != 0) {
+        delete block;
+        std::lock_guard<std::mutex> lock(mutex_);
+        outstanding_--;
+        return nullptr;
+    }
+    block->data = static_cast<uint8_t *>(memory);
+    refCount_.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+void FramePool::recycle(Block *block) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        outstanding_--;
+        if (block->size == bufferSize_) {
+            freeBlocks_.push_back(block);
+            block = nullptr;
+        }
+    }
+    if (block) {
+        freeBlock(block);
+    }
+    // 每个在外的缓冲区都持有池的一个引用
+    unref();
+}
+
+void FramePool::trim() {
+    // 空闲缓冲区数量不超过近期占用峰值与当前占用之差
+    size_t keep = highWaterMark_ > outstanding_ ? highWaterMark_ - outstanding_ : 0;
+    size_t trimmed = 0;
+    while (freeBlocks_.size() > keep) {
+        freeBlock(freeBlocks_.back());
+        freeBlocks_.pop_back();
+        trimmed++;
+    }
+    if (trimmed > 0) {
+        OH_LOG_INFO(LOG_APP, "Trimmed %{public}zu idle buffers, high water mark %{public}zu", trimmed,
+                    highWaterMark_);
+    }
+    highWaterMark_ = outstanding_;
+}
+
+void FramePool::freeBlock(Block *block) {
+    free(block->data);
+    delete block;
+}
@@ -0,0 +1,66 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 帧缓冲池统计
+struct FramePoolStats {
+    uint64_t hits = 0;             // 从池中复用的次数
+    uint64_t misses = 0;           // 新分配的次数
+    size_t bufferSize = 0;         // 当前分辨率对应的单帧缓冲区大小
+    size_t pooledBuffers = 0;      // 空闲缓冲区数量
+    size_t outstandingBuffers = 0; // 被帧引用中的缓冲区数量
+};
+
+// 解码输出帧缓冲池。
+// 通过get_buffer2接管解码器的图像分配：同一分辨率的帧缓冲区（64字节对齐）在帧释放后回收复用，
+// 分辨率变化时丢弃旧尺寸缓冲区，并按近期占用的高水位线定期裁剪空闲缓冲区。
+// 池对象带引用计数，仍被帧引用的缓冲区会让池在release()之后继续存活直到全部归还。
+class FramePool {
+public:
+    static FramePool *create();
+    void release();
+
+    // 安装到解码器上下文，须在avcodec_open2之前调用
+    void attach(AVCodecContext *context);
+
+    FramePoolStats getStats() const;
+
+private:
+    struct Block {
+        FramePool *pool;
+        uint8_t *data;
+        size_t size;
+    };
+
+    FramePool();
+    ~FramePool();
+
+    static int getBuffer2(AVCodecContext *context, AVFrame *frame, int flags);
+    static void returnBuffer(void *opaque, uint8_t *data);
+
+    Block *acquire(size_t size);
+    void recycle(Block *block);
+    void trim();
+    void freeBlock(Block *block);
+    void unref();
+
+    std::atomic<int> refCount_;
+    mutable std::mutex mutex_;
+    std::vector<Block *> freeBlocks_;
+    size_t bufferSize_;
+    size_t outstanding_;
+    size_t highWaterMark_;
+    uint64_t acquireCount_;
+    uint64_t hits_;
+    uint64_t misses_;
+};
+
+#endif // FRAME_POOL_H
@@ -0,0 +1,122 @@
+#include "impairment_proxy/delay_line.h"
+#include <algorithm>
+
+namespace {
+// TCP丢包后发送端重传的等待时间，取Linux的最小RTO
+const auto RETRANSMIT_DELAY = std::chrono::milliseconds(200);
+
+// UDP乱序报文额外滞留的最短时间，jitter更大时按jitter滞留
+const int MIN_REORDER_HOLD_MS = 10;
+} // namespace
+
+DelayLine::DelayLine(Impairment &impairment, bool datagram, size_t maxQueueBytes, SendFunction send)
+    : impairment_(impairment), datagram_(datagram), maxQueueBytes_(maxQueueBytes), send_(std::move(send)),
+      random_(impairment.nextSeed()), queuedBytes_(0), sequence_(0), stopped_(false), failed_(false) {}
+
+DelayLine::~DelayLine() { stop(); }
+
+void DelayLine::start() {
+    stopped_ = false;
+    sendThread_ = std::thread(&DelayLine::sendLoop, this);
+}
+
+void DelayLine::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    condition_.notify_all();
+    if (sendThread_.joinable()) {
+        sendThread_.join();
+    }
+}
+
+bool DelayLine::chance(double percent) {
+    return percent > 0 && std::uniform_real_distribution<double>(0, 100)(random_) < percent;
+}
+
+bool DelayLine::push(const uint8_t *data, size_t size) {
+    ImpairmentProfile profile = impairment_.profile();
+    ImpairmentCounters &counters = impairment_.counters();
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (datagram_ && (chance(profile.lossPercent) || queuedBytes_ + size > maxQueueBytes_)) {
+        counters.droppedPackets++;
+        return !stopped_ && !failed_;
+    }
+    condition_.wait(lock, [this]() { return queuedBytes_ < maxQueueBytes_ || stopped_ || failed_; });
+    if (stopped_ || failed_) {
+        return false;
+    }
+
+    Clock::time_point now = Clock::now();
+    Clock::time_point sent = std::max(now, linkFree_);
+    if (profile.bandwidthKbps > 0) {
+        sent += std::chrono::microseconds(static_cast<int64_t>(size) * 8 * 1000 / profile.bandwidthKbps);
+    }
+    linkFree_ = sent;
+
+    int delayMs = profile.latencyMs;
+    if (profile.jitterMs > 0) {
+        delayMs += std::uniform_int_distribution<int>(-profile.jitterMs, profile.jitterMs)(random_);
+    }
+    Clock::time_point due = sent + std::chrono::milliseconds(std::max(delayMs, 0));
+    if (datagram_) {
+        if (chance(profile.reorderPercent)) {
+            due += std::chrono::milliseconds(std::max(profile.jitterMs, MIN_REORDER_HOLD_MS));
+            counters.reorderedPackets++;
+        }
+    } else {
+        if (chance(profile.lossPercent)) {
+            due += RETRANSMIT_DELAY;
+            counters.retransmitStalls++;
+        }
+        due = std::max(due, lastDue_);
+        lastDue_ = due;
+    }
+
+    queue_.emplace(std::make_pair(due, sequence_++), std::vector<uint8_t>(data, data + size));
+    queuedBytes_ += size;
+    lock.unlock();
+    condition_.notify_all();
+    return true;
+}
+
+void DelayLine::drain() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() { return queue_.empty() || stopped_ || failed_; });
+}
+
+void DelayLine::sendLoop() {
+    ImpairmentCounters &counters = impairment_.counters();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopped_) {
+        if (queue_.empty()) {
+            condition_.wait(lock);
+            continue;
+        }
+        auto first = queue_.begin();
+        if (first->first.first > Clock::now()) {
+            condition_.wait_until(lock, first->first.first);
+            continue;
+        }
+        std::vector<uint8_t> data = std::move(first->second);
+        queue_.erase(first);
+        queuedBytes_ -= data.size();
+        lock.unlock();
+        condition_.notify_all();
+
+        bool ok = send_(data.data(), data.size());
+        if (ok) {
+            counters.forwardedPackets++;
+            counters.forwardedBytes += data.size();
+        }
+
+        lock.lock();
+        // UDP对端暂不可达（如ICMP端口不可达）不终止链路
+        if (!ok && !datagram_) {
+            failed_ = true;
+            condition_.notify_all();
+            break;
+        }
+    }
+}
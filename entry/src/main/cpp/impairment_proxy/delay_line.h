@@ -0,0 +1,56 @@
+#ifndef IMPAIRMENT_PROXY_DELAY_LINE_H
+#define IMPAIRMENT_PROXY_DELAY_LINE_H
+
+#include "impairment_proxy/impairment.h"
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <random>
+#include <thread>
+#include <utility>
+
+// 单向链路：按当前损伤参数给每段数据计算到达时间，由发送线程到时转发。
+// 带宽限制按瓶颈链路串行化建模，超出带宽的数据在队列中排队，延迟随之增长。
+// 字节流模式（TCP）保序，不丢数据，丢包表现为重传等待，队列满时阻塞写入方形成反压；
+// 报文模式（UDP）按丢包率丢弃、按乱序率额外滞留，队列满时尾部丢弃。
+class DelayLine {
+public:
+    using Clock = std::chrono::steady_clock;
+    // 转发一段数据，失败时链路停止
+    using SendFunction = std::function<bool(const uint8_t *data, size_t size)>;
+
+    DelayLine(Impairment &impairment, bool datagram, size_t maxQueueBytes, SendFunction send);
+    ~DelayLine();
+
+    void start();
+    void stop();
+
+    // 放入一段数据；链路已停止或发送失败时返回false
+    bool push(const uint8_t *data, size_t size);
+
+    // 等待队列发送完毕，用于对端关闭后把已收到的数据转发完再半关闭
+    void drain();
+
+private:
+    bool chance(double percent);
+    void sendLoop();
+
+    Impairment &impairment_;
+    const bool datagram_;
+    const size_t maxQueueBytes_;
+    SendFunction send_;
+    std::mt19937 random_;
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::map<std::pair<Clock::time_point, uint64_t>, std::vector<uint8_t>> queue_; // 按到达时间和序号排序
+    size_t queuedBytes_;
+    uint64_t sequence_;
+    Clock::time_point linkFree_; // 瓶颈链路发送完已排队数据的时刻
+    Clock::time_point lastDue_;  // 字节流模式下上一段数据的到达时间，保证不被后续数据超过
+    bool stopped_;
+    bool failed_;
+    std::thread sendThread_;
+};
+
+#endif // IMPAIRMENT_PROXY_DELAY_LINE_H
@@ -0,0 +1,135 @@
+#include "impairment_proxy/impairment.h"
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+namespace {
+bool ParseNumber(const std::string &text, double &value) {
+    if (text.empty()) {
+        return false;
+    }
+    char *end = nullptr;
+    value = strtod(text.c_str(), &end);
+    return end && *end == '\0' && value >= 0;
+}
+} // namespace
+
+std::string ImpairmentProfile::describe() const {
+    std::string bandwidth = bandwidthKbps > 0 ? std::to_string(bandwidthKbps) + " kbps" : "unlimited";
+    char text[160];
+    snprintf(text, sizeof(text), "latency %d ms, jitter %d ms, bandwidth %s, loss %.1f%%, reorder %.1f%%", latencyMs,
+             jitterMs, bandwidth.c_str(), lossPercent, reorderPercent);
+    return text;
+}
+
+bool ParseImpairmentSetting(const std::string &setting, ImpairmentProfile &profile) {
+    size_t equals = setting.find('=');
+    if (equals == std::string::npos) {
+        return false;
+    }
+    std::string key = setting.substr(0, equals);
+    double value = 0;
+    if (!ParseNumber(setting.substr(equals + 1), value)) {
+        return false;
+    }
+    if (key == "latency") {
+        profile.latencyMs = static_cast<int>(value);
+    } else if (key == "jitter") {
+        profile.jitterMs = static_cast<int>(value);
+    } else if (key == "bandwidth") {
+        profile.bandwidthKbps = static_cast<int>(value);
+    } else if (key == "loss" && value <= 100) {
+        profile.lossPercent = value;
+    } else if (key == "reorder" && value <= 100) {
+        profile.reorderPercent = value;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ParseImpairmentSchedule(std::istream &input, const ImpairmentProfile &base, std::vector<ImpairmentStep> &steps,
+                             std::string &error) {
+    ImpairmentProfile profile = base;
+    double lastSeconds = 0;
+    std::string line;
+    for (int lineNumber = 1; std::getline(input, line); lineNumber++) {
+        std::istringstream tokens(line.substr(0, line.find('#')));
+        std::string token;
+        if (!(tokens >> token)) {
+            continue;
+        }
+        ImpairmentStep step;
+        if (!ParseNumber(token, step.atSeconds) || step.atSeconds < lastSeconds) {
+            error = "line " + std::to_string(lineNumber) + ": expected a non-decreasing time in seconds";
+            return false;
+        }
+        while (tokens >> token) {
+            if (token == "reset") {
+                step.reset = true;
+            } else if (token == "clear") {
+                profile = base;
+            } else if (!ParseImpairmentSetting(token, profile)) {
+                error = "line " + std::to_string(lineNumber) + ": invalid setting " + token;
+                return false;
+            }
+        }
+        step.profile = profile;
+        lastSeconds = step.atSeconds;
+        steps.push_back(step);
+    }
+    return true;
+}
+
+Impairment::Impairment(const ImpairmentProfile &base, std::vector<ImpairmentStep> steps, uint32_t seed)
+    : profile_(base), steps_(std::move(steps)), nextStep_(0), reportedStep_(0), started_(false), seed_(seed),
+      links_(0) {}
+
+void Impairment::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!started_) {
+        started_ = true;
+        startTime_ = Clock::now();
+        applyDueSteps();
+    }
+}
+
+bool Impairment::started() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return started_;
+}
+
+double Impairment::elapsedSeconds() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return started_ ? std::chrono::duration<double>(Clock::now() - startTime_).count() : 0;
+}
+
+std::vector<ImpairmentStep> Impairment::update() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    applyDueSteps();
+    std::vector<ImpairmentStep> applied(steps_.begin() + reportedStep_, steps_.begin() + nextStep_);
+    reportedStep_ = nextStep_;
+    return applied;
+}
+
+ImpairmentProfile Impairment::profile() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    applyDueSteps();
+    return profile_;
+}
+
+void Impairment::applyDueSteps() {
+    if (!started_ || nextStep_ >= steps_.size()) {
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - startTime_).count();
+    while (nextStep_ < steps_.size() && steps_[nextStep_].atSeconds <= elapsed) {
+        profile_ = steps_[nextStep_].profile;
+        nextStep_++;
+    }
+}
+
+uint32_t Impairment::nextSeed() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return seed_ + links_++;
+}
@@ -0,0 +1,86 @@
+#ifndef IMPAIRMENT_PROXY_IMPAIRMENT_H
+#define IMPAIRMENT_PROXY_IMPAIRMENT_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 一个时间段内生效的网络损伤参数
+struct ImpairmentProfile {
+    int latencyMs = 0;         // 单向固定延迟
+    int jitterMs = 0;          // 在固定延迟上随机增减的幅度
+    int bandwidthKbps = 0;     // 瓶颈带宽，0表示不限
+    double lossPercent = 0;    // UDP丢弃报文；TCP表现为该段数据等待一次重传
+    double reorderPercent = 0; // UDP报文额外滞留、被后续报文超过的比例；TCP字节流保序，不生效
+
+    std::string describe() const;
+};
+
+// 时间表中的一步：从atSeconds起使用profile，reset表示此刻重置所有TCP连接
+struct ImpairmentStep {
+    double atSeconds = 0;
+    ImpairmentProfile profile;
+    bool reset = false;
+};
+
+// 解析一项key=value设置（latency、jitter、bandwidth、loss、reorder），写入profile
+bool ParseImpairmentSetting(const std::string &setting, ImpairmentProfile &profile);
+
+// 解析时间表脚本，每行：<秒> [key=value...] [reset] [clear]，'#'之后为注释。
+// 未列出的参数沿用上一步，clear恢复为base；时间须单调不减
+bool ParseImpairmentSchedule(std::istream &input, const ImpairmentProfile &base, std::vector<ImpairmentStep> &steps,
+                             std::string &error);
+
+// 所有链路共用的计数
+struct ImpairmentCounters {
+    std::atomic<uint64_t> forwardedPackets{0};
+    std::atomic<uint64_t> forwardedBytes{0};
+    std::atomic<uint64_t> droppedPackets{0};   // 按丢包率丢弃或队列满时尾部丢弃的UDP报文
+    std::atomic<uint64_t> retransmitStalls{0}; // TCP上模拟丢包造成的重传等待
+    std::atomic<uint64_t> reorderedPackets{0};
+    std::atomic<uint64_t> resets{0}; // 被重置的TCP连接数
+};
+
+// 按时间表切换当前损伤参数，供所有连接和UDP中继共享
+class Impairment {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Impairment(const ImpairmentProfile &base, std::vector<ImpairmentStep> steps, uint32_t seed);
+
+    // 时间表从第一个TCP连接或第一个UDP报文开始计时，使结果与被测流的起播对齐；重复调用不生效
+    void start();
+    bool started() const;
+    double elapsedSeconds() const;
+
+    // 返回上次调用以来生效的步骤，由控制线程周期调用，用于输出和执行reset
+    std::vector<ImpairmentStep> update();
+
+    ImpairmentProfile profile();
+
+    // 每条链路取一个随机数种子：同一seed下，各链路按创建顺序得到相同的丢包、抖动序列
+    uint32_t nextSeed();
+
+    ImpairmentCounters &counters() { return counters_; }
+
+private:
+    // 应用已到时的步骤，调用方持有mutex_；链路取参数时也会推进，切换时刻不受控制线程轮询间隔影响
+    void applyDueSteps();
+
+    mutable std::mutex mutex_;
+    ImpairmentProfile profile_;
+    std::vector<ImpairmentStep> steps_;
+    size_t nextStep_;     // 下一个未生效的步骤
+    size_t reportedStep_; // 下一个未经update()返回的步骤
+    bool started_;
+    Clock::time_point startTime_;
+    uint32_t seed_;
+    uint32_t links_;
+    ImpairmentCounters counters_;
+};
+
+#endif // IMPAIRMENT_PROXY_IMPAIRMENT_H
@@ -0,0 +1,217 @@
+// 网络损伤代理，用于可复现的延迟、丢包和断线测试。
+// 架在VideoStreamHandler（或decode_benchmark）与本地流服务（如loopback_server）之间，
+// 按命令行给出的初始参数和时间表脚本注入延迟、抖动、带宽限制、丢包、乱序和连接重置。
+// 时间表从第一个连接开始计时，随机序列由--seed决定，同样的输入得到同样的损伤过程。
+//
+// 用法：impairment_proxy [选项] --tcp LISTEN_PORT:HOST:PORT ... --udp LISTEN_PORT:HOST:PORT ...
+//   --bind ADDR          监听地址，默认127.0.0.1
+//   --latency MS         初始单向延迟
+//   --jitter MS          初始抖动幅度
+//   --bandwidth KBPS     初始瓶颈带宽，默认不限
+//   --loss PERCENT       初始丢包率
+//   --reorder PERCENT    初始乱序率（仅UDP）
+//   --schedule FILE      时间表脚本，每行：<秒> [latency=MS] [jitter=MS] [bandwidth=KBPS] [loss=%] [reorder=%]
+//                        [reset] [clear]
+//   --seed N             随机数种子，默认1
+//   --queue-kb N         每条链路的排队上限，默认1024
+//   --stats-interval S   输出转发统计的间隔，默认1秒，0表示不输出
+//   --verbose            输出连接级INFO日志
+//
+// 时间表示例：
+//   5   latency=80 jitter=20
+//   15  bandwidth=1500 loss=2
+//   25  reset
+//   30  clear
+
+#include "common/log.h"
+#include "impairment_proxy/tcp_proxy.h"
+#include "impairment_proxy/udp_relay.h"
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+
+namespace {
+// 推进时间表的间隔，也是reset步骤的时间精度
+const auto SCHEDULE_POLL_INTERVAL = std::chrono::milliseconds(10);
+
+const size_t DEFAULT_QUEUE_KB = 1024;
+
+std::atomic<bool> g_exitRequested{false};
+
+struct Forward {
+    uint16_t listenPort = 0;
+    sockaddr_in target = {};
+    std::string text;
+};
+
+struct ProxyConfig {
+    std::string bindAddress = "127.0.0.1";
+    std::vector<Forward> tcpForwards;
+    std::vector<Forward> udpForwards;
+    ImpairmentProfile base;
+    std::string schedulePath;
+    uint32_t seed = 1;
+    size_t queueKb = DEFAULT_QUEUE_KB;
+    double statsInterval = 1;
+    bool verbose = false;
+};
+
+void OnSignal(int) { g_exitRequested = true; }
+
+void PrintUsage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--bind ADDR] [--latency MS] [--jitter MS] [--bandwidth KBPS] [--loss PERCENT]\n"
+            "          [--reorder PERCENT] [--schedule FILE] [--seed N] [--queue-kb N] [--stats-interval S]\n"
+            "          [--verbose] (--tcp LISTEN_PORT:HOST:PORT | --udp LISTEN_PORT:HOST:PORT)...\n",
+            program);
+}
+
+// 8554:127.0.0.1:18554
+bool ParseForward(const std::string &text, Forward &forward) {
+    size_t first = text.find(':');
+    size_t last = text.rfind(':');
+    if (first == std::string::npos || first == last) {
+        return false;
+    }
+    int listenPort = atoi(text.substr(0, first).c_str());
+    int targetPort = atoi(text.substr(last + 1).c_str());
+    if (listenPort <= 0 || listenPort > 65535 || targetPort <= 0 || targetPort > 65535) {
+        return false;
+    }
+    forward.listenPort = static_cast<uint16_t>(listenPort);
+    forward.text = text;
+    return MakeIpv4Address(text.substr(first + 1, last - first - 1), static_cast<uint16_t>(targetPort),
+                           forward.target);
+}
+
+bool ParseArguments(int argc, char **argv, ProxyConfig &config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if ((arg == "--tcp" || arg == "--udp") && hasValue) {
+            Forward forward;
+            if (!ParseForward(argv[++i], forward)) {
+                return false;
+            }
+            (arg == "--tcp" ? config.tcpForwards : config.udpForwards).push_back(forward);
+        } else if (arg == "--bind" && hasValue) {
+            config.bindAddress = argv[++i];
+        } else if ((arg == "--latency" || arg == "--jitter" || arg == "--bandwidth" || arg == "--loss" ||
+                    arg == "--reorder") &&
+                   hasValue) {
+            if (!ParseImpairmentSetting(arg.substr(2) + "=" + argv[++i], config.base)) {
+                return false;
+            }
+        } else if (arg == "--schedule" && hasValue) {
+            config.schedulePath = argv[++i];
+        } else if (arg == "--seed" && hasValue) {
+            config.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--queue-kb" && hasValue) {
+            config.queueKb = static_cast<size_t>(atoi(argv[++i]));
+        } else if (arg == "--stats-interval" && hasValue) {
+            config.statsInterval = atof(argv[++i]);
+        } else if (arg == "--verbose") {
+            config.verbose = true;
+        } else {
+            return false;
+        }
+    }
+    return (!config.tcpForwards.empty() || !config.udpForwards.empty()) && config.queueKb > 0;
+}
+
+void PrintStats(Impairment &impairment) {
+    ImpairmentCounters &counters = impairment.counters();
+    printf("[%7.2f] forwarded %llu packets (%.1f KiB), dropped %llu, reordered %llu, retransmit stalls %llu, "
+           "resets %llu\n",
+           impairment.elapsedSeconds(), static_cast<unsigned long long>(counters.forwardedPackets.load()),
+           counters.forwardedBytes.load() / 1024.0, static_cast<unsigned long long>(counters.droppedPackets.load()),
+           static_cast<unsigned long long>(counters.reorderedPackets.load()),
+           static_cast<unsigned long long>(counters.retransmitStalls.load()),
+           static_cast<unsigned long long>(counters.resets.load()));
+    fflush(stdout);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    ProxyConfig config;
+    if (!ParseArguments(argc, argv, config)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    HostLogSetLevel(config.verbose ? LOG_INFO : LOG_WARN);
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<ImpairmentStep> steps;
+    if (!config.schedulePath.empty()) {
+        std::ifstream input(config.schedulePath);
+        std::string error;
+        if (!input) {
+            fprintf(stderr, "Cannot open schedule %s\n", config.schedulePath.c_str());
+            return 2;
+        }
+        if (!ParseImpairmentSchedule(input, config.base, steps, error)) {
+            fprintf(stderr, "%s: %s\n", config.schedulePath.c_str(), error.c_str());
+            return 2;
+        }
+    }
+    Impairment impairment(config.base, steps, config.seed);
+    size_t maxQueueBytes = config.queueKb * 1024;
+
+    std::vector<std::unique_ptr<TcpImpairmentProxy>> tcpProxies;
+    for (const Forward &forward : config.tcpForwards) {
+        auto proxy = std::make_unique<TcpImpairmentProxy>(forward.target, impairment, maxQueueBytes);
+        if (!proxy->start(config.bindAddress, forward.listenPort)) {
+            fprintf(stderr, "Failed to start TCP proxy %s\n", forward.text.c_str());
+            return 1;
+        }
+        tcpProxies.push_back(std::move(proxy));
+    }
+    std::vector<std::unique_ptr<UdpImpairmentRelay>> udpRelays;
+    for (const Forward &forward : config.udpForwards) {
+        sockaddr_in listen;
+        auto relay = std::make_unique<UdpImpairmentRelay>(impairment, maxQueueBytes);
+        if (!MakeIpv4Address(config.bindAddress, forward.listenPort, listen) ||
+            !relay->start(listen, forward.target)) {
+            fprintf(stderr, "Failed to start UDP relay %s\n", forward.text.c_str());
+            return 1;
+        }
+        udpRelays.push_back(std::move(relay));
+    }
+
+    printf("Seed %u, %zu scheduled steps, initial profile: %s\n", config.seed, steps.size(),
+           config.base.describe().c_str());
+    printf("Schedule starts at the first connection\n");
+    fflush(stdout);
+
+    auto lastStats = Impairment::Clock::now();
+    while (!g_exitRequested) {
+        std::this_thread::sleep_for(SCHEDULE_POLL_INTERVAL);
+        for (const ImpairmentStep &step : impairment.update()) {
+            printf("[%7.2f] step at %.2f s: %s%s\n", impairment.elapsedSeconds(), step.atSeconds,
+                   step.profile.describe().c_str(), step.reset ? ", reset connections" : "");
+            fflush(stdout);
+            if (step.reset) {
+                for (auto &proxy : tcpProxies) {
+                    proxy->resetConnections();
+                }
+            }
+        }
+        auto now = Impairment::Clock::now();
+        if (config.statsInterval > 0 && impairment.started() &&
+            std::chrono::duration<double>(now - lastStats).count() >= config.statsInterval) {
+            PrintStats(impairment);
+            lastStats = now;
+        }
+    }
+
+    printf("Shutting down\n");
+    PrintStats(impairment);
+    tcpProxies.clear();
+    udpRelays.clear();
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "impairment_proxy/tcp_proxy.h"
+#include "common/log.h"
+#include "impairment_proxy/delay_line.h"
+#include <cerrno>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "TcpProxy"
+
+namespace {
+// 每次从套接字读取的上限，也是延迟队列中一段数据的最大长度
+const size_t READ_BUFFER_SIZE = 16 * 1024;
+} // namespace
+
+// 一对客户端/上游连接。每个方向一个读线程写入DelayLine，由DelayLine的发送线程写往对端
+class ProxyConnection {
+public:
+    ProxyConnection(int clientFd, int upstreamFd, Impairment &impairment, size_t maxQueueBytes)
+        : clientFd_(clientFd), upstreamFd_(upstreamFd), reset_(false),
+          uplink_(impairment, false, maxQueueBytes,
+                  [upstreamFd](const uint8_t *data, size_t size) { return SendAll(upstreamFd, data, size); }),
+          downlink_(impairment, false, maxQueueBytes,
+                    [clientFd](const uint8_t *data, size_t size) { return SendAll(clientFd, data, size); }) {}
+
+    // 阻塞到两个方向都结束
+    void run() {
+        uplink_.start();
+        downlink_.start();
+        std::thread downstream([this]() { pump(upstreamFd_, clientFd_, downlink_); });
+        pump(clientFd_, upstreamFd_, uplink_);
+        downstream.join();
+        uplink_.stop();
+        downlink_.stop();
+    }
+
+    // 向两端发送RST而不是FIN：Linux上对TCP套接字connect(AF_UNSPEC)会断开连接并发送RST，同时打断两个读线程
+    void reset() {
+        reset_ = true;
+        sockaddr unspecified = {};
+        unspecified.sa_family = AF_UNSPEC;
+        connect(clientFd_, &unspecified, sizeof(unspecified));
+        connect(upstreamFd_, &unspecified, sizeof(unspecified));
+    }
+
+private:
+    void pump(int from, int to, DelayLine &line) {
+        uint8_t buffer[READ_BUFFER_SIZE];
+        while (true) {
+            ssize_t received = recv(from, buffer, sizeof(buffer), 0);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received == 0 && !reset_) {
+                // 对端正常关闭：把已收到的数据按损伤参数转发完，再向另一端半关闭
+                line.drain();
+                shutdown(to, SHUT_WR);
+                return;
+            }
+            if (received <= 0 || !line.push(buffer, static_cast<size_t>(received))) {
+                closeBoth();
+                return;
+            }
+        }
+    }
+
+    void closeBoth() {
+        shutdown(clientFd_, SHUT_RDWR);
+        shutdown(upstreamFd_, SHUT_RDWR);
+    }
+
+    int clientFd_;
+    int upstreamFd_;
+    std::atomic<bool> reset_;
+    DelayLine uplink_;
+    DelayLine downlink_;
+};
+
+TcpImpairmentProxy::TcpImpairmentProxy(const sockaddr_in &upstream, Impairment &impairment, size_t maxQueueBytes)
+    : upstream_(upstream), impairment_(impairment), maxQueueBytes_(maxQueueBytes) {}
+
+TcpImpairmentProxy::~TcpImpairmentProxy() { stop(); }
+
+void TcpImpairmentProxy::resetConnections() {
+    std::lock_guard<std::mutex> lock(connectionsMutex_);
+    for (ProxyConnection *connection : connections_) {
+        connection->reset();
+        impairment_.counters().resets++;
+    }
+}
+
+void TcpImpairmentProxy::serve(int fd) {
+    int upstreamFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (upstreamFd < 0) {
+        return;
+    }
+    if (connect(upstreamFd, reinterpret_cast<const sockaddr *>(&upstream_), sizeof(upstream_)) < 0) {
+        OH_LOG_WARN(LOG_APP, "Failed to connect upstream, errno %{public}d", errno);
+        close(upstreamFd);
+        return;
+    }
+    int noDelay = 1;
+    setsockopt(upstreamFd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    impairment_.start();
+
+    {
+        ProxyConnection connection(fd, upstreamFd, impairment_, maxQueueBytes_);
+        {
+            std::lock_guard<std::mutex> lock(connectionsMutex_);
+            connections_.insert(&connection);
+        }
+        connection.run();
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        connections_.erase(&connection);
+    }
+    close(upstreamFd);
+}
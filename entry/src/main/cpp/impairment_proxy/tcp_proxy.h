@@ -0,0 +1,31 @@
+#ifndef IMPAIRMENT_PROXY_TCP_PROXY_H
+#define IMPAIRMENT_PROXY_TCP_PROXY_H
+
+#include "impairment_proxy/impairment.h"
+#include "loopback_server/tcp_server.h"
+#include <set>
+
+class ProxyConnection;
+
+// TCP损伤代理：每个接入的连接都向上游建立一条连接，两个方向各经过一条DelayLine转发。
+// RTSP（含RTP over TCP）、RTMP和HTTP类拉流都走这一路径。
+class TcpImpairmentProxy : public TcpServer {
+public:
+    TcpImpairmentProxy(const sockaddr_in &upstream, Impairment &impairment, size_t maxQueueBytes);
+    ~TcpImpairmentProxy() override;
+
+    // 以RST中断所有当前连接，模拟中间设备或服务端异常断开
+    void resetConnections();
+
+protected:
+    void serve(int fd) override;
+
+private:
+    const sockaddr_in upstream_;
+    Impairment &impairment_;
+    const size_t maxQueueBytes_;
+    std::mutex connectionsMutex_;
+    std::set<ProxyConnection *> connections_;
+};
+
+#endif // IMPAIRMENT_PROXY_TCP_PROXY_H
@@ -0,0 +1,117 @@
+#include "impairment_proxy/udp_relay.h"
+#include "common/log.h"
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "UdpRelay"
+
+namespace {
+// 接收等待的超时，期间检查停止请求
+const int RECEIVE_POLL_TIMEOUT_MS = 100;
+
+// 最大UDP报文长度
+const size_t MAX_DATAGRAM_SIZE = 65536;
+
+// 调大接收缓冲，避免突发报文在进入延迟队列之前就被内核丢弃而混入非预期的丢包
+const int SOCKET_BUFFER_SIZE = 4 * 1024 * 1024;
+} // namespace
+
+UdpImpairmentRelay::UdpImpairmentRelay(Impairment &impairment, size_t maxQueueBytes)
+    : impairment_(impairment), listenFd_(-1), destinationFd_(-1), client_(), hasClient_(false), stopping_(false) {
+    uplink_ = std::make_unique<DelayLine>(impairment, true, maxQueueBytes, [this](const uint8_t *data, size_t size) {
+        return send(destinationFd_, data, size, 0) == static_cast<ssize_t>(size);
+    });
+    downlink_ = std::make_unique<DelayLine>(impairment, true, maxQueueBytes, [this](const uint8_t *data, size_t size) {
+        return sendToClient(data, size);
+    });
+}
+
+UdpImpairmentRelay::~UdpImpairmentRelay() { stop(); }
+
+bool UdpImpairmentRelay::start(const sockaddr_in &listen, const sockaddr_in &destination) {
+    listenFd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    destinationFd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (listenFd_ < 0 || destinationFd_ < 0) {
+        stop();
+        return false;
+    }
+    int bufferSize = SOCKET_BUFFER_SIZE;
+    setsockopt(listenFd_, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    setsockopt(destinationFd_, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    if (bind(listenFd_, reinterpret_cast<const sockaddr *>(&listen), sizeof(listen)) < 0 ||
+        connect(destinationFd_, reinterpret_cast<const sockaddr *>(&destination), sizeof(destination)) < 0) {
+        OH_LOG_ERROR(LOG_APP, "Failed to set up UDP relay, errno %{public}d", errno);
+        stop();
+        return false;
+    }
+    stopping_ = false;
+    uplink_->start();
+    downlink_->start();
+    clientThread_ = std::thread(&UdpImpairmentRelay::receiveLoop, this, true);
+    destinationThread_ = std::thread(&UdpImpairmentRelay::receiveLoop, this, false);
+    return true;
+}
+
+void UdpImpairmentRelay::stop() {
+    stopping_ = true;
+    if (clientThread_.joinable()) {
+        clientThread_.join();
+    }
+    if (destinationThread_.joinable()) {
+        destinationThread_.join();
+    }
+    uplink_->stop();
+    downlink_->stop();
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+    }
+    if (destinationFd_ >= 0) {
+        close(destinationFd_);
+        destinationFd_ = -1;
+    }
+}
+
+void UdpImpairmentRelay::receiveLoop(bool fromClient) {
+    int fd = fromClient ? listenFd_ : destinationFd_;
+    DelayLine &line = fromClient ? *uplink_ : *downlink_;
+    std::vector<uint8_t> buffer(MAX_DATAGRAM_SIZE);
+    while (!stopping_) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, RECEIVE_POLL_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+        sockaddr_in source = {};
+        socklen_t sourceLength = sizeof(source);
+        ssize_t received =
+            recvfrom(fd, buffer.data(), buffer.size(), 0, reinterpret_cast<sockaddr *>(&source), &sourceLength);
+        if (received < 0) {
+            continue;
+        }
+        if (fromClient) {
+            std::lock_guard<std::mutex> lock(clientMutex_);
+            client_ = source;
+            hasClient_ = true;
+        }
+        impairment_.start();
+        line.push(buffer.data(), static_cast<size_t>(received));
+    }
+}
+
+bool UdpImpairmentRelay::sendToClient(const uint8_t *data, size_t size) {
+    sockaddr_in client;
+    {
+        std::lock_guard<std::mutex> lock(clientMutex_);
+        if (!hasClient_) {
+            return false;
+        }
+        client = client_;
+    }
+    return sendto(listenFd_, data, size, 0, reinterpret_cast<const sockaddr *>(&client), sizeof(client)) ==
+           static_cast<ssize_t>(size);
+}
@@ -0,0 +1,37 @@
+#ifndef IMPAIRMENT_PROXY_UDP_RELAY_H
+#define IMPAIRMENT_PROXY_UDP_RELAY_H
+
+#include "impairment_proxy/delay_line.h"
+#include <memory>
+#include <netinet/in.h>
+
+// UDP损伤中继：本地端口收到的报文经DelayLine转发到目标地址，目标地址的回包转发给最近一个发来报文的地址。
+// 用于udp://、rtp://等按固定UDP端口收流的场景：推流端发往中继端口，中继转发到播放端监听的端口。
+// RTSP的UDP传输端口在信令中协商，无法经中继转发，需改用TCP代理加interleaved传输。
+class UdpImpairmentRelay {
+public:
+    UdpImpairmentRelay(Impairment &impairment, size_t maxQueueBytes);
+    ~UdpImpairmentRelay();
+
+    bool start(const sockaddr_in &listen, const sockaddr_in &destination);
+    void stop();
+
+private:
+    // fromClient为true时读监听端口写入上行链路，否则读目标端口写入下行链路
+    void receiveLoop(bool fromClient);
+    bool sendToClient(const uint8_t *data, size_t size);
+
+    Impairment &impairment_;
+    int listenFd_;
+    int destinationFd_;
+    std::mutex clientMutex_;
+    sockaddr_in client_;
+    bool hasClient_;
+    std::unique_ptr<DelayLine> uplink_;
+    std::unique_ptr<DelayLine> downlink_;
+    std::thread clientThread_;
+    std::thread destinationThread_;
+    std::atomic<bool> stopping_;
+};
+
+#endif // IMPAIRMENT_PROXY_UDP_RELAY_H
@@ -0,0 +1,162 @@
+#include "latency_controller.h"
+#include "common/log.h"
+#include <climits>
+
+extern "C" {
+#include <libavutil/mathematics.h>
+}
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "LatencyController"
+
+namespace {
+const int64_t NO_BASELINE = INT64_MAX;
+
+// 基准每经过1秒上浮1毫秒，容忍发送端与本地时钟的漂移
+const int64_t BASELINE_DRIFT_DIVISOR = 1000;
+
+// 延迟平滑系数
+const double LATENCY_SMOOTHING = 0.1;
+
+// 超出目标的倍数达到该值时进入下一追赶级别
+const double SKIP_NON_REF_FACTOR = 2.0;
+const double SKIP_TO_KEYFRAME_FACTOR = 4.0;
+
+// 数据包队列占用超过该比例时直接丢包到关键帧
+const double PACKET_QUEUE_CRITICAL_FILL = 0.75;
+
+// 追赶时的播放速率
+const double SPEED_UP_RATE = 1.1;
+const double SKIP_NON_REF_RATE = 1.25;
+
+// 两次丢包到关键帧之间的最小间隔，留出延迟回落的时间
+const int64_t KEYFRAME_SKIP_COOLDOWN_US = 2000000;
+} // namespace
+
+LatencyController::LatencyController()
+    : timeBase_{1, AV_TIME_BASE}, targetUs_(0), baselineUs_(NO_BASELINE), lastArrivalUs_(0),
+      effectiveLatencyUs_(-1), playbackRate_(1.0), level_(static_cast<int>(CatchUpLevel::None)), lastSkipUs_(0),
+      skipToKeyframe_(false), keyframeSkips_(0), skippedPackets_(0), flushedFrames_(0) {}
+
+void LatencyController::reset(int targetMs, AVRational timeBase) {
+    timeBase_ = timeBase.num > 0 && timeBase.den > 0 ? timeBase : AVRational{1, AV_TIME_BASE};
+    targetUs_ = targetMs > 0 ? static_cast<int64_t>(targetMs) * 1000 : 0;
+    baselineUs_ = NO_BASELINE;
+    lastArrivalUs_ = 0;
+    effectiveLatencyUs_ = -1;
+    playbackRate_ = 1.0;
+    level_ = static_cast<int>(CatchUpLevel::None);
+    lastSkipUs_ = 0;
+    skipToKeyframe_ = false;
+    keyframeSkips_ = 0;
+    skippedPackets_ = 0;
+    flushedFrames_ = 0;
+}
+
+int64_t LatencyController::toMicroseconds(int64_t pts) const {
+    return av_rescale_q(pts, timeBase_, AVRational{1, AV_TIME_BASE});
+}
+
+void LatencyController::onPacketArrival(int64_t pts, int64_t nowUs) {
+    if (pts == AV_NOPTS_VALUE) {
+        return;
+    }
+    int64_t offsetUs = nowUs - toMicroseconds(pts);
+    int64_t baselineUs = baselineUs_.load(std::memory_order_relaxed);
+    if (baselineUs != NO_BASELINE && lastArrivalUs_ > 0 && nowUs > lastArrivalUs_) {
+        baselineUs += (nowUs - lastArrivalUs_) / BASELINE_DRIFT_DIVISOR;
+    }
+    if (baselineUs == NO_BASELINE || offsetUs < baselineUs) {
+        baselineUs = offsetUs;
+    }
+    baselineUs_.store(baselineUs, std::memory_order_relaxed);
+    lastArrivalUs_ = nowUs;
+}
+
+void LatencyController::rebase() {
+    baselineUs_ = NO_BASELINE;
+    lastArrivalUs_ = 0;
+    effectiveLatencyUs_ = -1;
+}
+
+double LatencyController::onFramePresented(int64_t pts, int64_t nowUs, double packetQueueFill, bool &needResync) {
+    needResync = false;
+    int64_t baselineUs = baselineUs_.load(std::memory_order_relaxed);
+    if (pts == AV_NOPTS_VALUE || baselineUs == NO_BASELINE) {
+        return playbackRate_.load();
+    }
+
+    double sampleUs = static_cast<double>(nowUs - toMicroseconds(pts) - baselineUs);
+    if (sampleUs < 0) {
+        sampleUs = 0;
+    }
+    double latencyUs = effectiveLatencyUs_.load();
+    latencyUs = latencyUs < 0 ? sampleUs : latencyUs + (sampleUs - latencyUs) * LATENCY_SMOOTHING;
+    effectiveLatencyUs_ = latencyUs;
+
+    if (targetUs_ <= 0) {
+        return 1.0;
+    }
+
+    CatchUpLevel level = CatchUpLevel::None;
+    if (latencyUs > targetUs_ * SKIP_TO_KEYFRAME_FACTOR || packetQueueFill > PACKET_QUEUE_CRITICAL_FILL) {
+        level = CatchUpLevel::SkipToKeyframe;
+    } else if (latencyUs > targetUs_ * SKIP_NON_REF_FACTOR) {
+        level = CatchUpLevel::SkipNonRef;
+    } else if (latencyUs > targetUs_) {
+        level = CatchUpLevel::SpeedUp;
+    }
+
+    // 丢包到关键帧有冷却期，期间按只解码参考帧处理
+    if (level == CatchUpLevel::SkipToKeyframe) {
+        if (lastSkipUs_ == 0 || nowUs - lastSkipUs_ >= KEYFRAME_SKIP_COOLDOWN_US) {
+            lastSkipUs_ = nowUs;
+            keyframeSkips_++;
+            skipToKeyframe_ = true;
+            needResync = true;
+            // 跳过之后的帧不再反映旧的积压
+            effectiveLatencyUs_ = -1;
+            OH_LOG_INFO(LOG_APP, "Latency %{public}.0f ms over target %{public}lld ms, skipping to next keyframe",
+                        latencyUs / 1000, static_cast<long long>(targetUs_ / 1000));
+        } else {
+            level = CatchUpLevel::SkipNonRef;
+        }
+    }
+
+    int previous = level_.exchange(static_cast<int>(level));
+    if (previous != static_cast<int>(level)) {
+        OH_LOG_INFO(LOG_APP, "Catch-up level %{public}d -> %{public}d, latency %{public}.0f ms", previous,
+                    static_cast<int>(level), latencyUs / 1000);
+    }
+
+    double rate = 1.0;
+    if (level == CatchUpLevel::SpeedUp) {
+        rate = SPEED_UP_RATE;
+    } else if (level == CatchUpLevel::SkipNonRef) {
+        rate = SKIP_NON_REF_RATE;
+    }
+    playbackRate_ = rate;
+    return rate;
+}
+
+AVDiscard LatencyController::decodeDiscard() const {
+    int level = level_.load(std::memory_order_relaxed);
+    return level >= static_cast<int>(CatchUpLevel::SkipNonRef) ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+}
+
+bool LatencyController::takeKeyframeSkip() { return skipToKeyframe_.exchange(false); }
+
+LatencyControlStats LatencyController::getStats() const {
+    LatencyControlStats stats;
+    stats.targetLatencyMs = targetUs_ / 1000.0;
+    double latencyUs = effectiveLatencyUs_.load();
+    stats.effectiveLatencyMs = latencyUs < 0 ? -1 : latencyUs / 1000;
+    stats.playbackRate = playbackRate_.load();
+    stats.level = static_cast<CatchUpLevel>(level_.load());
+    stats.keyframeSkips = keyframeSkips_.load();
+    stats.skippedPackets = skippedPackets_.load();
+    stats.flushedFrames = flushedFrames_.load();
+    return stats;
+}
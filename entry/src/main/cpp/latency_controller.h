@@ -0,0 +1,81 @@
+#ifndef LATENCY_CONTROLLER_H
+#define LATENCY_CONTROLLER_H
+
+#include <atomic>
+#include <cstdint>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+// 延迟控制当前所处的追赶级别
+enum class CatchUpLevel {
+    None = 0,      // 在目标延迟以内
+    SpeedUp,       // 加快呈现节奏
+    SkipNonRef,    // 解码器只解码参考帧，并加快呈现
+    SkipToKeyframe // 丢弃数据包直到下一个关键帧，并重新锚定呈现时钟
+};
+
+// 延迟控制状态
+struct LatencyControlStats {
+    double targetLatencyMs = 0;
+    double effectiveLatencyMs = -1; // 平滑后的排队延迟，未知时为-1
+    double playbackRate = 1.0;
+    CatchUpLevel level = CatchUpLevel::None;
+    uint64_t keyframeSkips = 0;  // 触发丢包到关键帧的次数
+    uint64_t skippedPackets = 0; // 因此丢弃的数据包数
+    uint64_t flushedFrames = 0;  // 因此清掉的已解码帧数
+};
+
+// 自适应延迟控制。
+// 延迟以"呈现时刻 - pts"相对"到达时刻 - pts"历史最小值的差来度量，即数据在套接字缓冲、各级队列和呈现调度中
+// 额外停留的时间；基准按时间缓慢上浮以容忍两端时钟漂移。超过目标后按超出程度逐级处理：
+// 加快呈现、只解码参考帧、丢包到下一个关键帧。
+// onPacketArrival在解复用线程调用，onFramePresented在渲染线程调用，decodeDiscard/takeKeyframeSkip在解码线程调用。
+class LatencyController {
+public:
+    LatencyController();
+
+    // targetMs为0时只测量不干预
+    void reset(int targetMs, AVRational timeBase);
+
+    void onPacketArrival(int64_t pts, int64_t nowUs);
+
+    // 重连后pts重新起算，丢弃旧的到达基准和平滑延迟；在解复用线程调用
+    void rebase();
+
+    // 返回呈现应采用的播放速率；needResync为true时调用方应清空已解码帧并重新锚定呈现时钟
+    double onFramePresented(int64_t pts, int64_t nowUs, double packetQueueFill, bool &needResync);
+
+    AVDiscard decodeDiscard() const;
+    bool takeKeyframeSkip();
+    void onPacketSkipped() { skippedPackets_++; }
+    void onFramesFlushed(uint64_t count) { flushedFrames_ += count; }
+
+    LatencyControlStats getStats() const;
+
+private:
+    int64_t toMicroseconds(int64_t pts) const;
+
+    AVRational timeBase_;
+    int64_t targetUs_;
+
+    // 解复用线程写
+    std::atomic<int64_t> baselineUs_; // "到达时刻 - pts"的下包络
+    int64_t lastArrivalUs_;
+
+    // 渲染线程写
+    std::atomic<double> effectiveLatencyUs_;
+    std::atomic<double> playbackRate_;
+    std::atomic<int> level_;
+    int64_t lastSkipUs_;
+
+    // 解码线程读取
+    std::atomic<bool> skipToKeyframe_;
+
+    std::atomic<uint64_t> keyframeSkips_;
+    std::atomic<uint64_t> skippedPackets_;
+    std::atomic<uint64_t> flushedFrames_;
+};
+
+#endif // LATENCY_CONTROLLER_H
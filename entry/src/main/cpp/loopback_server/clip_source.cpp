@@ -0,0 +1,156 @@
+#include "loopback_server/clip_source.h"
+#include "common/log.h"
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+extern "C" {
+#include <libavutil/time.h>
+}
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "ClipSource"
+
+namespace {
+// 等待发送时刻时单次休眠的上限，保证停止请求能及时响应
+const int64_t MAX_SLEEP_US = 10000;
+
+// 片段没有帧率信息时的默认帧率
+const AVRational DEFAULT_FRAME_RATE = {25, 1};
+} // namespace
+
+ClipSource::ClipSource(const std::string &path, bool loop)
+    : path_(path), loop_(loop), input_(nullptr), streamIndex_(-1), frameDuration_(0), firstDts_(AV_NOPTS_VALUE),
+      offset_(0), nextDts_(AV_NOPTS_VALUE), startUs_(0) {}
+
+ClipSource::~ClipSource() {
+    if (input_) {
+        avformat_close_input(&input_);
+    }
+}
+
+bool ClipSource::open() {
+    if (!openInput()) {
+        return false;
+    }
+    frameDuration_ = std::max<int64_t>(1, av_rescale_q(1, av_inv_q(frameRate()), timeBase()));
+    return true;
+}
+
+bool ClipSource::openInput() {
+    int ret = avformat_open_input(&input_, path_.c_str(), nullptr, nullptr);
+    if (ret < 0) {
+        char error_str[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, error_str, AV_ERROR_MAX_STRING_SIZE);
+        OH_LOG_ERROR(LOG_APP, "Failed to open clip %{public}s: %{public}s", path_.c_str(), error_str);
+        return false;
+    }
+    if (avformat_find_stream_info(input_, nullptr) < 0) {
+        OH_LOG_ERROR(LOG_APP, "Failed to find stream info in %{public}s", path_.c_str());
+        return false;
+    }
+    streamIndex_ = av_find_best_stream(input_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (streamIndex_ < 0) {
+        OH_LOG_ERROR(LOG_APP, "No video stream in %{public}s", path_.c_str());
+        return false;
+    }
+    return true;
+}
+
+const AVCodecParameters *ClipSource::codecParameters() const { return input_->streams[streamIndex_]->codecpar; }
+
+AVRational ClipSource::timeBase() const { return input_->streams[streamIndex_]->time_base; }
+
+AVRational ClipSource::frameRate() const {
+    AVRational rate = input_->streams[streamIndex_]->avg_frame_rate;
+    if (rate.num <= 0 || rate.den <= 0) {
+        rate = input_->streams[streamIndex_]->r_frame_rate;
+    }
+    return rate.num > 0 && rate.den > 0 ? rate : DEFAULT_FRAME_RATE;
+}
+
+bool ClipSource::rewind() {
+    // 输出时间轴从上一轮最后一个包之后继续
+    offset_ = nextDts_ - firstDts_;
+    if (av_seek_frame(input_, -1, 0, AVSEEK_FLAG_BACKWARD) >= 0) {
+        return true;
+    }
+    // 不支持定位的格式（如裸码流）重新打开
+    avformat_close_input(&input_);
+    return openInput();
+}
+
+bool ClipSource::waitUntil(int64_t dueUs, const std::atomic<bool> &stop) const {
+    while (!stop) {
+        int64_t remainingUs = dueUs - av_gettime_relative();
+        if (remainingUs <= 0) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min(remainingUs, MAX_SLEEP_US)));
+    }
+    return false;
+}
+
+bool ClipSource::next(AVPacket *packet, const std::atomic<bool> &stop) {
+    while (!stop) {
+        int ret = av_read_frame(input_, packet);
+        if (ret == AVERROR_EOF && loop_ && nextDts_ != AV_NOPTS_VALUE) {
+            if (!rewind()) {
+                return false;
+            }
+            continue;
+        }
+        if (ret < 0) {
+            return false;
+        }
+        if (packet->stream_index != streamIndex_) {
+            av_packet_unref(packet);
+            continue;
+        }
+
+        int64_t dts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+        if (dts == AV_NOPTS_VALUE) {
+            dts = nextDts_ != AV_NOPTS_VALUE ? nextDts_ - offset_ : 0;
+        }
+        if (firstDts_ == AV_NOPTS_VALUE) {
+            firstDts_ = dts;
+            startUs_ = av_gettime_relative();
+        }
+        int64_t ptsDelta = packet->pts != AV_NOPTS_VALUE ? packet->pts - dts : 0;
+        packet->dts = dts + offset_;
+        packet->pts = packet->dts + ptsDelta;
+        packet->stream_index = 0;
+        nextDts_ = packet->dts + (packet->duration > 0 ? packet->duration : frameDuration_);
+
+        int64_t dueUs = startUs_ + av_rescale_q(packet->dts - firstDts_, timeBase(), AVRational{1, AV_TIME_BASE});
+        if (!waitUntil(dueUs, stop)) {
+            av_packet_unref(packet);
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+const ClipCatalog::value_type *FindClip(const ClipCatalog &clips, const std::string &url) {
+    // 去掉协议和主机部分，只看路径
+    size_t pathStart = url.find("://");
+    pathStart = url.find('/', pathStart == std::string::npos ? 0 : pathStart + 3);
+    const ClipCatalog::value_type *found = nullptr;
+    while (pathStart != std::string::npos) {
+        size_t end = url.find_first_of("/?", pathStart + 1);
+        std::string component = url.substr(pathStart + 1, end == std::string::npos ? std::string::npos
+                                                                                   : end - pathStart - 1);
+        auto it = clips.find(component);
+        if (it != clips.end()) {
+            found = &*it;
+        }
+        if (end == std::string::npos || url[end] == '?') {
+            break;
+        }
+        pathStart = end;
+    }
+    return found;
+}
@@ -0,0 +1,56 @@
+#ifndef LOOPBACK_CLIP_SOURCE_H
+#define LOOPBACK_CLIP_SOURCE_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+// 录制片段的视频数据包源，每个会话各持有一个。
+// 按dts以实时速率交出数据包；循环模式下读到结尾后回到开头继续，时间戳在上一轮之后连续递增，
+// 对客户端表现为一路不间断的直播流。
+class ClipSource {
+public:
+    ClipSource(const std::string &path, bool loop);
+    ~ClipSource();
+
+    ClipSource(const ClipSource &) = delete;
+    ClipSource &operator=(const ClipSource &) = delete;
+
+    bool open();
+
+    const AVCodecParameters *codecParameters() const;
+    AVRational timeBase() const;
+    AVRational frameRate() const;
+
+    // 取下一个视频包，阻塞到它的发送时刻，时间戳为timeBase()。
+    // 片段结束（非循环）、读取出错或stop置位时返回false
+    bool next(AVPacket *packet, const std::atomic<bool> &stop);
+
+private:
+    bool openInput();
+    bool rewind();
+    bool waitUntil(int64_t dueUs, const std::atomic<bool> &stop) const;
+
+    std::string path_;
+    bool loop_;
+    AVFormatContext *input_;
+    int streamIndex_;
+    int64_t frameDuration_; // 数据包没有时长时的默认帧间隔
+    int64_t firstDts_;      // 片段中第一个包的dts
+    int64_t offset_;        // 加到读出时间戳上的偏移，循环时累加
+    int64_t nextDts_;       // 输出时间轴上下一个包的预计dts
+    int64_t startUs_;       // 第一个包发送时的本地时钟
+};
+
+// 片段名到文件路径，名称即URL路径中的流名
+using ClipCatalog = std::map<std::string, std::string>;
+
+// 在URL路径的各级中找出最后一个已登记的片段，找不到时返回nullptr
+const ClipCatalog::value_type *FindClip(const ClipCatalog &clips, const std::string &url);
+
+#endif // LOOPBACK_CLIP_SOURCE_H
@@ -0,0 +1,140 @@
+// 本地回环流媒体服务端，用于压测和回归测试。
+// 把本地视频文件按实时速率以RTSP和RTMP提供给播放器，可同时服务多个连接，
+// 配合decode_benchmark或应用本身模拟多路宫格拉流，不依赖外部摄像头或推流服务。
+//
+// 用法：loopback_server [选项] <name=path | path>...
+//   不带名称时以文件名（去掉扩展名）作为流名称
+//   --bind ADDR        监听地址，默认127.0.0.1
+//   --rtsp-port N      RTSP端口，默认8554，0表示不启用
+//   --rtmp-port N      RTMP端口，默认1935，0表示不启用
+//   --once             片段播完即结束该连接，默认循环播放
+//   --verbose          输出每个连接的INFO日志
+
+#include "common/log.h"
+#include "loopback_server/rtmp_server.h"
+#include "loopback_server/rtsp_server.h"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace {
+const uint16_t DEFAULT_RTSP_PORT = 8554;
+const uint16_t DEFAULT_RTMP_PORT = 1935;
+
+// 检查退出信号和连接数变化的间隔
+const auto POLL_INTERVAL = std::chrono::milliseconds(200);
+
+std::atomic<bool> g_exitRequested{false};
+
+struct ServerConfig {
+    std::string bindAddress = "127.0.0.1";
+    int rtspPort = DEFAULT_RTSP_PORT;
+    int rtmpPort = DEFAULT_RTMP_PORT;
+    bool loop = true;
+    bool verbose = false;
+    ClipCatalog clips;
+};
+
+void OnSignal(int) { g_exitRequested = true; }
+
+void PrintUsage(const char *program) {
+    fprintf(stderr,
+            "Usage: %s [--bind ADDR] [--rtsp-port N] [--rtmp-port N] [--once] [--verbose] <name=path | path>...\n",
+            program);
+}
+
+// /videos/cam1.mp4 -> cam1
+std::string ClipNameFromPath(const std::string &path) {
+    size_t slash = path.find_last_of('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return dot == std::string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+bool ParseArguments(int argc, char **argv, ServerConfig &config) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--bind" && hasValue) {
+            config.bindAddress = argv[++i];
+        } else if (arg == "--rtsp-port" && hasValue) {
+            config.rtspPort = atoi(argv[++i]);
+        } else if (arg == "--rtmp-port" && hasValue) {
+            config.rtmpPort = atoi(argv[++i]);
+        } else if (arg == "--once") {
+            config.loop = false;
+        } else if (arg == "--verbose") {
+            config.verbose = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            return false;
+        } else {
+            size_t equals = arg.find('=');
+            if (equals != std::string::npos) {
+                config.clips[arg.substr(0, equals)] = arg.substr(equals + 1);
+            } else {
+                config.clips[ClipNameFromPath(arg)] = arg;
+            }
+        }
+    }
+    bool validPorts = config.rtspPort >= 0 && config.rtspPort <= 65535 && config.rtmpPort >= 0 &&
+                      config.rtmpPort <= 65535 && (config.rtspPort > 0 || config.rtmpPort > 0);
+    return validPorts && !config.clips.empty();
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    ServerConfig config;
+    if (!ParseArguments(argc, argv, config)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    HostLogSetLevel(config.verbose ? LOG_INFO : LOG_WARN);
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    // 客户端断开后继续写入不应终止进程
+    signal(SIGPIPE, SIG_IGN);
+
+    RtspServer rtsp(config.clips, config.loop);
+    RtmpServer rtmp(config.clips, config.loop);
+    if (config.rtspPort > 0 && !rtsp.start(config.bindAddress, static_cast<uint16_t>(config.rtspPort))) {
+        fprintf(stderr, "Failed to listen on %s:%d for RTSP\n", config.bindAddress.c_str(), config.rtspPort);
+        return 1;
+    }
+    if (config.rtmpPort > 0 && !rtmp.start(config.bindAddress, static_cast<uint16_t>(config.rtmpPort))) {
+        fprintf(stderr, "Failed to listen on %s:%d for RTMP\n", config.bindAddress.c_str(), config.rtmpPort);
+        return 1;
+    }
+
+    printf("Streams (%s):\n", config.loop ? "looping" : "play once");
+    for (const auto &clip : config.clips) {
+        printf("  %s <- %s\n", clip.first.c_str(), clip.second.c_str());
+        if (config.rtspPort > 0) {
+            printf("    rtsp://%s:%d/%s\n", config.bindAddress.c_str(), config.rtspPort, clip.first.c_str());
+        }
+        if (config.rtmpPort > 0) {
+            printf("    rtmp://%s:%d/live/%s\n", config.bindAddress.c_str(), config.rtmpPort, clip.first.c_str());
+        }
+    }
+    fflush(stdout);
+
+    size_t lastConnections = 0;
+    while (!g_exitRequested) {
+        std::this_thread::sleep_for(POLL_INTERVAL);
+        size_t connections = rtsp.getActiveConnections() + rtmp.getActiveConnections();
+        if (connections != lastConnections) {
+            printf("Active connections: %zu (rtsp %zu, rtmp %zu)\n", connections, rtsp.getActiveConnections(),
+                   rtmp.getActiveConnections());
+            fflush(stdout);
+            lastConnections = connections;
+        }
+    }
+
+    printf("Shutting down\n");
+    rtsp.stop();
+    rtmp.stop();
+    return 0;
+}
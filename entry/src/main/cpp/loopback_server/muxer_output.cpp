@@ -0,0 +1,107 @@
+#include "loopback_server/muxer_output.h"
+#include "common/log.h"
+#include "loopback_server/clip_source.h"
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "MuxerOutput"
+
+namespace {
+// 没有包大小限制时的AVIO缓冲区大小
+const int DEFAULT_BUFFER_SIZE = 64 * 1024;
+} // namespace
+
+MuxerOutput::MuxerOutput(const char *formatName, WriteCallback callback)
+    : formatName_(formatName), callback_(std::move(callback)), context_(nullptr), headerWritten_(false),
+      failed_(false) {}
+
+MuxerOutput::~MuxerOutput() { close(); }
+
+bool MuxerOutput::open(const ClipSource &source, int packetSize) {
+    if (avformat_alloc_output_context2(&context_, nullptr, formatName_, nullptr) < 0 || !context_) {
+        OH_LOG_ERROR(LOG_APP, "Failed to allocate %{public}s muxer", formatName_);
+        return false;
+    }
+    AVStream *stream = avformat_new_stream(context_, nullptr);
+    if (!stream || avcodec_parameters_copy(stream->codecpar, source.codecParameters()) < 0) {
+        return false;
+    }
+    // 容器里的codec_tag（如mp4的avc1）对其他复用器无效，由复用器按codec_id重新选择
+    stream->codecpar->codec_tag = 0;
+    stream->time_base = source.timeBase();
+
+    int bufferSize = packetSize > 0 ? packetSize : DEFAULT_BUFFER_SIZE;
+    uint8_t *buffer = static_cast<uint8_t *>(av_malloc(bufferSize));
+    if (!buffer) {
+        return false;
+    }
+    context_->pb = avio_alloc_context(buffer, bufferSize, 1, this, nullptr, &MuxerOutput::writePacket, nullptr);
+    if (!context_->pb) {
+        av_free(buffer);
+        return false;
+    }
+    if (packetSize > 0) {
+        context_->pb->max_packet_size = packetSize;
+        context_->packet_size = packetSize;
+    }
+
+    int ret = avformat_write_header(context_, nullptr);
+    if (ret < 0) {
+        char error_str[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, error_str, AV_ERROR_MAX_STRING_SIZE);
+        OH_LOG_ERROR(LOG_APP, "Failed to write %{public}s header: %{public}s", formatName_, error_str);
+        return false;
+    }
+    headerWritten_ = true;
+    avio_flush(context_->pb);
+    return !failed_;
+}
+
+bool MuxerOutput::write(AVPacket *packet, AVRational timeBase) {
+    if (!headerWritten_ || failed_) {
+        av_packet_unref(packet);
+        return false;
+    }
+    AVStream *stream = context_->streams[0];
+    av_packet_rescale_ts(packet, timeBase, stream->time_base);
+    packet->stream_index = stream->index;
+    int ret = av_write_frame(context_, packet);
+    av_packet_unref(packet);
+    if (ret < 0) {
+        return false;
+    }
+    avio_flush(context_->pb);
+    return !failed_;
+}
+
+void MuxerOutput::close() {
+    if (!context_) {
+        return;
+    }
+    if (headerWritten_ && !failed_) {
+        av_write_trailer(context_);
+        avio_flush(context_->pb);
+    }
+    if (context_->pb) {
+        av_freep(&context_->pb->buffer);
+        avio_context_free(&context_->pb);
+    }
+    avformat_free_context(context_);
+    context_ = nullptr;
+    headerWritten_ = false;
+}
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+int MuxerOutput::writePacket(void *opaque, const uint8_t *buf, int size)
+#else
+int MuxerOutput::writePacket(void *opaque, uint8_t *buf, int size)
+#endif
+{
+    auto *output = static_cast<MuxerOutput *>(opaque);
+    if (output->failed_ || !output->callback_(buf, static_cast<size_t>(size))) {
+        output->failed_ = true;
+        return AVERROR(EIO);
+    }
+    return size;
+}
@@ -0,0 +1,49 @@
+#ifndef LOOPBACK_MUXER_OUTPUT_H
+#define LOOPBACK_MUXER_OUTPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+class ClipSource;
+
+// 把libavformat复用器（rtp、flv）的输出交给回调，由会话自己决定如何发送。
+// 每写入一个数据包后刷新一次：rtp复用器每次回调恰好是一个RTP/RTCP包，flv复用器是若干完整或部分的FLV tag。
+class MuxerOutput {
+public:
+    // 返回false表示发送失败，之后的写入都会失败
+    using WriteCallback = std::function<bool(const uint8_t *data, size_t size)>;
+
+    MuxerOutput(const char *formatName, WriteCallback callback);
+    ~MuxerOutput();
+
+    MuxerOutput(const MuxerOutput &) = delete;
+    MuxerOutput &operator=(const MuxerOutput &) = delete;
+
+    // 按片段的编码参数添加唯一的视频流并写入头部。packetSize大于0时限制单次输出的大小（RTP的MTU）
+    bool open(const ClipSource &source, int packetSize);
+
+    // packet的时间戳为timeBase，写入后packet被清空
+    bool write(AVPacket *packet, AVRational timeBase);
+
+    void close();
+
+private:
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+    static int writePacket(void *opaque, const uint8_t *buf, int size);
+#else
+    static int writePacket(void *opaque, uint8_t *buf, int size);
+#endif
+
+    const char *formatName_;
+    WriteCallback callback_;
+    AVFormatContext *context_;
+    bool headerWritten_;
+    bool failed_;
+};
+
+#endif // LOOPBACK_MUXER_OUTPUT_H
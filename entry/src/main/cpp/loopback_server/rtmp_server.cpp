@@ -0,0 +1,611 @@
+#include "loopback_server/rtmp_server.h"
+#include "common/log.h"
+#include "loopback_server/muxer_output.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "RtmpServer"
+
+namespace {
+const uint8_t RTMP_VERSION = 3;
+const size_t HANDSHAKE_SIZE = 1536;
+
+// 消息类型
+const uint8_t MSG_SET_CHUNK_SIZE = 1;
+const uint8_t MSG_USER_CONTROL = 4;
+const uint8_t MSG_WINDOW_ACK_SIZE = 5;
+const uint8_t MSG_SET_PEER_BANDWIDTH = 6;
+const uint8_t MSG_COMMAND_AMF0 = 20;
+
+// 块流ID：协议控制、命令应答、状态通知和媒体数据
+const uint8_t CSID_CONTROL = 2;
+const uint8_t CSID_COMMAND = 3;
+const uint8_t CSID_STATUS = 5;
+const uint8_t CSID_MEDIA = 6;
+
+// createStream返回的消息流ID，每个连接只有一路播放
+const uint32_t MEDIA_STREAM_ID = 1;
+
+const uint32_t DEFAULT_CHUNK_SIZE = 128;
+const uint32_t OUTPUT_CHUNK_SIZE = 4096;
+const uint32_t WINDOW_ACK_SIZE = 2500000;
+const uint8_t PEER_BANDWIDTH_DYNAMIC = 2;
+const uint16_t USER_CONTROL_STREAM_BEGIN = 0;
+
+// 协议规定的24位时间戳上限，超过时改用扩展时间戳
+const uint32_t EXTENDED_TIMESTAMP = 0xFFFFFF;
+
+// 单条客户端消息的长度上限，客户端只发送命令和控制消息
+const uint32_t MAX_MESSAGE_SIZE = 1024 * 1024;
+
+// FLV文件头（9字节）加第一个PreviousTagSize（4字节）
+const size_t FLV_HEADER_SIZE = 13;
+const size_t FLV_TAG_HEADER_SIZE = 11;
+const size_t FLV_TAG_TRAILER_SIZE = 4;
+
+enum Amf0Type : uint8_t {
+    AMF0_NUMBER = 0x00,
+    AMF0_BOOLEAN = 0x01,
+    AMF0_STRING = 0x02,
+    AMF0_OBJECT = 0x03,
+    AMF0_NULL = 0x05,
+    AMF0_UNDEFINED = 0x06,
+    AMF0_ECMA_ARRAY = 0x08,
+    AMF0_OBJECT_END = 0x09,
+    AMF0_STRICT_ARRAY = 0x0A,
+    AMF0_LONG_STRING = 0x0C,
+};
+
+void PutBe16(std::vector<uint8_t> &out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void PutBe24(std::vector<uint8_t> &out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    PutBe16(out, value);
+}
+
+void PutBe32(std::vector<uint8_t> &out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    PutBe24(out, value);
+}
+
+uint32_t GetBe(const uint8_t *data, int bytes) {
+    uint32_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+// 只覆盖服务端应答用到的AMF0类型
+class Amf0Writer {
+public:
+    void number(double value) {
+        data.push_back(AMF0_NUMBER);
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            data.push_back(static_cast<uint8_t>(bits >> shift));
+        }
+    }
+
+    void boolean(bool value) {
+        data.push_back(AMF0_BOOLEAN);
+        data.push_back(value ? 1 : 0);
+    }
+
+    void string(const std::string &value) {
+        data.push_back(AMF0_STRING);
+        key(value);
+    }
+
+    void null() { data.push_back(AMF0_NULL); }
+
+    void objectBegin() { data.push_back(AMF0_OBJECT); }
+
+    // 对象属性名，随后写属性值
+    void key(const std::string &name) {
+        PutBe16(data, static_cast<uint32_t>(name.size()));
+        data.insert(data.end(), name.begin(), name.end());
+    }
+
+    void objectEnd() {
+        PutBe16(data, 0);
+        data.push_back(AMF0_OBJECT_END);
+    }
+
+    std::vector<uint8_t> data;
+};
+
+class Amf0Reader {
+public:
+    explicit Amf0Reader(const std::vector<uint8_t> &data) : data_(data), pos_(0) {}
+
+    bool readString(std::string &value) {
+        if (!has(1) || data_[pos_] != AMF0_STRING || !has(3)) {
+            return false;
+        }
+        size_t length = GetBe(&data_[pos_ + 1], 2);
+        if (!has(3 + length)) {
+            return false;
+        }
+        value.assign(reinterpret_cast<const char *>(&data_[pos_ + 3]), length);
+        pos_ += 3 + length;
+        return true;
+    }
+
+    bool readNumber(double &value) {
+        if (!has(9) || data_[pos_] != AMF0_NUMBER) {
+            return false;
+        }
+        uint64_t bits = 0;
+        for (int i = 1; i <= 8; i++) {
+            bits = (bits << 8) | data_[pos_ + i];
+        }
+        memcpy(&value, &bits, sizeof(value));
+        pos_ += 9;
+        return true;
+    }
+
+    bool skip() {
+        if (!has(1)) {
+            return false;
+        }
+        uint8_t type = data_[pos_++];
+        switch (type) {
+        case AMF0_NUMBER:
+            return advance(8);
+        case AMF0_BOOLEAN:
+            return advance(1);
+        case AMF0_STRING:
+            return has(2) && advance(2 + GetBe(&data_[pos_], 2));
+        case AMF0_LONG_STRING:
+            return has(4) && advance(4 + GetBe(&data_[pos_], 4));
+        case AMF0_NULL:
+        case AMF0_UNDEFINED:
+            return true;
+        case AMF0_ECMA_ARRAY:
+            return advance(4) && skipProperties();
+        case AMF0_OBJECT:
+            return skipProperties();
+        case AMF0_STRICT_ARRAY: {
+            if (!has(4)) {
+                return false;
+            }
+            uint32_t count = GetBe(&data_[pos_], 4);
+            pos_ += 4;
+            for (uint32_t i = 0; i < count; i++) {
+                if (!skip()) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+private:
+    bool has(size_t bytes) const { return pos_ + bytes <= data_.size(); }
+
+    bool advance(size_t bytes) {
+        if (!has(bytes)) {
+            return false;
+        }
+        pos_ += bytes;
+        return true;
+    }
+
+    // 键值对直到空键和对象结束标记
+    bool skipProperties() {
+        while (has(3)) {
+            size_t length = GetBe(&data_[pos_], 2);
+            if (length == 0 && data_[pos_ + 2] == AMF0_OBJECT_END) {
+                pos_ += 3;
+                return true;
+            }
+            if (!advance(2 + length) || !skip()) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<uint8_t> &data_;
+    size_t pos_;
+};
+
+struct RtmpMessage {
+    uint8_t type = 0;
+    uint32_t streamId = 0;
+    std::vector<uint8_t> payload;
+};
+
+// 一个RTMP连接。命令在连接线程中处理，play之后由单独的线程按实时速率发送媒体消息
+class RtmpSession {
+public:
+    RtmpSession(int fd, const ClipCatalog &clips, bool loop);
+    ~RtmpSession();
+
+    void run();
+
+private:
+    // 每个块流上正在接收的消息
+    struct ChunkStream {
+        uint32_t length = 0;
+        uint8_t type = 0;
+        uint32_t streamId = 0;
+        bool extendedTimestamp = false;
+        std::vector<uint8_t> buffer;
+    };
+
+    bool handshake();
+    bool readMessage(RtmpMessage &message);
+    bool handleCommand(const RtmpMessage &message);
+    bool sendMessage(uint8_t csid, uint8_t type, uint32_t streamId, uint32_t timestamp, const uint8_t *payload,
+                     size_t size);
+    bool sendMessage(uint8_t csid, uint8_t type, uint32_t streamId, const std::vector<uint8_t> &payload);
+    bool sendControl(uint8_t type, const std::vector<uint8_t> &payload);
+    bool sendStatus(const char *level, const char *code, const std::string &description);
+    bool play(const std::string &streamName);
+    bool onFlvData(const uint8_t *data, size_t size);
+    void startStreaming();
+    void stopStreaming();
+    void streamLoop();
+
+    int fd_;
+    const ClipCatalog &clips_;
+    bool loop_;
+    uint32_t inChunkSize_;
+    uint32_t outChunkSize_;
+    std::map<uint32_t, ChunkStream> chunkStreams_;
+    std::string clipName_;
+    std::unique_ptr<ClipSource> source_;
+
+    std::vector<uint8_t> flvBuffer_; // flv复用器输出中尚未凑成完整tag的部分
+    bool flvHeaderSkipped_;
+
+    std::mutex sendMutex_; // 命令应答和媒体消息共用连接
+    std::thread streamThread_;
+    std::atomic<bool> streamStop_;
+};
+
+RtmpSession::RtmpSession(int fd, const ClipCatalog &clips, bool loop)
+    : fd_(fd), clips_(clips), loop_(loop), inChunkSize_(DEFAULT_CHUNK_SIZE), outChunkSize_(DEFAULT_CHUNK_SIZE),
+      flvHeaderSkipped_(false), streamStop_(false) {}
+
+RtmpSession::~RtmpSession() { stopStreaming(); }
+
+void RtmpSession::run() {
+    if (!handshake()) {
+        return;
+    }
+    RtmpMessage message;
+    while (readMessage(message)) {
+        if (message.type == MSG_SET_CHUNK_SIZE && message.payload.size() >= 4) {
+            inChunkSize_ = std::max<uint32_t>(1, GetBe(message.payload.data(), 4) & 0x7FFFFFFF);
+        } else if (message.type == MSG_COMMAND_AMF0 && !handleCommand(message)) {
+            break;
+        }
+        // 确认、用户控制（如SetBufferLength）等消息不需要处理
+    }
+    stopStreaming();
+    if (!clipName_.empty()) {
+        OH_LOG_INFO(LOG_APP, "Session for %{public}s closed", clipName_.c_str());
+    }
+}
+
+bool RtmpSession::handshake() {
+    // C0C1 -> S0S1S2 -> C2。S1的版本字段为0表示简单握手，客户端不校验摘要
+    std::vector<uint8_t> c0c1(1 + HANDSHAKE_SIZE);
+    if (!RecvAll(fd_, c0c1.data(), c0c1.size()) || c0c1[0] != RTMP_VERSION) {
+        return false;
+    }
+    std::vector<uint8_t> response(1 + 2 * HANDSHAKE_SIZE, 0);
+    response[0] = RTMP_VERSION;
+    std::minstd_rand random(static_cast<uint32_t>(fd_));
+    for (size_t i = 1 + 8; i < 1 + HANDSHAKE_SIZE; i++) {
+        response[i] = static_cast<uint8_t>(random());
+    }
+    std::copy(c0c1.begin() + 1, c0c1.end(), response.begin() + 1 + HANDSHAKE_SIZE);
+    if (!SendAll(fd_, response.data(), response.size())) {
+        return false;
+    }
+    std::vector<uint8_t> c2(HANDSHAKE_SIZE);
+    return RecvAll(fd_, c2.data(), c2.size());
+}
+
+bool RtmpSession::readMessage(RtmpMessage &message) {
+    // 块格式0-3对应的消息头长度
+    static const size_t HEADER_SIZES[4] = {11, 7, 3, 0};
+    while (true) {
+        uint8_t basic[3];
+        if (!RecvAll(fd_, basic, 1)) {
+            return false;
+        }
+        int format = basic[0] >> 6;
+        uint32_t csid = basic[0] & 0x3F;
+        if (csid == 0) {
+            if (!RecvAll(fd_, basic + 1, 1)) {
+                return false;
+            }
+            csid = 64 + basic[1];
+        } else if (csid == 1) {
+            if (!RecvAll(fd_, basic + 1, 2)) {
+                return false;
+            }
+            csid = 64 + basic[1] + (basic[2] << 8);
+        }
+
+        ChunkStream &stream = chunkStreams_[csid];
+        uint8_t header[11];
+        if (!RecvAll(fd_, header, HEADER_SIZES[format])) {
+            return false;
+        }
+        if (format <= 2) {
+            stream.extendedTimestamp = GetBe(header, 3) == EXTENDED_TIMESTAMP;
+        }
+        if (format <= 1) {
+            stream.length = GetBe(header + 3, 3);
+            stream.type = header[6];
+        }
+        if (format == 0) {
+            stream.streamId = header[7] | (header[8] << 8) | (header[9] << 16) | (static_cast<uint32_t>(header[10]) << 24);
+        }
+        // 时间戳对服务端没有用处，扩展时间戳读出后丢弃
+        if (stream.extendedTimestamp) {
+            uint8_t extended[4];
+            if (!RecvAll(fd_, extended, sizeof(extended))) {
+                return false;
+            }
+        }
+        if (stream.length > MAX_MESSAGE_SIZE) {
+            OH_LOG_WARN(LOG_APP, "Message of %{public}u bytes too large, closing connection", stream.length);
+            return false;
+        }
+
+        size_t received = stream.buffer.size();
+        size_t chunk = std::min<size_t>(inChunkSize_, stream.length - received);
+        stream.buffer.resize(received + chunk);
+        if (chunk > 0 && !RecvAll(fd_, stream.buffer.data() + received, chunk)) {
+            return false;
+        }
+        if (stream.buffer.size() >= stream.length) {
+            message.type = stream.type;
+            message.streamId = stream.streamId;
+            message.payload.swap(stream.buffer);
+            stream.buffer.clear();
+            return true;
+        }
+    }
+}
+
+bool RtmpSession::sendMessage(uint8_t csid, uint8_t type, uint32_t streamId, uint32_t timestamp,
+                              const uint8_t *payload, size_t size) {
+    // 每条消息都用格式0的完整消息头，后续分块用格式3
+    bool extended = timestamp >= EXTENDED_TIMESTAMP;
+    std::vector<uint8_t> out;
+    out.reserve(size + 16 + 5 * (size / outChunkSize_));
+    out.push_back(csid);
+    PutBe24(out, extended ? EXTENDED_TIMESTAMP : timestamp);
+    PutBe24(out, static_cast<uint32_t>(size));
+    out.push_back(type);
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<uint8_t>(streamId >> shift));
+    }
+    if (extended) {
+        PutBe32(out, timestamp);
+    }
+    size_t offset = 0;
+    do {
+        if (offset > 0) {
+            out.push_back(static_cast<uint8_t>(0xC0 | csid));
+            if (extended) {
+                PutBe32(out, timestamp);
+            }
+        }
+        size_t chunk = std::min<size_t>(outChunkSize_, size - offset);
+        out.insert(out.end(), payload + offset, payload + offset + chunk);
+        offset += chunk;
+    } while (offset < size);
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    return SendAll(fd_, out.data(), out.size());
+}
+
+bool RtmpSession::sendMessage(uint8_t csid, uint8_t type, uint32_t streamId, const std::vector<uint8_t> &payload) {
+    return sendMessage(csid, type, streamId, 0, payload.data(), payload.size());
+}
+
+bool RtmpSession::sendControl(uint8_t type, const std::vector<uint8_t> &payload) {
+    return sendMessage(CSID_CONTROL, type, 0, payload);
+}
+
+bool RtmpSession::sendStatus(const char *level, const char *code, const std::string &description) {
+    Amf0Writer status;
+    status.string("onStatus");
+    status.number(0);
+    status.null();
+    status.objectBegin();
+    status.key("level");
+    status.string(level);
+    status.key("code");
+    status.string(code);
+    status.key("description");
+    status.string(description);
+    status.objectEnd();
+    return sendMessage(CSID_STATUS, MSG_COMMAND_AMF0, MEDIA_STREAM_ID, status.data);
+}
+
+bool RtmpSession::handleCommand(const RtmpMessage &message) {
+    Amf0Reader reader(message.payload);
+    std::string command;
+    double transactionId = 0;
+    if (!reader.readString(command) || !reader.readNumber(transactionId)) {
+        return true;
+    }
+
+    if (command == "connect") {
+        std::vector<uint8_t> payload;
+        PutBe32(payload, WINDOW_ACK_SIZE);
+        sendControl(MSG_WINDOW_ACK_SIZE, payload);
+        payload.push_back(PEER_BANDWIDTH_DYNAMIC);
+        sendControl(MSG_SET_PEER_BANDWIDTH, payload);
+        payload.clear();
+        PutBe32(payload, OUTPUT_CHUNK_SIZE);
+        sendControl(MSG_SET_CHUNK_SIZE, payload);
+        outChunkSize_ = OUTPUT_CHUNK_SIZE;
+
+        Amf0Writer result;
+        result.string("_result");
+        result.number(transactionId);
+        result.objectBegin();
+        result.key("fmsVer");
+        result.string("FMS/3,0,1,123");
+        result.key("capabilities");
+        result.number(31);
+        result.objectEnd();
+        result.objectBegin();
+        result.key("level");
+        result.string("status");
+        result.key("code");
+        result.string("NetConnection.Connect.Success");
+        result.key("description");
+        result.string("Connection succeeded.");
+        result.key("objectEncoding");
+        result.number(0);
+        result.objectEnd();
+        return sendMessage(CSID_COMMAND, MSG_COMMAND_AMF0, 0, result.data);
+    }
+    if (command == "createStream") {
+        Amf0Writer result;
+        result.string("_result");
+        result.number(transactionId);
+        result.null();
+        result.number(MEDIA_STREAM_ID);
+        return sendMessage(CSID_COMMAND, MSG_COMMAND_AMF0, 0, result.data);
+    }
+    if (command == "play") {
+        std::string streamName;
+        if (!reader.skip() || !reader.readString(streamName)) {
+            return false;
+        }
+        return play(streamName);
+    }
+    if (command == "deleteStream" || command == "closeStream") {
+        stopStreaming();
+        return false;
+    }
+    // releaseStream、getStreamLength、_checkbw等可选命令不应答
+    return true;
+}
+
+bool RtmpSession::play(const std::string &streamName) {
+    if (streamThread_.joinable()) {
+        return true;
+    }
+    // 流名可能带查询参数，如cam1?token=...
+    std::string name = streamName.substr(0, streamName.find('?'));
+    const ClipCatalog::value_type *clip = FindClip(clips_, "/" + name);
+    auto source = clip ? std::make_unique<ClipSource>(clip->second, loop_) : nullptr;
+    if (!source || !source->open()) {
+        OH_LOG_WARN(LOG_APP, "No clip for stream %{public}s", streamName.c_str());
+        sendStatus("error", "NetStream.Play.StreamNotFound", "No such stream: " + streamName);
+        return false;
+    }
+    clipName_ = clip->first;
+    source_ = std::move(source);
+
+    std::vector<uint8_t> streamBegin;
+    PutBe16(streamBegin, USER_CONTROL_STREAM_BEGIN);
+    PutBe32(streamBegin, MEDIA_STREAM_ID);
+    if (!sendControl(MSG_USER_CONTROL, streamBegin) ||
+        !sendStatus("status", "NetStream.Play.Start", "Started playing " + clipName_)) {
+        return false;
+    }
+    startStreaming();
+    return true;
+}
+
+bool RtmpSession::onFlvData(const uint8_t *data, size_t size) {
+    flvBuffer_.insert(flvBuffer_.end(), data, data + size);
+    size_t pos = 0;
+    if (!flvHeaderSkipped_) {
+        if (flvBuffer_.size() < FLV_HEADER_SIZE) {
+            return true;
+        }
+        pos = FLV_HEADER_SIZE;
+        flvHeaderSkipped_ = true;
+    }
+    // 每个FLV tag（脚本数据、视频）的类型、时间戳和数据原样作为一条RTMP消息
+    while (flvBuffer_.size() - pos >= FLV_TAG_HEADER_SIZE) {
+        const uint8_t *tag = &flvBuffer_[pos];
+        size_t dataSize = GetBe(tag + 1, 3);
+        if (flvBuffer_.size() - pos < FLV_TAG_HEADER_SIZE + dataSize + FLV_TAG_TRAILER_SIZE) {
+            break;
+        }
+        uint8_t type = tag[0] & 0x1F;
+        uint32_t timestamp = GetBe(tag + 4, 3) | (static_cast<uint32_t>(tag[7]) << 24);
+        if (!sendMessage(CSID_MEDIA, type, MEDIA_STREAM_ID, timestamp, tag + FLV_TAG_HEADER_SIZE, dataSize)) {
+            return false;
+        }
+        pos += FLV_TAG_HEADER_SIZE + dataSize + FLV_TAG_TRAILER_SIZE;
+    }
+    flvBuffer_.erase(flvBuffer_.begin(), flvBuffer_.begin() + pos);
+    return true;
+}
+
+void RtmpSession::startStreaming() {
+    streamStop_ = false;
+    streamThread_ = std::thread(&RtmpSession::streamLoop, this);
+}
+
+void RtmpSession::stopStreaming() {
+    streamStop_ = true;
+    if (streamThread_.joinable()) {
+        streamThread_.join();
+    }
+}
+
+void RtmpSession::streamLoop() {
+    OH_LOG_INFO(LOG_APP, "Streaming %{public}s", clipName_.c_str());
+    MuxerOutput output("flv", [this](const uint8_t *data, size_t size) { return onFlvData(data, size); });
+    AVPacket *packet = av_packet_alloc();
+    bool ok = packet && output.open(*source_, 0);
+    while (ok && source_->next(packet, streamStop_)) {
+        ok = output.write(packet, source_->timeBase());
+    }
+    av_packet_free(&packet);
+    output.close();
+
+    // 片段播完或发送失败：通知客户端停止并关闭连接
+    if (!streamStop_) {
+        if (ok) {
+            sendStatus("status", "NetStream.Play.Stop", "Stopped playing " + clipName_);
+        }
+        shutdown(fd_, SHUT_RDWR);
+    }
+}
+} // namespace
+
+RtmpServer::RtmpServer(const ClipCatalog &clips, bool loop) : clips_(clips), loop_(loop) {}
+
+RtmpServer::~RtmpServer() { stop(); }
+
+void RtmpServer::serve(int fd) {
+    RtmpSession session(fd, clips_, loop_);
+    session.run();
+}
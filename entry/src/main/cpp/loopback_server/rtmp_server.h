@@ -0,0 +1,23 @@
+#ifndef LOOPBACK_RTMP_SERVER_H
+#define LOOPBACK_RTMP_SERVER_H
+
+#include "loopback_server/clip_source.h"
+#include "loopback_server/tcp_server.h"
+
+// 最小RTMP服务端，只支持拉流播放：简单握手，应答connect、createStream和play，
+// 之后把libavformat的flv复用器输出的FLV tag逐个作为RTMP消息发送。
+// URL形如rtmp://host:port/<app>/<片段名>，app不做区分。
+class RtmpServer : public TcpServer {
+public:
+    RtmpServer(const ClipCatalog &clips, bool loop);
+    ~RtmpServer() override;
+
+protected:
+    void serve(int fd) override;
+
+private:
+    const ClipCatalog clips_;
+    bool loop_;
+};
+
+#endif // LOOPBACK_RTMP_SERVER_H
@@ -0,0 +1,440 @@
+#include "loopback_server/rtsp_server.h"
+#include "common/log.h"
+#include "loopback_server/clip_source.h"
+#include "loopback_server/muxer_output.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "RtspServer"
+
+namespace {
+// RTP包大小上限，UDP传输时不超过以太网MTU
+const int RTP_PACKET_SIZE = 1400;
+
+// RTCP包类型范围（SR到APP），用于区分复用器输出的RTP和RTCP
+const uint8_t RTCP_TYPE_FIRST = 200;
+const uint8_t RTCP_TYPE_LAST = 204;
+
+// 请求头部的长度上限
+const size_t MAX_REQUEST_SIZE = 16 * 1024;
+
+const size_t SDP_MAX_SIZE = 4096;
+
+// 客户端应在该时间内发送保活请求
+const char *SESSION_TIMEOUT = "60";
+
+std::atomic<unsigned> g_nextSessionId{0x10000};
+
+struct RtspRequest {
+    std::string method;
+    std::string url;
+    std::map<std::string, std::string> headers; // 键为小写
+};
+
+std::string ToLower(std::string text) {
+    for (char &c : text) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return text;
+}
+
+std::string Trim(const std::string &text) {
+    size_t begin = text.find_first_not_of(" \t");
+    size_t end = text.find_last_not_of(" \t\r");
+    return begin == std::string::npos ? "" : text.substr(begin, end - begin + 1);
+}
+
+// 解析Transport头中形如key=a-b的端口或通道对
+bool ParseRange(const std::string &transport, const char *key, int &first, int &second) {
+    size_t pos = transport.find(key);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    pos += strlen(key);
+    if (sscanf(transport.c_str() + pos, "%d-%d", &first, &second) == 2) {
+        return true;
+    }
+    if (sscanf(transport.c_str() + pos, "%d", &first) == 1) {
+        second = first + 1;
+        return true;
+    }
+    return false;
+}
+
+// 一个RTSP连接。控制请求在连接线程中处理，PLAY之后由单独的线程按实时速率发送RTP
+class RtspSession {
+public:
+    RtspSession(int fd, const ClipCatalog &clips, bool loop);
+    ~RtspSession();
+
+    void run();
+
+private:
+    bool readRequest(RtspRequest &request);
+    bool handle(const RtspRequest &request);
+    bool sendResponse(const RtspRequest &request, const char *status, const std::string &headers = "",
+                      const std::string &body = "");
+    bool openSource(const std::string &url);
+    std::string buildSdp() const;
+    bool setupTransport(const std::string &transport, std::string &reply);
+    bool sendMedia(const uint8_t *data, size_t size);
+    void startStreaming();
+    void stopStreaming();
+    void streamLoop();
+
+    int fd_;
+    const ClipCatalog &clips_;
+    bool loop_;
+    std::string input_; // 已接收未处理的字节
+    std::string clipName_;
+    std::unique_ptr<ClipSource> source_;
+    std::string sessionId_;
+
+    bool tcp_;
+    int rtpChannel_;
+    int rtcpChannel_;
+    int rtpSocket_;
+    int rtcpSocket_;
+
+    std::mutex sendMutex_; // RTSP应答和interleaved数据共用连接
+    std::thread streamThread_;
+    std::atomic<bool> streamStop_;
+};
+
+RtspSession::RtspSession(int fd, const ClipCatalog &clips, bool loop)
+    : fd_(fd), clips_(clips), loop_(loop), tcp_(true), rtpChannel_(0), rtcpChannel_(1), rtpSocket_(-1),
+      rtcpSocket_(-1), streamStop_(false) {}
+
+RtspSession::~RtspSession() {
+    stopStreaming();
+    if (rtpSocket_ >= 0) {
+        close(rtpSocket_);
+    }
+    if (rtcpSocket_ >= 0) {
+        close(rtcpSocket_);
+    }
+}
+
+void RtspSession::run() {
+    RtspRequest request;
+    while (readRequest(request)) {
+        if (!handle(request)) {
+            break;
+        }
+    }
+    stopStreaming();
+    if (!clipName_.empty()) {
+        OH_LOG_INFO(LOG_APP, "Session %{public}s for %{public}s closed", sessionId_.c_str(), clipName_.c_str());
+    }
+}
+
+bool RtspSession::readRequest(RtspRequest &request) {
+    char buffer[4096];
+    while (true) {
+        // TCP传输时客户端的RTCP接收报告也以$开头的interleaved帧到达，直接丢弃
+        if (!input_.empty() && input_[0] == '$') {
+            if (input_.size() >= 4) {
+                size_t frameSize = 4 + ((static_cast<uint8_t>(input_[2]) << 8) | static_cast<uint8_t>(input_[3]));
+                if (input_.size() >= frameSize) {
+                    input_.erase(0, frameSize);
+                    continue;
+                }
+            }
+        } else {
+            size_t end = input_.find("\r\n\r\n");
+            if (end != std::string::npos) {
+                std::string head = input_.substr(0, end);
+                input_.erase(0, end + 4);
+
+                request = RtspRequest();
+                size_t lineEnd = head.find("\r\n");
+                std::string requestLine = head.substr(0, lineEnd);
+                size_t methodEnd = requestLine.find(' ');
+                size_t urlEnd = requestLine.find(' ', methodEnd + 1);
+                if (methodEnd == std::string::npos || urlEnd == std::string::npos) {
+                    return false;
+                }
+                request.method = requestLine.substr(0, methodEnd);
+                request.url = requestLine.substr(methodEnd + 1, urlEnd - methodEnd - 1);
+                while (lineEnd != std::string::npos) {
+                    size_t start = lineEnd + 2;
+                    lineEnd = head.find("\r\n", start);
+                    std::string line = head.substr(start, lineEnd == std::string::npos ? std::string::npos
+                                                                                       : lineEnd - start);
+                    size_t colon = line.find(':');
+                    if (colon != std::string::npos) {
+                        request.headers[ToLower(Trim(line.substr(0, colon)))] = Trim(line.substr(colon + 1));
+                    }
+                }
+
+                // 请求体（如SET_PARAMETER的参数）不需要处理
+                size_t contentLength = strtoul(request.headers["content-length"].c_str(), nullptr, 10);
+                while (input_.size() < contentLength) {
+                    ssize_t received = recv(fd_, buffer, sizeof(buffer), 0);
+                    if (received <= 0) {
+                        return false;
+                    }
+                    input_.append(buffer, static_cast<size_t>(received));
+                }
+                input_.erase(0, contentLength);
+                return true;
+            }
+            if (input_.size() > MAX_REQUEST_SIZE) {
+                OH_LOG_WARN(LOG_APP, "Request too large, closing connection");
+                return false;
+            }
+        }
+
+        ssize_t received = recv(fd_, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        input_.append(buffer, static_cast<size_t>(received));
+    }
+}
+
+bool RtspSession::sendResponse(const RtspRequest &request, const char *status, const std::string &headers,
+                               const std::string &body) {
+    std::string response = std::string("RTSP/1.0 ") + status + "\r\n";
+    auto cseq = request.headers.find("cseq");
+    response += "CSeq: " + (cseq != request.headers.end() ? cseq->second : std::string("0")) + "\r\n";
+    response += "Server: LoopbackServer\r\n";
+    response += headers;
+    if (!body.empty()) {
+        response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    }
+    response += "\r\n";
+    response += body;
+
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    return SendAll(fd_, response.data(), response.size());
+}
+
+bool RtspSession::openSource(const std::string &url) {
+    if (source_) {
+        return true;
+    }
+    const ClipCatalog::value_type *clip = FindClip(clips_, url);
+    if (!clip) {
+        return false;
+    }
+    auto source = std::make_unique<ClipSource>(clip->second, loop_);
+    if (!source->open()) {
+        return false;
+    }
+    clipName_ = clip->first;
+    source_ = std::move(source);
+    return true;
+}
+
+std::string RtspSession::buildSdp() const {
+    // 用rtp复用器的上下文生成SDP，负载类型与发送时复用器的选择一致；
+    // URL不是rtp://时av_sdp_create不写端口，并为每路流生成a=control:streamid=N
+    sockaddr_in local = {};
+    socklen_t length = sizeof(local);
+    getsockname(fd_, reinterpret_cast<sockaddr *>(&local), &length);
+    char address[INET_ADDRSTRLEN] = "0.0.0.0";
+    inet_ntop(AF_INET, &local.sin_addr, address, sizeof(address));
+
+    std::string sdp;
+    AVFormatContext *context = nullptr;
+    if (avformat_alloc_output_context2(&context, nullptr, "rtp", nullptr) < 0 || !context) {
+        return sdp;
+    }
+    AVStream *stream = avformat_new_stream(context, nullptr);
+    if (stream && avcodec_parameters_copy(stream->codecpar, source_->codecParameters()) >= 0) {
+        stream->codecpar->codec_tag = 0;
+        context->url = av_strdup((std::string("rtsp://") + address).c_str());
+        av_dict_set(&context->metadata, "title", clipName_.c_str(), 0);
+        char buffer[SDP_MAX_SIZE];
+        if (av_sdp_create(&context, 1, buffer, sizeof(buffer)) >= 0) {
+            sdp = buffer;
+        }
+    }
+    avformat_free_context(context);
+    return sdp;
+}
+
+bool RtspSession::setupTransport(const std::string &transport, std::string &reply) {
+    if (transport.find("RTP/AVP/TCP") != std::string::npos) {
+        tcp_ = true;
+        ParseRange(transport, "interleaved=", rtpChannel_, rtcpChannel_);
+        reply = "RTP/AVP/TCP;unicast;interleaved=" + std::to_string(rtpChannel_) + "-" + std::to_string(rtcpChannel_);
+        return true;
+    }
+
+    int clientRtpPort = 0;
+    int clientRtcpPort = 0;
+    if (!ParseRange(transport, "client_port=", clientRtpPort, clientRtcpPort)) {
+        return false;
+    }
+    tcp_ = false;
+
+    // 从RTSP连接的本地地址发出，发往客户端在client_port声明的端口
+    sockaddr_in local = {};
+    sockaddr_in peer = {};
+    socklen_t length = sizeof(local);
+    getsockname(fd_, reinterpret_cast<sockaddr *>(&local), &length);
+    length = sizeof(peer);
+    getpeername(fd_, reinterpret_cast<sockaddr *>(&peer), &length);
+
+    int serverPorts[2] = {0, 0};
+    int *sockets[2] = {&rtpSocket_, &rtcpSocket_};
+    int clientPorts[2] = {clientRtpPort, clientRtcpPort};
+    for (int i = 0; i < 2; i++) {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in bindAddress = local;
+        bindAddress.sin_port = 0;
+        sockaddr_in destination = peer;
+        destination.sin_port = htons(static_cast<uint16_t>(clientPorts[i]));
+        if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&bindAddress), sizeof(bindAddress)) < 0 ||
+            connect(fd, reinterpret_cast<sockaddr *>(&destination), sizeof(destination)) < 0) {
+            if (fd >= 0) {
+                close(fd);
+            }
+            return false;
+        }
+        length = sizeof(bindAddress);
+        getsockname(fd, reinterpret_cast<sockaddr *>(&bindAddress), &length);
+        serverPorts[i] = ntohs(bindAddress.sin_port);
+        *sockets[i] = fd;
+    }
+    reply = "RTP/AVP/UDP;unicast;client_port=" + std::to_string(clientRtpPort) + "-" + std::to_string(clientRtcpPort) +
+            ";server_port=" + std::to_string(serverPorts[0]) + "-" + std::to_string(serverPorts[1]);
+    return true;
+}
+
+bool RtspSession::handle(const RtspRequest &request) {
+    const std::string &method = request.method;
+    std::string session = sessionId_.empty() ? "" : "Session: " + sessionId_ + ";timeout=" + SESSION_TIMEOUT + "\r\n";
+
+    if (method == "OPTIONS") {
+        return sendResponse(request, "200 OK",
+                            "Public: OPTIONS, DESCRIBE, SETUP, PLAY, TEARDOWN, GET_PARAMETER, SET_PARAMETER\r\n");
+    }
+    if (method == "DESCRIBE") {
+        if (!openSource(request.url)) {
+            OH_LOG_WARN(LOG_APP, "No clip for %{public}s", request.url.c_str());
+            return sendResponse(request, "404 Not Found");
+        }
+        std::string sdp = buildSdp();
+        if (sdp.empty()) {
+            return sendResponse(request, "500 Internal Server Error");
+        }
+        std::string base = request.url;
+        if (base.empty() || base.back() != '/') {
+            base += '/';
+        }
+        return sendResponse(request, "200 OK", "Content-Base: " + base + "\r\nContent-Type: application/sdp\r\n",
+                            sdp);
+    }
+    if (method == "SETUP") {
+        if (!openSource(request.url)) {
+            return sendResponse(request, "404 Not Found");
+        }
+        auto transport = request.headers.find("transport");
+        std::string reply;
+        if (transport == request.headers.end() || !setupTransport(transport->second, reply)) {
+            return sendResponse(request, "461 Unsupported Transport");
+        }
+        if (sessionId_.empty()) {
+            char id[16];
+            snprintf(id, sizeof(id), "%08X", g_nextSessionId++);
+            sessionId_ = id;
+        }
+        session = "Session: " + sessionId_ + ";timeout=" + SESSION_TIMEOUT + "\r\n";
+        return sendResponse(request, "200 OK", session + "Transport: " + reply + "\r\n");
+    }
+    if (method == "PLAY") {
+        if (!source_ || sessionId_.empty()) {
+            return sendResponse(request, "455 Method Not Valid in This State");
+        }
+        // 先应答再发送媒体，保证客户端先收到PLAY的应答
+        bool sent = sendResponse(request, "200 OK", session + "Range: npt=0.000-\r\n");
+        if (sent) {
+            startStreaming();
+        }
+        return sent;
+    }
+    if (method == "GET_PARAMETER" || method == "SET_PARAMETER") {
+        return sendResponse(request, "200 OK", session);
+    }
+    if (method == "TEARDOWN") {
+        stopStreaming();
+        sendResponse(request, "200 OK", session);
+        return false;
+    }
+    return sendResponse(request, "501 Not Implemented");
+}
+
+bool RtspSession::sendMedia(const uint8_t *data, size_t size) {
+    bool rtcp = size >= 2 && data[1] >= RTCP_TYPE_FIRST && data[1] <= RTCP_TYPE_LAST;
+    if (tcp_) {
+        uint8_t header[4] = {'$', static_cast<uint8_t>(rtcp ? rtcpChannel_ : rtpChannel_),
+                             static_cast<uint8_t>(size >> 8), static_cast<uint8_t>(size & 0xff)};
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        return SendAll(fd_, header, sizeof(header)) && SendAll(fd_, data, size);
+    }
+    // UDP发送失败（如客户端端口已关闭）不中断会话，由RTSP连接的关闭结束会话
+    send(rtcp ? rtcpSocket_ : rtpSocket_, data, size, MSG_NOSIGNAL);
+    return true;
+}
+
+void RtspSession::startStreaming() {
+    if (streamThread_.joinable()) {
+        return;
+    }
+    streamStop_ = false;
+    streamThread_ = std::thread(&RtspSession::streamLoop, this);
+}
+
+void RtspSession::stopStreaming() {
+    streamStop_ = true;
+    if (streamThread_.joinable()) {
+        streamThread_.join();
+    }
+}
+
+void RtspSession::streamLoop() {
+    OH_LOG_INFO(LOG_APP, "Session %{public}s streaming %{public}s over %{public}s", sessionId_.c_str(),
+                clipName_.c_str(), tcp_ ? "TCP" : "UDP");
+    MuxerOutput output("rtp", [this](const uint8_t *data, size_t size) { return sendMedia(data, size); });
+    AVPacket *packet = av_packet_alloc();
+    bool ok = packet && output.open(*source_, RTP_PACKET_SIZE);
+    while (ok && source_->next(packet, streamStop_)) {
+        ok = output.write(packet, source_->timeBase());
+    }
+    av_packet_free(&packet);
+    output.close();
+
+    // 片段播完或发送失败：关闭连接，客户端据此感知流结束
+    if (!streamStop_) {
+        shutdown(fd_, SHUT_RDWR);
+    }
+}
+} // namespace
+
+RtspServer::RtspServer(const ClipCatalog &clips, bool loop) : clips_(clips), loop_(loop) {}
+
+RtspServer::~RtspServer() { stop(); }
+
+void RtspServer::serve(int fd) {
+    RtspSession session(fd, clips_, loop_);
+    session.run();
+}
@@ -0,0 +1,23 @@
+#ifndef LOOPBACK_RTSP_SERVER_H
+#define LOOPBACK_RTSP_SERVER_H
+
+#include "loopback_server/clip_source.h"
+#include "loopback_server/tcp_server.h"
+
+// 最小RTSP服务端：支持OPTIONS、DESCRIBE、SETUP、PLAY、GET_PARAMETER/SET_PARAMETER和TEARDOWN，
+// 传输方式为RTP over TCP（interleaved）或RTP/UDP单播。
+// SDP由av_sdp_create生成，RTP/RTCP打包由libavformat的rtp复用器完成。
+class RtspServer : public TcpServer {
+public:
+    RtspServer(const ClipCatalog &clips, bool loop);
+    ~RtspServer() override;
+
+protected:
+    void serve(int fd) override;
+
+private:
+    const ClipCatalog clips_;
+    bool loop_;
+};
+
+#endif // LOOPBACK_RTSP_SERVER_H
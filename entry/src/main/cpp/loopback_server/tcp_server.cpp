@@ -0,0 +1,173 @@
+#include "loopback_server/tcp_server.h"
+#include "common/log.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "TcpServer"
+
+namespace {
+// accept等待的超时，期间检查停止请求
+const int ACCEPT_POLL_TIMEOUT_MS = 100;
+
+// 同时发起的大量连接在accept之前排队
+const int LISTEN_BACKLOG = 128;
+} // namespace
+
+bool SendAll(int fd, const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    while (size > 0) {
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool RecvAll(int fd, void *data, size_t size) {
+    uint8_t *bytes = static_cast<uint8_t *>(data);
+    while (size > 0) {
+        ssize_t received = recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool MakeIpv4Address(const std::string &address, uint16_t port, sockaddr_in &addr) {
+    addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    return inet_pton(AF_INET, address.c_str(), &addr.sin_addr) == 1;
+}
+
+TcpServer::TcpServer() : listenFd_(-1), stopping_(false) {}
+
+TcpServer::~TcpServer() { stop(); }
+
+bool TcpServer::start(const std::string &address, uint16_t port) {
+    sockaddr_in addr;
+    if (!MakeIpv4Address(address, port, addr)) {
+        OH_LOG_ERROR(LOG_APP, "Invalid bind address %{public}s", address.c_str());
+        return false;
+    }
+
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0) {
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (bind(listenFd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        listen(listenFd_, LISTEN_BACKLOG) < 0) {
+        OH_LOG_ERROR(LOG_APP, "Failed to listen on %{public}s:%{public}u, errno %{public}d", address.c_str(), port,
+                     errno);
+        close(listenFd_);
+        listenFd_ = -1;
+        return false;
+    }
+    stopping_ = false;
+    acceptThread_ = std::thread(&TcpServer::acceptLoop, this);
+    return true;
+}
+
+void TcpServer::stop() {
+    stopping_ = true;
+    if (acceptThread_.joinable()) {
+        acceptThread_.join();
+    }
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+    }
+
+    std::list<std::unique_ptr<Connection>> connections;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections.swap(connections_);
+    }
+    // 打断阻塞中的读写，连接线程随后自行退出；套接字在线程退出后关闭，避免描述符被复用后误关
+    for (auto &connection : connections) {
+        shutdown(connection->fd, SHUT_RDWR);
+    }
+    for (auto &connection : connections) {
+        connection->thread.join();
+        close(connection->fd);
+    }
+}
+
+size_t TcpServer::getActiveConnections() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t active = 0;
+    for (const auto &connection : connections_) {
+        active += connection->finished ? 0 : 1;
+    }
+    return active;
+}
+
+void TcpServer::acceptLoop() {
+    while (!stopping_) {
+        reapFinished();
+
+        pollfd pfd = {listenFd_, POLLIN, 0};
+        if (poll(&pfd, 1, ACCEPT_POLL_TIMEOUT_MS) <= 0) {
+            continue;
+        }
+        int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        // 媒体数据按包实时发送，关闭Nagle避免小包被攒批
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        auto connection = std::make_unique<Connection>();
+        Connection *current = connection.get();
+        current->fd = fd;
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_.push_back(std::move(connection));
+        current->thread = std::thread([this, current]() {
+            serve(current->fd);
+            shutdown(current->fd, SHUT_RDWR);
+            current->finished = true;
+        });
+    }
+}
+
+void TcpServer::reapFinished() {
+    std::list<std::unique_ptr<Connection>> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            if ((*it)->finished) {
+                finished.push_back(std::move(*it));
+                it = connections_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto &connection : finished) {
+        connection->thread.join();
+        close(connection->fd);
+    }
+}
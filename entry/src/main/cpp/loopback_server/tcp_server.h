@@ -0,0 +1,58 @@
+#ifndef LOOPBACK_TCP_SERVER_H
+#define LOOPBACK_TCP_SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <thread>
+
+// 阻塞写入/读取全部字节，连接关闭或出错时返回false
+bool SendAll(int fd, const void *data, size_t size);
+bool RecvAll(int fd, void *data, size_t size);
+
+// 由IPv4点分地址和端口构造sockaddr_in，地址无效时返回false
+bool MakeIpv4Address(const std::string &address, uint16_t port, sockaddr_in &addr);
+
+// 每个连接一个线程的TCP服务端。
+// stop()关闭所有连接的读写方向以打断阻塞中的recv/send，并等待连接线程退出。
+class TcpServer {
+public:
+    TcpServer();
+    virtual ~TcpServer();
+
+    bool start(const std::string &address, uint16_t port);
+
+    // 派生类须在析构函数中调用，保证serve()返回时派生类成员仍然有效
+    void stop();
+
+    size_t getActiveConnections() const;
+
+protected:
+    // 在连接线程中运行，返回后连接被关闭；客户端断开或stop()时fd上的读写会失败
+    virtual void serve(int fd) = 0;
+
+    bool stopping() const { return stopping_; }
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+
+    void acceptLoop();
+    void reapFinished();
+
+    int listenFd_;
+    std::thread acceptThread_;
+    std::atomic<bool> stopping_;
+    mutable std::mutex mutex_;
+    std::list<std::unique_ptr<Connection>> connections_;
+};
+
+#endif // LOOPBACK_TCP_SERVER_H
@@ -1,29 +1,208 @@
 #include "common/common.h"
+#include "common/frame_log.h"
 #include "hilog/log.h" // 添加日志头文件
 #include "manager/plugin_manager.h"
 #include "napi/native_api.h"
 #include "render/plugin_render.h" // 需要VideoRenderer的完整定义
+#include "snapshot.h"
 #include "video_stream_handler.h"
 #include <ace/xcomponent/native_interface_xcomponent.h>
 #include <cstring> // 添加memset支持
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #undef LOG_DOMAIN
 #undef LOG_TAG
 #define LOG_DOMAIN 0x3200         // 自定义domain
 #define LOG_TAG "VideoStreamNAPI" // 日志标签
 
-// 全局视频流处理器映射
+// 全局视频流处理器映射，同一URL的所有surface共享一个处理器
 static std::map<std::string, std::shared_ptr<VideoStreamHandler>> g_streamHandlers;
 
+// 各URL最近一次停止的耗时（毫秒），handler移除后仍可通过getStreamStatus查询
+static std::map<std::string, double> g_stopLatencies;
+
+// 读取options对象中的数值属性，属性不存在或类型不符时保持默认值
+static void GetOptionalUint32(napi_env env, napi_value object, const char *name, size_t &value) {
+    bool hasProperty = false;
+    if (napi_has_named_property(env, object, name, &hasProperty) != napi_ok || !hasProperty) {
+        return;
+    }
+    napi_value property;
+    uint32_t result = 0;
+    if (napi_get_named_property(env, object, name, &property) == napi_ok &&
+        napi_get_value_uint32(env, property, &result) == napi_ok && result > 0) {
+        value = result;
+    }
+}
+
+// 读取options对象中的有符号整数属性，允许0
+static void GetOptionalInt32(napi_env env, napi_value object, const char *name, int &value) {
+    bool hasProperty = false;
+    if (napi_has_named_property(env, object, name, &hasProperty) != napi_ok || !hasProperty) {
+        return;
+    }
+    napi_value property;
+    int32_t result = 0;
+    if (napi_get_named_property(env, object, name, &property) == napi_ok &&
+        napi_get_value_int32(env, property, &result) == napi_ok) {
+        value = result;
+    }
+}
+
+// 读取options对象中的浮点数属性
+static void GetOptionalDouble(napi_env env, napi_value object, const char *name, double &value) {
+    bool hasProperty = false;
+    if (napi_has_named_property(env, object, name, &hasProperty) != napi_ok || !hasProperty) {
+        return;
+    }
+    napi_value property;
+    double result = 0;
+    if (napi_get_named_property(env, object, name, &property) == napi_ok &&
+        napi_get_value_double(env, property, &result) == napi_ok) {
+        value = result;
+    }
+}
+
+// 读取options对象中的布尔属性
+static void GetOptionalBool(napi_env env, napi_value object, const char *name, bool &value) {
+    bool hasProperty = false;
+    if (napi_has_named_property(env, object, name, &hasProperty) != napi_ok || !hasProperty) {
+        return;
+    }
+    napi_value property;
+    bool result = false;
+    if (napi_get_named_property(env, object, name, &property) == napi_ok &&
+        napi_get_value_bool(env, property, &result) == napi_ok) {
+        value = result;
+    }
+}
+
+// 读取options对象中的字符串属性
+static bool GetOptionalString(napi_env env, napi_value object, const char *name, std::string &value) {
+    bool hasProperty = false;
+    if (napi_has_named_property(env, object, name, &hasProperty) != napi_ok || !hasProperty) {
+        return false;
+    }
+    napi_value property;
+    size_t length = 0;
+    if (napi_get_named_property(env, object, name, &property) != napi_ok ||
+        napi_get_value_string_utf8(env, property, nullptr, 0, &length) != napi_ok) {
+        return false;
+    }
+    value.assign(length, '\0');
+    napi_get_value_string_utf8(env, property, &value[0], length + 1, &length);
+    return true;
+}
+
+// 读取options对象中的数值数组属性
+static void GetOptionalIntArray(napi_env env, napi_value object, const char *name, std::vector<int> &values) {
+    bool hasProperty = false;
+    if (napi_has_named_property(env, object, name, &hasProperty) != napi_ok || !hasProperty) {
+        return;
+    }
+    napi_value property;
+    bool isArray = false;
+    uint32_t length = 0;
+    if (napi_get_named_property(env, object, name, &property) != napi_ok ||
+        napi_is_array(env, property, &isArray) != napi_ok || !isArray ||
+        napi_get_array_length(env, property, &length) != napi_ok) {
+        return;
+    }
+    values.clear();
+    for (uint32_t i = 0; i < length; i++) {
+        napi_value element;
+        int32_t item = 0;
+        if (napi_get_element(env, property, i, &element) == napi_ok &&
+            napi_get_value_int32(env, element, &item) == napi_ok) {
+            values.push_back(item);
+        }
+    }
+}
+
+// 解析流优先级字符串
+static bool ParseStreamPriority(const std::string &value, StreamPriority &priority) {
+    if (value == "low") {
+        priority = StreamPriority::Low;
+    } else if (value == "normal") {
+        priority = StreamPriority::Normal;
+    } else if (value == "high") {
+        priority = StreamPriority::High;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 解析startVideoStream的可选配置参数
+static StreamOptions ParseStreamOptions(napi_env env, napi_value value) {
+    StreamOptions options;
+    napi_valuetype type = napi_undefined;
+    if (napi_typeof(env, value, &type) != napi_ok || type != napi_object) {
+        return options;
+    }
+    GetOptionalUint32(env, value, "packetQueueDepth", options.packetQueueDepth);
+    GetOptionalUint32(env, value, "frameQueueDepth", options.frameQueueDepth);
+
+    std::string threadMode;
+    if (GetOptionalString(env, value, "decodeThreadMode", threadMode)) {
+        if (threadMode == "frame") {
+            options.decodeThreadMode = DecodeThreadMode::Frame;
+        } else if (threadMode == "slice") {
+            options.decodeThreadMode = DecodeThreadMode::Slice;
+        } else {
+            options.decodeThreadMode = DecodeThreadMode::Auto;
+        }
+    }
+    size_t threadCount = 0;
+    GetOptionalUint32(env, value, "decodeThreadCount", threadCount);
+    options.decodeThreadCount = static_cast<int>(threadCount);
+    GetOptionalIntArray(env, value, "decodeCpus", options.decodeCpus);
+    std::string decoderBackend;
+    if (GetOptionalString(env, value, "decoderBackend", decoderBackend)) {
+        options.decoderBackend =
+            decoderBackend == "software" ? DecoderBackendMode::Software : DecoderBackendMode::Auto;
+    }
+    GetOptionalBool(env, value, "sharedDecoder", options.sharedDecoder);
+    std::string priority;
+    if (GetOptionalString(env, value, "priority", priority)) {
+        ParseStreamPriority(priority, options.priority);
+    }
+    std::string hiddenDecodeMode;
+    if (GetOptionalString(env, value, "hiddenDecodeMode", hiddenDecodeMode)) {
+        options.hiddenDecodeMode =
+            hiddenDecodeMode == "suspend" ? HiddenDecodeMode::Suspend : HiddenDecodeMode::KeyframesOnly;
+    }
+    GetOptionalInt32(env, value, "thumbnailFps", options.thumbnailFps);
+    GetOptionalBool(env, value, "lowLatency", options.lowLatency);
+    GetOptionalBool(env, value, "framePacing", options.framePacing);
+    GetOptionalBool(env, value, "keyframeResync", options.keyframeResync);
+    GetOptionalInt32(env, value, "targetLatencyMs", options.targetLatencyMs);
+    GetOptionalBool(env, value, "autoReconnect", options.autoReconnect);
+    GetOptionalInt32(env, value, "reconnectInitialDelayMs", options.reconnectInitialDelayMs);
+    GetOptionalInt32(env, value, "reconnectMaxDelayMs", options.reconnectMaxDelayMs);
+    GetOptionalDouble(env, value, "reconnectJitter", options.reconnectJitter);
+    GetOptionalInt32(env, value, "maxReconnectAttempts", options.maxReconnectAttempts);
+    return options;
+}
+
+// 把解码帧交给surface的渲染线程，渲染结果计入渲染统计
+static VideoStreamHandler::FrameCallback MakeRenderCallback(VideoStreamNS::VideoRenderer *videoRenderer) {
+    return [videoRenderer](const VideoFrame &frame) {
+        FRAME_LOG(LOG_APP, LOG_DEBUG, LOG_DOMAIN, LOG_TAG, "Frame received: %{public}dx%{public}d, pts=%{public}ld",
+                  frame.width, frame.height, static_cast<long>(frame.pts));
+        videoRenderer->RenderYUVFrame(frame);
+    };
+}
+
 // 开始视频流
 static napi_value StartVideoStream(napi_env env, napi_callback_info info) {
     OH_LOG_INFO(LOG_APP, "=== StartVideoStream called ===");
 
-    size_t argc = 2;
-    napi_value args[2];
+    size_t argc = 3;
+    napi_value args[3];
 
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
     OH_LOG_INFO(LOG_APP, "Got callback info, argc = %{public}zu", argc);
@@ -61,28 +240,67 @@ static napi_value StartVideoStream(napi_env env, napi_callback_info info) {
         return nullptr;
     }
 
+    // 同一URL已在播放：共享已有的连接和解码，只为该surface增加订阅
+    auto existing = g_streamHandlers.find(url);
+    if (existing != g_streamHandlers.end() && existing->second->isActive()) {
+        if (argc >= 3) {
+            OH_LOG_WARN(LOG_APP, "Stream already running, options ignored for shared subscriber");
+        }
+        size_t subscribers = existing->second->addFrameSubscriber(surfaceId, MakeRenderCallback(videoRenderer));
+        OH_LOG_INFO(LOG_APP, "Surface %{public}lld joined shared stream, %{public}zu subscribers",
+                    static_cast<long long>(surfaceId), subscribers);
+
+        napi_value result;
+        napi_create_object(env, &result);
+        napi_value successValue;
+        napi_get_boolean(env, true, &successValue);
+        napi_set_named_property(env, result, "success", successValue);
+        napi_value urlValue;
+        napi_create_string_utf8(env, url.c_str(), NAPI_AUTO_LENGTH, &urlValue);
+        napi_set_named_property(env, result, "url", urlValue);
+        napi_value sharedValue;
+        napi_get_boolean(env, true, &sharedValue);
+        napi_set_named_property(env, result, "shared", sharedValue);
+        return result;
+    }
+
     // 创建视频流处理器
     OH_LOG_INFO(LOG_APP, "Creating VideoStreamHandler...");
     auto handler = std::make_shared<VideoStreamHandler>();
-    OH_LOG_INFO(LOG_APP, "VideoStreamHandler created successfully"); // 设置帧回调，直接连接到视频渲染器
-    handler->setFrameCallback([videoRenderer](const VideoFrame &frame) {
-        OH_LOG_INFO(LOG_APP, "Frame received: %{public}dx%{public}d, pts=%{public}ld", frame.width, frame.height,
-                    static_cast<long>(frame.pts));
-        if (!videoRenderer->RenderYUVFrame(frame)) {
-            OH_LOG_ERROR(LOG_APP, "Failed to render YUV frame");
-        }
-    });
+    OH_LOG_INFO(LOG_APP, "VideoStreamHandler created successfully"); // 订阅解码输出，直接连接到视频渲染器
+    handler->addFrameSubscriber(surfaceId, MakeRenderCallback(videoRenderer));
 
     handler->setErrorCallback(
         [](const std::string &error) { OH_LOG_ERROR(LOG_APP, "Stream error: %{public}s", error.c_str()); });
 
     OH_LOG_INFO(LOG_APP, "Callbacks set, starting stream...");
 
+    // 渲染端记录首次上传纹理和首次上屏
+    videoRenderer->SetStartupTrace(handler->getStartupTrace());
+
+    StreamOptions options;
+    if (argc >= 3) {
+        options = ParseStreamOptions(env, args[2]);
+    }
+
     // 开始流
-    bool success = handler->startStream(url);
+    bool success = handler->startStream(url, options);
     OH_LOG_INFO(LOG_APP, "Stream start result: %{public}s", success ? "SUCCESS" : "FAILED");
 
+    // 同一URL的旧处理器已结束（EOF或重连失败）：其余surface的订阅转到新处理器上，不能随旧处理器一起丢掉
+    std::vector<int64_t> adoptedSurfaces;
     if (success) {
+        if (existing != g_streamHandlers.end()) {
+            adoptedSurfaces = handler->adoptFrameSubscribers(*existing->second);
+            for (int64_t adoptedId : adoptedSurfaces) {
+                auto adoptedRenderer = PluginManager::GetVideoRenderer(adoptedId);
+                if (adoptedRenderer) {
+                    adoptedRenderer->SetStartupTrace(handler->getStartupTrace());
+                }
+                OH_LOG_INFO(LOG_APP, "Surface %{public}lld moved to restarted stream",
+                            static_cast<long long>(adoptedId));
+            }
+        }
         g_streamHandlers[url] = handler;
         OH_LOG_INFO(LOG_APP, "Added handler to global map, total handlers: %{public}zu", g_streamHandlers.size());
         OH_LOG_INFO(LOG_APP, "Video stream connected to renderer successfully");
@@ -101,14 +319,28 @@ static napi_value StartVideoStream(napi_env env, napi_callback_info info) {
     napi_create_string_utf8(env, url.c_str(), NAPI_AUTO_LENGTH, &urlValue);
     napi_set_named_property(env, result, "url", urlValue);
 
+    napi_value sharedValue;
+    napi_get_boolean(env, false, &sharedValue);
+    napi_set_named_property(env, result, "shared", sharedValue);
+
+    // 从旧处理器接管过来的surfaceId，应用侧可据此得知哪些surface随本次调用一起重新开始
+    napi_value adoptedValue;
+    napi_create_array_with_length(env, adoptedSurfaces.size(), &adoptedValue);
+    for (size_t i = 0; i < adoptedSurfaces.size(); ++i) {
+        napi_value idValue;
+        napi_create_bigint_int64(env, adoptedSurfaces[i], &idValue);
+        napi_set_element(env, adoptedValue, static_cast<uint32_t>(i), idValue);
+    }
+    napi_set_named_property(env, result, "adoptedSurfaces", adoptedValue);
+
     OH_LOG_INFO(LOG_APP, "=== StartVideoStream completed ===");
     return result;
 }
 
-// 停止视频流
+// 停止视频流；给出surfaceId时只取消该surface的订阅，最后一个订阅者离开时才断开连接
 static napi_value StopVideoStream(napi_env env, napi_callback_info info) {
-    size_t argc = 1;
-    napi_value args[1];
+    size_t argc = 2;
+    napi_value args[2];
 
     napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
 
@@ -124,10 +356,28 @@ static napi_value StopVideoStream(napi_env env, napi_callback_info info) {
     std::string url(url_length, '\0');
     napi_get_value_string_utf8(env, args[0], &url[0], url_length + 1, &url_length);
 
+    int64_t surfaceId = 0;
+    bool lossless = true;
+    bool hasSurfaceId = argc >= 2 && napi_get_value_bigint_int64(env, args[1], &surfaceId, &lossless) == napi_ok;
+
     bool success = false;
     auto it = g_streamHandlers.find(url);
+    if (it != g_streamHandlers.end() && hasSurfaceId) {
+        if (!it->second->hasFrameSubscriber(surfaceId)) {
+            napi_value result;
+            napi_get_boolean(env, false, &result);
+            return result;
+        }
+        size_t remaining = it->second->removeFrameSubscriber(surfaceId);
+        if (remaining > 0) {
+            napi_value result;
+            napi_get_boolean(env, true, &result);
+            return result;
+        }
+    }
     if (it != g_streamHandlers.end()) {
         it->second->stopStream();
+        g_stopLatencies[url] = it->second->getLastStopLatencyMs();
         g_streamHandlers.erase(it);
         success = true;
     }
@@ -138,6 +388,38 @@ static napi_value StopVideoStream(napi_env env, napi_callback_info info) {
     return result;
 }
 
+// 销毁surface：先在所有流上取消它的订阅，再释放VideoRenderer。
+// 渲染回调持有VideoRenderer裸指针，removeFrameSubscriber返回后不会再有回调访问它；失去最后一个订阅者的流随之停止
+static napi_value DestroySurface(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    int64_t surfaceId = 0;
+    bool lossless = true;
+    if (argc >= 1 && napi_get_value_bigint_int64(env, args[0], &surfaceId, &lossless) == napi_ok) {
+        for (auto it = g_streamHandlers.begin(); it != g_streamHandlers.end();) {
+            if (!it->second->hasFrameSubscriber(surfaceId) || it->second->removeFrameSubscriber(surfaceId) > 0) {
+                ++it;
+                continue;
+            }
+            OH_LOG_INFO(LOG_APP, "Surface destroyed, stopping stream without subscribers: %{public}s",
+                        it->first.c_str());
+            it->second->stopStream();
+            g_stopLatencies[it->first] = it->second->getLastStopLatencyMs();
+            it = g_streamHandlers.erase(it);
+        }
+    }
+    return PluginManager::DestroySurface(env, info);
+}
+
+// 写入一个数值属性
+static void SetNamedInt32(napi_env env, napi_value object, const char *name, int32_t value) {
+    napi_value property;
+    napi_create_int32(env, value, &property);
+    napi_set_named_property(env, object, name, property);
+}
+
 // 获取流状态
 static napi_value GetStreamStatus(napi_env env, napi_callback_info info) {
     size_t argc = 1;
@@ -177,6 +459,30 @@ static napi_value GetStreamStatus(napi_env env, napi_callback_info info) {
         OH_LOG_INFO(LOG_APP, "Stream info: %{public}s", streamInfo.c_str());
         napi_create_string_utf8(env, streamInfo.c_str(), NAPI_AUTO_LENGTH, &info);
         napi_set_named_property(env, result, "info", info);
+
+        DecoderInfo decoderInfo = it->second->getDecoderInfo();
+        napi_value decoder;
+        napi_create_string_utf8(env, decoderInfo.codecName.c_str(), NAPI_AUTO_LENGTH, &decoder);
+        napi_set_named_property(env, result, "decoder", decoder);
+
+        napi_value threadMode;
+        napi_create_string_utf8(env, decoderInfo.threadMode.c_str(), NAPI_AUTO_LENGTH, &threadMode);
+        napi_set_named_property(env, result, "decodeThreadMode", threadMode);
+
+        napi_value threadCount;
+        napi_create_int32(env, decoderInfo.threadCount, &threadCount);
+        napi_set_named_property(env, result, "decodeThreadCount", threadCount);
+
+        napi_value backend;
+        napi_create_string_utf8(env, decoderInfo.backend.c_str(), NAPI_AUTO_LENGTH, &backend);
+        napi_set_named_property(env, result, "decoderBackend", backend);
+        SetNamedInt32(env, result, "hardwareFallbacks", decoderInfo.hardwareFallbacks);
+
+        SetNamedInt32(env, result, "subscribers", static_cast<int32_t>(it->second->getFrameSubscriberCount()));
+
+        napi_value reconnecting;
+        napi_get_boolean(env, it->second->getReconnectStats().reconnecting, &reconnecting);
+        napi_set_named_property(env, result, "reconnecting", reconnecting);
     } else {
         OH_LOG_WARN(LOG_APP, "Handler not found for URL: %{public}s", url.c_str());
         napi_value isStreaming;
@@ -188,9 +494,117 @@ static napi_value GetStreamStatus(napi_env env, napi_callback_info info) {
         napi_set_named_property(env, result, "info", info);
     }
 
+    auto stopIt = g_stopLatencies.find(url);
+    if (stopIt != g_stopLatencies.end()) {
+        napi_value stopLatency;
+        napi_create_double(env, stopIt->second, &stopLatency);
+        napi_set_named_property(env, result, "lastStopLatencyMs", stopLatency);
+    }
+
     return result;
 }
 
+// 写入流水线各阶段队列占用
+static void SetPipelineStats(napi_env env, napi_value object, const PipelineStats &stats) {
+    SetNamedInt32(env, object, "packetQueueSize", static_cast<int32_t>(stats.packetQueueSize));
+    SetNamedInt32(env, object, "packetQueueCapacity", static_cast<int32_t>(stats.packetQueueCapacity));
+    SetNamedInt32(env, object, "frameQueueSize", static_cast<int32_t>(stats.frameQueueSize));
+    SetNamedInt32(env, object, "frameQueueCapacity", static_cast<int32_t>(stats.frameQueueCapacity));
+    SetNamedInt32(env, object, "droppedFrames", stats.droppedFrames);
+}
+
+// 写入解码输出缓冲池命中情况
+static void SetFramePoolStats(napi_env env, napi_value object, const FramePoolStats &stats) {
+    napi_value hits;
+    napi_create_double(env, static_cast<double>(stats.hits), &hits);
+    napi_set_named_property(env, object, "poolHits", hits);
+
+    napi_value misses;
+    napi_create_double(env, static_cast<double>(stats.misses), &misses);
+    napi_set_named_property(env, object, "poolMisses", misses);
+
+    SetNamedInt32(env, object, "pooledBuffers", static_cast<int32_t>(stats.pooledBuffers));
+    SetNamedInt32(env, object, "outstandingBuffers", static_cast<int32_t>(stats.outstandingBuffers));
+}
+
+// 写入首帧时间和端到端延迟
+static void SetLatencyStats(napi_env env, napi_value object, const LatencyStats &stats) {
+    napi_value timeToFirstFrame;
+    napi_create_double(env, stats.timeToFirstFrameMs, &timeToFirstFrame);
+    napi_set_named_property(env, object, "timeToFirstFrameMs", timeToFirstFrame);
+
+    napi_value receiveToRender;
+    napi_create_double(env, stats.receiveToRenderMs, &receiveToRender);
+    napi_set_named_property(env, object, "receiveToRenderMs", receiveToRender);
+
+    napi_value glassToGlass;
+    napi_create_double(env, stats.glassToGlassMs, &glassToGlass);
+    napi_set_named_property(env, object, "glassToGlassMs", glassToGlass);
+
+    napi_value probeSkipped;
+    napi_get_boolean(env, stats.probeSkipped, &probeSkipped);
+    napi_set_named_property(env, object, "probeSkipped", probeSkipped);
+
+    static const char *CATCH_UP_LEVELS[] = {"none", "speedUp", "skipNonRef", "skipToKeyframe"};
+    const LatencyControlStats &control = stats.control;
+    const std::pair<const char *, double> values[] = {{"targetLatencyMs", control.targetLatencyMs},
+                                                      {"effectiveLatencyMs", control.effectiveLatencyMs},
+                                                      {"playbackRate", control.playbackRate}};
+    for (const auto &entry : values) {
+        napi_value value;
+        napi_create_double(env, entry.second, &value);
+        napi_set_named_property(env, object, entry.first, value);
+    }
+    napi_value level;
+    napi_create_string_utf8(env, CATCH_UP_LEVELS[static_cast<int>(control.level)], NAPI_AUTO_LENGTH, &level);
+    napi_set_named_property(env, object, "catchUpLevel", level);
+    SetNamedInt32(env, object, "keyframeSkips", static_cast<int32_t>(control.keyframeSkips));
+    SetNamedInt32(env, object, "skippedPackets", static_cast<int32_t>(control.skippedPackets));
+    SetNamedInt32(env, object, "flushedFrames", static_cast<int32_t>(control.flushedFrames));
+}
+
+static void SetPresentationStats(napi_env env, napi_value object, const PresentationStats &stats) {
+    SetNamedInt32(env, object, "framesDisplayed", static_cast<int32_t>(stats.displayed));
+    SetNamedInt32(env, object, "framesDroppedLate", static_cast<int32_t>(stats.droppedLate));
+    SetNamedInt32(env, object, "framesRepeated", static_cast<int32_t>(stats.repeated));
+}
+
+// 写入断线重连统计
+static void SetReconnectStats(napi_env env, napi_value object, const ReconnectStats &stats) {
+    SetNamedInt32(env, object, "reconnects", stats.reconnects);
+    SetNamedInt32(env, object, "failedReconnectAttempts", stats.failedAttempts);
+    SetNamedInt32(env, object, "decoderReopens", stats.decoderReopens);
+
+    napi_value lastRecovery;
+    napi_create_double(env, stats.lastRecoveryMs, &lastRecovery);
+    napi_set_named_property(env, object, "lastRecoveryMs", lastRecovery);
+}
+
+// 写入可见性节流统计
+static void SetVisibilityStats(napi_env env, napi_value object, const VisibilityStats &stats) {
+    static const char *VISIBILITIES[] = {"hidden", "thumbnail", "visible"};
+    napi_value visibility;
+    napi_create_string_utf8(env, VISIBILITIES[static_cast<int>(stats.visibility)], NAPI_AUTO_LENGTH, &visibility);
+    napi_set_named_property(env, object, "visibility", visibility);
+    SetNamedInt32(env, object, "suspendedPackets", static_cast<int32_t>(stats.suspendedPackets));
+    SetNamedInt32(env, object, "throttledFrames", static_cast<int32_t>(stats.throttledFrames));
+}
+
+// 写入关键帧同步统计
+static void SetKeyframeSyncStats(napi_env env, napi_value object, const KeyframeSyncStats &stats) {
+    SetNamedInt32(env, object, "keyframeResyncs", stats.resyncs);
+    SetNamedInt32(env, object, "keyframeDiscardedPackets", static_cast<int32_t>(stats.discardedPackets));
+    SetNamedInt32(env, object, "corruptFrames", static_cast<int32_t>(stats.corruptFrames));
+
+    napi_value timeToKeyframe;
+    napi_create_double(env, stats.lastTimeToKeyframeMs, &timeToKeyframe);
+    napi_set_named_property(env, object, "timeToKeyframeMs", timeToKeyframe);
+
+    napi_value awaiting;
+    napi_get_boolean(env, stats.awaitingKeyframe, &awaiting);
+    napi_set_named_property(env, object, "awaitingKeyframe", awaiting);
+}
+
 // 获取视频帧统计信息
 static napi_value GetFrameStats(napi_env env, napi_callback_info info) {
     size_t argc = 1;
@@ -221,6 +635,13 @@ static napi_value GetFrameStats(napi_env env, napi_callback_info info) {
         napi_create_double(env, 0.0, &frameRate);
         napi_set_named_property(env, result, "frameRate", frameRate);
 
+        SetPipelineStats(env, result, PipelineStats());
+        SetFramePoolStats(env, result, FramePoolStats());
+        SetLatencyStats(env, result, LatencyStats());
+        SetPresentationStats(env, result, PresentationStats());
+        SetReconnectStats(env, result, ReconnectStats());
+        SetVisibilityStats(env, result, VisibilityStats());
+        SetKeyframeSyncStats(env, result, KeyframeSyncStats());
         return result;
     }
 
@@ -236,6 +657,90 @@ static napi_value GetFrameStats(napi_env env, napi_callback_info info) {
     napi_create_double(env, handler->getCurrentFrameRate(), &frameRate);
     napi_set_named_property(env, result, "frameRate", frameRate);
 
+    SetPipelineStats(env, result, handler->getPipelineStats());
+    SetFramePoolStats(env, result, handler->getFramePoolStats());
+    SetLatencyStats(env, result, handler->getLatencyStats());
+    SetPresentationStats(env, result, handler->getPresentationStats());
+    SetReconnectStats(env, result, handler->getReconnectStats());
+    SetVisibilityStats(env, result, handler->getVisibilityStats());
+    SetKeyframeSyncStats(env, result, handler->getKeyframeSyncStats());
+    return result;
+}
+
+// 获取最近一次启动的各阶段耗时（毫秒，未发生为-1）
+static napi_value GetStartupTrace(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (argc != 1) {
+        napi_throw_error(env, nullptr, "Expected 1 argument");
+        return nullptr;
+    }
+
+    size_t url_length;
+    napi_get_value_string_utf8(env, args[0], nullptr, 0, &url_length);
+    std::string url(url_length, '\0');
+    napi_get_value_string_utf8(env, args[0], &url[0], url_length + 1, &url_length);
+
+    napi_value result;
+    napi_create_object(env, &result);
+
+    auto it = g_streamHandlers.find(url);
+    std::shared_ptr<StartupTrace> trace = it != g_streamHandlers.end() ? it->second->getStartupTrace() : nullptr;
+    for (int i = 0; i < static_cast<int>(StartupPhase::Count); i++) {
+        StartupPhase phase = static_cast<StartupPhase>(i);
+        napi_value value;
+        napi_create_double(env, trace ? trace->elapsedMs(phase) : -1, &value);
+        napi_set_named_property(env, result, StartupTrace::phaseName(phase), value);
+    }
+    return result;
+}
+
+// 获取进程内历次启动的各阶段耗时分布
+static napi_value GetStartupHistogram(napi_env env, napi_callback_info info) {
+    std::vector<StartupPhaseSummary> summaries = StartupHistogram::instance().summarize();
+    const std::vector<double> &bounds = StartupHistogram::bucketBoundsMs();
+
+    napi_value result;
+    napi_create_array_with_length(env, summaries.size(), &result);
+    for (size_t i = 0; i < summaries.size(); i++) {
+        const StartupPhaseSummary &summary = summaries[i];
+        napi_value item;
+        napi_create_object(env, &item);
+
+        napi_value phase;
+        napi_create_string_utf8(env, StartupTrace::phaseName(summary.phase), NAPI_AUTO_LENGTH, &phase);
+        napi_set_named_property(env, item, "phase", phase);
+
+        SetNamedInt32(env, item, "count", static_cast<int32_t>(summary.count));
+        const std::pair<const char *, double> values[] = {{"minMs", summary.minMs},
+                                                          {"maxMs", summary.maxMs},
+                                                          {"meanMs", summary.meanMs},
+                                                          {"p50Ms", summary.p50Ms},
+                                                          {"p90Ms", summary.p90Ms}};
+        for (const auto &entry : values) {
+            napi_value value;
+            napi_create_double(env, entry.second, &value);
+            napi_set_named_property(env, item, entry.first, value);
+        }
+
+        // 每个桶为{le, count}，最后一个桶的le为-1表示溢出
+        napi_value buckets;
+        napi_create_array_with_length(env, summary.buckets.size(), &buckets);
+        for (size_t b = 0; b < summary.buckets.size(); b++) {
+            napi_value bucket;
+            napi_create_object(env, &bucket);
+            napi_value le;
+            napi_create_double(env, b < bounds.size() ? bounds[b] : -1, &le);
+            napi_set_named_property(env, bucket, "le", le);
+            SetNamedInt32(env, bucket, "count", static_cast<int32_t>(summary.buckets[b]));
+            napi_set_element(env, buckets, b, bucket);
+        }
+        napi_set_named_property(env, item, "buckets", buckets);
+
+        napi_set_element(env, result, i, item);
+    }
     return result;
 }
 
@@ -280,6 +785,347 @@ static napi_value UpdateVideoSurfaceSize(napi_env env, napi_callback_info info)
     return result;
 }
 
+// 设置纹理上传方式：'direct'或'pbo'
+static napi_value SetUploadMode(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (argc != 2) {
+        napi_throw_error(env, nullptr, "Expected 2 arguments: surfaceId, mode");
+        return nullptr;
+    }
+
+    int64_t surfaceId = 0;
+    bool lossless = true;
+    if (napi_ok != napi_get_value_bigint_int64(env, args[0], &surfaceId, &lossless)) {
+        napi_throw_error(env, nullptr, "Failed to get surfaceId");
+        return nullptr;
+    }
+
+    size_t modeLength;
+    napi_get_value_string_utf8(env, args[1], nullptr, 0, &modeLength);
+    std::string mode(modeLength, '\0');
+    napi_get_value_string_utf8(env, args[1], &mode[0], modeLength + 1, &modeLength);
+    if (mode != "direct" && mode != "pbo") {
+        napi_throw_error(env, nullptr, "Upload mode must be 'direct' or 'pbo'");
+        return nullptr;
+    }
+
+    auto videoRenderer = PluginManager::GetVideoRenderer(surfaceId);
+    if (videoRenderer) {
+        videoRenderer->SetUploadMode(mode == "pbo" ? VideoStreamNS::UploadMode::PixelBuffer
+                                                    : VideoStreamNS::UploadMode::Direct);
+        OH_LOG_INFO(LOG_APP, "Upload mode set to %{public}s for surface %{public}lld", mode.c_str(),
+                    static_cast<long long>(surfaceId));
+    }
+
+    napi_value result;
+    napi_get_boolean(env, videoRenderer != nullptr, &result);
+    return result;
+}
+
+// 获取渲染端统计
+static napi_value GetRenderStats(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (argc != 1) {
+        napi_throw_error(env, nullptr, "Expected 1 argument: surfaceId");
+        return nullptr;
+    }
+
+    int64_t surfaceId = 0;
+    bool lossless = true;
+    if (napi_ok != napi_get_value_bigint_int64(env, args[0], &surfaceId, &lossless)) {
+        napi_throw_error(env, nullptr, "Failed to get surfaceId");
+        return nullptr;
+    }
+
+    auto videoRenderer = PluginManager::GetVideoRenderer(surfaceId);
+    VideoStreamNS::RenderStats stats = videoRenderer ? videoRenderer->GetRenderStats() : VideoStreamNS::RenderStats();
+
+    napi_value result;
+    napi_create_object(env, &result);
+    SetNamedInt32(env, result, "renderedFrames", static_cast<int32_t>(stats.renderedFrames));
+    SetNamedInt32(env, result, "renderFailures", static_cast<int32_t>(stats.renderFailures));
+    SetNamedInt32(env, result, "queueDrops", static_cast<int32_t>(stats.queueDrops));
+    SetNamedInt32(env, result, "uploads", static_cast<int32_t>(stats.uploads));
+    SetNamedInt32(env, result, "fenceWaits", static_cast<int32_t>(stats.fenceWaits));
+    SetNamedInt32(env, result, "fenceTimeouts", static_cast<int32_t>(stats.fenceTimeouts));
+    return result;
+}
+
+// 设置逐帧日志级别：'off'、'debug'或'info'，仅在编译时开启FRAME_LOG_ENABLED时有效
+static napi_value SetFrameLogLevel(napi_env env, napi_callback_info info) {
+    size_t argc = 1;
+    napi_value args[1];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (argc != 1) {
+        napi_throw_error(env, nullptr, "Expected 1 argument: level");
+        return nullptr;
+    }
+
+    size_t levelLength;
+    napi_get_value_string_utf8(env, args[0], nullptr, 0, &levelLength);
+    std::string level(levelLength, '\0');
+    napi_get_value_string_utf8(env, args[0], &level[0], levelLength + 1, &levelLength);
+    if (level == "debug") {
+        FrameLog::SetLevel(LOG_DEBUG);
+    } else if (level == "info") {
+        FrameLog::SetLevel(LOG_INFO);
+    } else if (level == "off") {
+        FrameLog::SetLevel(FrameLog::LEVEL_OFF);
+    } else {
+        napi_throw_error(env, nullptr, "Frame log level must be 'off', 'debug' or 'info'");
+        return nullptr;
+    }
+
+    napi_value result;
+    napi_get_boolean(env, FRAME_LOG_ENABLED != 0, &result);
+    return result;
+}
+
+// 调整流在共享解码执行器上的优先级：可见或获得焦点的流优先解码
+static napi_value SetStreamPriority(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (argc != 2) {
+        napi_throw_error(env, nullptr, "Expected 2 arguments: url and priority");
+        return nullptr;
+    }
+
+    size_t url_length;
+    napi_get_value_string_utf8(env, args[0], nullptr, 0, &url_length);
+    std::string url(url_length, '\0');
+    napi_get_value_string_utf8(env, args[0], &url[0], url_length + 1, &url_length);
+
+    size_t priorityLength;
+    napi_get_value_string_utf8(env, args[1], nullptr, 0, &priorityLength);
+    std::string priorityName(priorityLength, '\0');
+    napi_get_value_string_utf8(env, args[1], &priorityName[0], priorityLength + 1, &priorityLength);
+    StreamPriority priority = StreamPriority::Normal;
+    if (!ParseStreamPriority(priorityName, priority)) {
+        napi_throw_error(env, nullptr, "Priority must be 'low', 'normal' or 'high'");
+        return nullptr;
+    }
+
+    bool success = false;
+    auto it = g_streamHandlers.find(url);
+    if (it != g_streamHandlers.end()) {
+        it->second->setPriority(priority);
+        success = true;
+    }
+
+    napi_value result;
+    napi_get_boolean(env, success, &result);
+    return result;
+}
+
+// 设置surface的可见状态：hidden只在关键帧时刷新，thumbnail降低解码和刷新频率，visible恢复正常
+static napi_value SetSurfaceVisibility(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value args[2];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (argc != 2) {
+        napi_throw_error(env, nullptr, "Expected 2 arguments: surfaceId and visibility");
+        return nullptr;
+    }
+
+    int64_t surfaceId = 0;
+    bool lossless = true;
+    if (napi_ok != napi_get_value_bigint_int64(env, args[0], &surfaceId, &lossless)) {
+        napi_throw_error(env, nullptr, "Failed to get surfaceId");
+        return nullptr;
+    }
+
+    size_t visibilityLength;
+    napi_get_value_string_utf8(env, args[1], nullptr, 0, &visibilityLength);
+    std::string visibilityName(visibilityLength, '\0');
+    napi_get_value_string_utf8(env, args[1], &visibilityName[0], visibilityLength + 1, &visibilityLength);
+    SurfaceVisibility visibility;
+    if (visibilityName == "visible") {
+        visibility = SurfaceVisibility::Visible;
+    } else if (visibilityName == "thumbnail") {
+        visibility = SurfaceVisibility::Thumbnail;
+    } else if (visibilityName == "hidden") {
+        visibility = SurfaceVisibility::Hidden;
+    } else {
+        napi_throw_error(env, nullptr, "Visibility must be 'visible', 'thumbnail' or 'hidden'");
+        return nullptr;
+    }
+
+    // surface可能订阅了多路流
+    bool success = false;
+    for (auto &entry : g_streamHandlers) {
+        success = entry.second->setSubscriberVisibility(surfaceId, visibility) || success;
+    }
+
+    napi_value result;
+    napi_get_boolean(env, success, &result);
+    return result;
+}
+
+// 获取共享解码执行器的统计
+static napi_value GetExecutorStats(napi_env env, napi_callback_info info) {
+    StreamExecutorStats stats = StreamExecutor::shared().getStats();
+
+    napi_value result;
+    napi_create_object(env, &result);
+    SetNamedInt32(env, result, "workers", static_cast<int32_t>(stats.workers));
+    SetNamedInt32(env, result, "pendingTasks", static_cast<int32_t>(stats.pendingTasks));
+
+    napi_value executed;
+    napi_create_double(env, static_cast<double>(stats.executedTasks), &executed);
+    napi_set_named_property(env, result, "executedTasks", executed);
+
+    napi_value stolen;
+    napi_create_double(env, static_cast<double>(stats.stolenTasks), &stolen);
+    napi_set_named_property(env, result, "stolenTasks", stolen);
+    return result;
+}
+
+// 一次截图请求：持有最近一帧的引用，在libuv工作线程上缩放和编码，完成后回到JS线程兑现promise
+struct SnapshotRequest {
+    napi_async_work work = nullptr;
+    napi_deferred deferred = nullptr;
+    VideoFrame frame;
+    SnapshotOptions options;
+    AVPacket *output = nullptr; // 编码结果，成功时所有权转给返回的ArrayBuffer
+    std::string error;
+    bool success = false;
+};
+
+static void RejectWithMessage(napi_env env, napi_deferred deferred, const std::string &message) {
+    napi_value messageValue;
+    napi_value error;
+    napi_create_string_utf8(env, message.c_str(), message.size(), &messageValue);
+    napi_create_error(env, nullptr, messageValue, &error);
+    napi_reject_deferred(env, deferred, error);
+}
+
+static void ExecuteSnapshot(napi_env env, void *data) {
+    SnapshotRequest *request = static_cast<SnapshotRequest *>(data);
+    request->output = av_packet_alloc();
+    if (!request->output) {
+        request->error = "Failed to allocate snapshot packet";
+    } else {
+        request->success = EncodeSnapshot(request->frame, request->options, request->output, request->error);
+    }
+    // 编码完成后尽早把缓冲区还给帧池
+    request->frame = VideoFrame();
+}
+
+// ArrayBuffer被回收时释放它引用的编码数据
+static void FinalizeSnapshotBuffer(napi_env env, void *data, void *hint) {
+    AVPacket *packet = static_cast<AVPacket *>(hint);
+    av_packet_free(&packet);
+}
+
+static void CompleteSnapshot(napi_env env, napi_status status, void *data) {
+    SnapshotRequest *request = static_cast<SnapshotRequest *>(data);
+    if (status != napi_ok) {
+        RejectWithMessage(env, request->deferred, "Snapshot cancelled");
+    } else if (!request->success) {
+        RejectWithMessage(env, request->deferred, request->error);
+    } else {
+        // ArrayBuffer直接引用编码器输出的数据，不再复制
+        napi_value buffer;
+        if (napi_create_external_arraybuffer(env, request->output->data, request->output->size,
+                                             FinalizeSnapshotBuffer, request->output, &buffer) != napi_ok) {
+            RejectWithMessage(env, request->deferred, "Failed to create snapshot buffer");
+        } else {
+            request->output = nullptr;
+            napi_resolve_deferred(env, request->deferred, buffer);
+        }
+    }
+    av_packet_free(&request->output);
+    napi_delete_async_work(env, request->work);
+    delete request;
+}
+
+// 截取流最近解码的一帧，返回Promise<ArrayBuffer>，内容为JPEG或PNG文件数据。
+// 只增加帧的引用计数，不阻塞解码和渲染；缩放、转换和编码在后台工作线程完成
+static napi_value CaptureSnapshot(napi_env env, napi_callback_info info) {
+    size_t argc = 3;
+    napi_value args[3];
+    napi_get_cb_info(env, info, &argc, args, nullptr, nullptr);
+
+    if (argc < 1) {
+        napi_throw_error(env, nullptr, "Expected arguments: url, maxWidth and format");
+        return nullptr;
+    }
+
+    size_t url_length;
+    napi_get_value_string_utf8(env, args[0], nullptr, 0, &url_length);
+    std::string url(url_length, '\0');
+    napi_get_value_string_utf8(env, args[0], &url[0], url_length + 1, &url_length);
+
+    SnapshotOptions options;
+    if (argc >= 2) {
+        int32_t maxWidth = 0;
+        napi_valuetype type;
+        napi_typeof(env, args[1], &type);
+        if (type != napi_undefined && (napi_get_value_int32(env, args[1], &maxWidth) != napi_ok || maxWidth < 0)) {
+            napi_throw_error(env, nullptr, "maxWidth must be a non-negative number");
+            return nullptr;
+        }
+        options.maxWidth = maxWidth;
+    }
+    if (argc >= 3) {
+        napi_valuetype type;
+        napi_typeof(env, args[2], &type);
+        if (type != napi_undefined) {
+            size_t formatLength;
+            napi_get_value_string_utf8(env, args[2], nullptr, 0, &formatLength);
+            std::string formatName(formatLength, '\0');
+            napi_get_value_string_utf8(env, args[2], &formatName[0], formatLength + 1, &formatLength);
+            if (formatName == "jpeg") {
+                options.format = SnapshotFormat::Jpeg;
+            } else if (formatName == "png") {
+                options.format = SnapshotFormat::Png;
+            } else {
+                napi_throw_error(env, nullptr, "Format must be 'jpeg' or 'png'");
+                return nullptr;
+            }
+        }
+    }
+
+    SnapshotRequest *request = new SnapshotRequest();
+    request->options = options;
+    napi_value promise;
+    napi_create_promise(env, &request->deferred, &promise);
+
+    auto it = g_streamHandlers.find(url);
+    if (it != g_streamHandlers.end()) {
+        request->frame = it->second->getLatestFrame();
+    }
+    if (!request->frame.isValid()) {
+        RejectWithMessage(env, request->deferred,
+                          it == g_streamHandlers.end() ? "No stream for url: " + url : "No decoded frame yet: " + url);
+        delete request;
+        return promise;
+    }
+
+    napi_value resourceName;
+    napi_create_string_utf8(env, "captureSnapshot", NAPI_AUTO_LENGTH, &resourceName);
+    if (napi_create_async_work(env, nullptr, resourceName, ExecuteSnapshot, CompleteSnapshot, request,
+                               &request->work) != napi_ok ||
+        napi_queue_async_work(env, request->work) != napi_ok) {
+        RejectWithMessage(env, request->deferred, "Failed to queue snapshot");
+        if (request->work) {
+            napi_delete_async_work(env, request->work);
+        }
+        delete request;
+    }
+    return promise;
+}
+
 EXTERN_C_START
 static napi_value Init(napi_env env, napi_value exports) {
     napi_property_descriptor desc[] = {
@@ -287,12 +1133,21 @@ static napi_value Init(napi_env env, napi_value exports) {
         {"stopVideoStream", nullptr, StopVideoStream, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"getStreamStatus", nullptr, GetStreamStatus, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"getFrameStats", nullptr, GetFrameStats, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getStartupTrace", nullptr, GetStartupTrace, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getStartupHistogram", nullptr, GetStartupHistogram, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"updateVideoSurfaceSize", nullptr, UpdateVideoSurfaceSize, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setUploadMode", nullptr, SetUploadMode, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getRenderStats", nullptr, GetRenderStats, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setFrameLogLevel", nullptr, SetFrameLogLevel, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setStreamPriority", nullptr, SetStreamPriority, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"setSurfaceVisibility", nullptr, SetSurfaceVisibility, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"getExecutorStats", nullptr, GetExecutorStats, nullptr, nullptr, nullptr, napi_default, nullptr},
+        {"captureSnapshot", nullptr, CaptureSnapshot, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"setSurfaceId", nullptr, PluginManager::SetSurfaceId, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"changeSurface", nullptr, PluginManager::ChangeSurface, nullptr, nullptr, nullptr, napi_default, nullptr},
         {"getXComponentStatus", nullptr, PluginManager::GetXComponentStatus, nullptr, nullptr, nullptr, napi_default,
          nullptr},
-        {"destroySurface", nullptr, PluginManager::DestroySurface, nullptr, nullptr, nullptr, napi_default, nullptr}};
+        {"destroySurface", nullptr, DestroySurface, nullptr, nullptr, nullptr, napi_default, nullptr}};
     napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc);
     return exports;
 }
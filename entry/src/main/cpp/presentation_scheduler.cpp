@@ -0,0 +1,121 @@
+#include "presentation_scheduler.h"
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/avutil.h>
+#include <libavutil/mathematics.h>
+}
+
+namespace {
+// 帧率未知时的帧间隔
+const int64_t DEFAULT_FRAME_DURATION_US = 40000;
+
+// 迟到多少以内仍然呈现：至少一帧间隔，且不小于该值以吸收网络抖动
+const int64_t MIN_LATE_THRESHOLD_US = 20000;
+
+// pts与时钟偏离超过该值视为时间轴跳变，重新锚定
+const int64_t DISCONTINUITY_THRESHOLD_US = 1000000;
+
+// 帧间隔估计的平滑系数
+const double FRAME_DURATION_SMOOTHING = 0.1;
+} // namespace
+
+PresentationScheduler::PresentationScheduler()
+    : timeBase_{1, AV_TIME_BASE}, frameDurationUs_(DEFAULT_FRAME_DURATION_US), anchored_(false), anchorPtsUs_(0),
+      anchorClockUs_(0), rate_(1.0), lastPtsUs_(AV_NOPTS_VALUE), lastPresentUs_(AV_NOPTS_VALUE), displayed_(0), droppedLate_(0),
+      repeated_(0) {}
+
+void PresentationScheduler::reset(AVRational timeBase, double frameRate) {
+    timeBase_ = timeBase.num > 0 && timeBase.den > 0 ? timeBase : AVRational{1, AV_TIME_BASE};
+    frameDurationUs_ = frameRate > 0 ? static_cast<int64_t>(AV_TIME_BASE / frameRate) : DEFAULT_FRAME_DURATION_US;
+    anchored_ = false;
+    rate_ = 1.0;
+    lastPtsUs_ = AV_NOPTS_VALUE;
+    lastPresentUs_ = AV_NOPTS_VALUE;
+    displayed_ = 0;
+    droppedLate_ = 0;
+    repeated_ = 0;
+}
+
+void PresentationScheduler::anchor(int64_t ptsUs, int64_t nowUs) {
+    anchored_ = true;
+    anchorPtsUs_ = ptsUs;
+    anchorClockUs_ = nowUs;
+}
+
+void PresentationScheduler::setRate(double rate) {
+    if (rate <= 0 || rate == rate_) {
+        return;
+    }
+    // 以最近一帧的呈现时间为新锚点，之后的pts差值按新速率折算
+    if (anchored_ && lastPtsUs_ != AV_NOPTS_VALUE) {
+        anchorClockUs_ += static_cast<int64_t>((lastPtsUs_ - anchorPtsUs_) / rate_);
+        anchorPtsUs_ = lastPtsUs_;
+    }
+    rate_ = rate;
+}
+
+void PresentationScheduler::resync() { anchored_ = false; }
+
+PresentAction PresentationScheduler::evaluate(int64_t pts, int64_t nowUs, bool hasNewerFrame, int64_t &waitUs) {
+    waitUs = 0;
+    PresentAction action = PresentAction::Present;
+
+    if (pts != AV_NOPTS_VALUE) {
+        int64_t ptsUs = av_rescale_q(pts, timeBase_, AVRational{1, AV_TIME_BASE});
+        if (!anchored_) {
+            anchor(ptsUs, nowUs);
+        }
+        int64_t targetUs = anchorClockUs_ + static_cast<int64_t>((ptsUs - anchorPtsUs_) / rate_);
+        if (targetUs - nowUs > DISCONTINUITY_THRESHOLD_US || nowUs - targetUs > DISCONTINUITY_THRESHOLD_US) {
+            anchor(ptsUs, nowUs);
+            targetUs = nowUs;
+        }
+
+        int64_t lateUs = nowUs - targetUs;
+        int64_t lateThresholdUs = std::max(frameDurationUs_, MIN_LATE_THRESHOLD_US);
+        if (lateUs < 0) {
+            waitUs = -lateUs;
+            return PresentAction::Wait;
+        }
+        if (lateUs > lateThresholdUs) {
+            if (hasNewerFrame) {
+                action = PresentAction::Drop;
+            } else {
+                // 严重迟到且没有更新的帧可用：呈现这一帧，并把时钟顺延，让后续帧以它为基准。
+                // 阈值以内的迟到（如休眠超出）不顺延，否则锚点逐帧后移，延迟不断累积
+                anchorClockUs_ += lateUs;
+            }
+        }
+        // 等待中的帧会被反复评估，帧间隔只在帧呈现或丢弃时计入一次
+        if (lastPtsUs_ != AV_NOPTS_VALUE && ptsUs > lastPtsUs_ && ptsUs - lastPtsUs_ < DISCONTINUITY_THRESHOLD_US) {
+            frameDurationUs_ += static_cast<int64_t>((ptsUs - lastPtsUs_ - frameDurationUs_) *
+                                                     FRAME_DURATION_SMOOTHING);
+        }
+        lastPtsUs_ = ptsUs;
+    }
+
+    if (action == PresentAction::Drop) {
+        droppedLate_++;
+        return action;
+    }
+
+    // 距上次呈现超过1.5个帧间隔，说明上一帧被重复显示
+    if (lastPresentUs_ != AV_NOPTS_VALUE && frameDurationUs_ > 0) {
+        int64_t gapUs = nowUs - lastPresentUs_;
+        if (gapUs * 2 > frameDurationUs_ * 3) {
+            repeated_ += static_cast<uint64_t>((gapUs + frameDurationUs_ / 2) / frameDurationUs_ - 1);
+        }
+    }
+    lastPresentUs_ = nowUs;
+    displayed_++;
+    return action;
+}
+
+PresentationStats PresentationScheduler::getStats() const {
+    PresentationStats stats;
+    stats.displayed = displayed_.load();
+    stats.droppedLate = droppedLate_.load();
+    stats.repeated = repeated_.load();
+    return stats;
+}
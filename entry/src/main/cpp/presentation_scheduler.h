@@ -0,0 +1,64 @@
+#ifndef PRESENTATION_SCHEDULER_H
+#define PRESENTATION_SCHEDULER_H
+
+#include <atomic>
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/rational.h>
+}
+
+// 呈现统计
+struct PresentationStats {
+    uint64_t displayed = 0;   // 交给渲染的帧数
+    uint64_t droppedLate = 0; // 已经过了呈现时间且有更新的帧可用而丢弃的帧数
+    uint64_t repeated = 0;    // 新帧未按时到达、上一帧在屏幕上多停留的帧周期数
+};
+
+// 解码后的呈现时机决策
+enum class PresentAction {
+    Wait,    // 尚未到呈现时间
+    Present, // 立即交给渲染
+    Drop,    // 已经迟到，丢弃
+};
+
+// 基于pts的呈现调度。
+// 首帧将pts经time_base映射到单调时钟建立锚点，之后按pts差值推算每帧的呈现时间；
+// 迟到超过阈值且后面已有新帧时丢弃，只剩这一帧时照常呈现并把锚点顺延，避免后续帧全部判为迟到；
+// 阈值以内的迟到照常呈现，锚点不动。
+// pts跳变（回绕、重连）超过阈值时重新锚定。只应在单个线程上调用evaluate()。
+class PresentationScheduler {
+public:
+    PresentationScheduler();
+
+    void reset(AVRational timeBase, double frameRate);
+
+    // nowUs为单调时钟（av_gettime_relative）；返回Wait时waitUs为距呈现时间的微秒数
+    PresentAction evaluate(int64_t pts, int64_t nowUs, bool hasNewerFrame, int64_t &waitUs);
+
+    // 播放速率，大于1时按更快的节奏呈现以消化积压
+    void setRate(double rate);
+
+    // 放弃当前锚点，下一帧到达时立即呈现并重新锚定
+    void resync();
+
+    PresentationStats getStats() const;
+
+private:
+    void anchor(int64_t ptsUs, int64_t nowUs);
+
+    AVRational timeBase_;
+    int64_t frameDurationUs_; // 帧间隔估计，用于迟到阈值和重复帧统计
+    bool anchored_;
+    int64_t anchorPtsUs_;
+    int64_t anchorClockUs_;
+    double rate_;
+    int64_t lastPtsUs_;
+    int64_t lastPresentUs_;
+
+    std::atomic<uint64_t> displayed_;
+    std::atomic<uint64_t> droppedLate_;
+    std::atomic<uint64_t> repeated_;
+};
+
+#endif // PRESENTATION_SCHEDULER_H
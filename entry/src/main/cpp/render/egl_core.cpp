@@ -30,6 +30,7 @@
 #endif
 
 #include "egl_core.h"
+#include "../common/frame_log.h"
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -37,6 +38,7 @@
 #include <GLES3/gl3.h>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <hilog/log.h>
 #include <native_window/external_window.h>
 #include <string>
@@ -93,75 +95,6 @@ bool CheckGLError(const char *operation) {
     return true;
 }
 
-/**
- * Print complete first frame YUV data and terminate program
- */
-void PrintFirstFrameDataAndExit(const VideoFrame &frame) {
-    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore", "=== FIRST FRAME DATA ANALYSIS ===");
-    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore",
-                 "Frame: %{public}dx%{public}d, linesize[Y=%{public}d, U=%{public}d, V=%{public}d]", frame.width,
-                 frame.height, frame.linesize[0], frame.linesize[1], frame.linesize[2]);
-
-    // 打印Y平面完整数据 - 每行一个字符串
-    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore", "=== Y PLANE FULL DATA ===");
-    for (int row = 0; row < frame.height; row++) {
-        std::string line_data = "";
-        for (int col = 0; col < frame.linesize[0]; col++) {
-            if (col > 0)
-                line_data += " ";
-            line_data += std::to_string(frame.data[0][row * frame.linesize[0] + col]);
-        }
-        OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore", "Y_row_%{public}d: %{public}s", row,
-                     line_data.c_str());
-    }
-
-    // 打印U平面完整数据
-    if (frame.data[1] != nullptr) {
-        OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore", "=== U PLANE FULL DATA ===");
-        for (int row = 0; row < frame.height / 2; row++) {
-            std::string line_data = "";
-            for (int col = 0; col < frame.linesize[1]; col++) {
-                if (col > 0)
-                    line_data += " ";
-                line_data += std::to_string(frame.data[1][row * frame.linesize[1] + col]);
-            }
-            OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore", "U_row_%{public}d: %{public}s", row,
-                         line_data.c_str());
-        }
-    }
-
-    // 打印V平面完整数据
-    if (frame.data[2] != nullptr) {
-        OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore", "=== V PLANE FULL DATA ===");
-        for (int row = 0; row < frame.height / 2; row++) {
-            std::string line_data = "";
-            for (int col = 0; col < frame.linesize[2]; col++) {
-                if (col > 0)
-                    line_data += " ";
-                line_data += std::to_string(frame.data[2][row * frame.linesize[2] + col]);
-            }
-            OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore", "V_row_%{public}d: %{public}s", row,
-                         line_data.c_str());
-        }
-    }
-
-    // 数据指针地址
-    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore",
-                 "Data pointers: Y=%{public}p, U=%{public}p, V=%{public}p", frame.data[0], frame.data[1],
-                 frame.data[2]);
-
-    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore", "=== END FIRST FRAME DATA ANALYSIS ===");
-    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore",
-                 "First frame analysis complete. Terminating program to ensure complete output.");
-
-    // 强制刷新日志输出
-    fflush(stdout);
-    fflush(stderr);
-
-    // 程序终止，确保第一帧数据完整输出
-    exit(0);
-}
-
 /**
  * Create a test YUV frame with gradient pattern and FFmpeg-style padding
  */
@@ -271,6 +204,28 @@ const char YUV_FRAGMENT_SHADER[] = "#version 300 es\n"
                                    "    fragColor = vec4(r, g, b, 1.0);\n"
                                    "}\n";
 
+/**
+ * NV12/NV21 to RGB fragment shader, chroma sampled from one interleaved RG texture.
+ */
+const char NV12_FRAGMENT_SHADER[] = "#version 300 es\n"
+                                    "precision mediump float;\n"
+                                    "in vec2 v_texCoord;\n"
+                                    "out vec4 fragColor;\n"
+                                    "uniform sampler2D y_texture;\n"
+                                    "uniform sampler2D uv_texture;\n"
+                                    "uniform bool uv_swap;\n" // NV21为VU顺序
+                                    "void main() {\n"
+                                    "    float y = texture(y_texture, v_texCoord).r;\n"
+                                    "    vec2 uv = texture(uv_texture, v_texCoord).rg - 0.5;\n"
+                                    "    if (uv_swap) {\n"
+                                    "        uv = uv.yx;\n"
+                                    "    }\n"
+                                    "    float r = y + 1.402 * uv.y;\n"
+                                    "    float g = y - 0.344136 * uv.x - 0.714136 * uv.y;\n"
+                                    "    float b = y + 1.772 * uv.x;\n"
+                                    "    fragColor = vec4(r, g, b, 1.0);\n"
+                                    "}\n";
+
 /**
  * Quad vertices for full screen rendering.
  * Format: x, y, u, v
@@ -320,6 +275,46 @@ const int DEFAULT_Y_POSITION = 0;
  */
 const GLuint PROGRAM_ERROR = 0;
 
+/**
+ * Max time to wait for the GPU to release a pixel buffer, in nanoseconds.
+ */
+const GLuint64 PBO_FENCE_TIMEOUT_NS = 50000000;
+
+/**
+ * Interval between render summary logs, which replace per-frame logs.
+ */
+const auto RENDER_SUMMARY_INTERVAL = std::chrono::seconds(5);
+
+/**
+ * Size of one texture plane.
+ */
+struct TexturePlane {
+    int width;
+    int height;
+    int bytesPerPixel;
+};
+
+/**
+ * NV12/NV21: Y plane followed by one interleaved chroma plane.
+ */
+bool IsSemiPlanarFormat(int format) { return format == AV_PIX_FMT_NV12 || format == AV_PIX_FMT_NV21; }
+
+/**
+ * Texture planes of a frame: Y, U, V for planar formats, Y and interleaved UV for NV12/NV21.
+ */
+int GetTexturePlanes(int width, int height, int format, TexturePlane planes[3]) {
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+    planes[0] = {width, height, 1};
+    if (IsSemiPlanarFormat(format)) {
+        planes[1] = {chromaWidth, chromaHeight, 2};
+        return 2;
+    }
+    planes[1] = {chromaWidth, chromaHeight, 1};
+    planes[2] = {chromaWidth, chromaHeight, 1};
+    return 3;
+}
+
 /**
  * Config attribute list.
  */
@@ -390,6 +385,14 @@ bool EGLCore::EglContextInit(void *window) {
     return CreateEnvironment();
 }
 
+bool EGLCore::MakeCurrent() {
+    // 上下文已绑定在当前线程时跳过eglMakeCurrent
+    if (eglGetCurrentContext() == eglContext_ && eglGetCurrentSurface(EGL_DRAW) == eglSurface_) {
+        return true;
+    }
+    return eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+}
+
 bool EGLCore::CreateEnvironment() {
     // Create surface.
     if (eglWindow_ == nullptr) {
@@ -413,12 +416,22 @@ bool EGLCore::CreateEnvironment() {
         OH_LOG_Print(LOG_APP, LOG_ERROR, LOG_PRINT_DOMAIN, "EGLCore", "eglMakeCurrent failed");
         return false;
     }
+    // 交换与vsync同步，呈现节奏由解码端按pts调度
+    if (!eglSwapInterval(eglDisplay_, 1)) {
+        OH_LOG_Print(LOG_APP, LOG_WARN, LOG_PRINT_DOMAIN, "EGLCore", "eglSwapInterval failed");
+    }
     // Create program.
     program_ = CreateProgram(YUV_VERTEX_SHADER, YUV_FRAGMENT_SHADER);
     if (program_ == PROGRAM_ERROR) {
         OH_LOG_Print(LOG_APP, LOG_ERROR, LOG_PRINT_DOMAIN, "EGLCore", "CreateProgram: unable to create program");
         return false;
     }
+    semiPlanarProgram_ = CreateProgram(YUV_VERTEX_SHADER, NV12_FRAGMENT_SHADER);
+    if (semiPlanarProgram_ == PROGRAM_ERROR) {
+        OH_LOG_Print(LOG_APP, LOG_ERROR, LOG_PRINT_DOMAIN, "EGLCore",
+                     "CreateProgram: unable to create semi-planar program");
+        return false;
+    }
 
     // Initialize YUV textures and buffers
     if (!InitYUVTextures()) {
@@ -456,39 +469,18 @@ bool EGLCore::InitYUVTextures() {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *)(2 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    // Generate YUV textures
-    glGenTextures(1, &yTexture_);
-    glGenTextures(1, &uTexture_);
-    glGenTextures(1, &vTexture_);
+    // 帧数据按linesize逐行上传，行长度通过GL_UNPACK_ROW_LENGTH指定，对齐固定为1字节
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    // Configure Y texture parameters (only once during initialization)
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, yTexture_);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    // Configure U texture parameters (only once during initialization)
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, uTexture_);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    // Configure V texture parameters (only once during initialization)
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, vTexture_);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // YUV纹理存储在收到第一帧时按帧尺寸分配，见EnsureYUVTextures
 
     // Get uniform locations
     yTextureLocation_ = glGetUniformLocation(program_, "y_texture");
     uTextureLocation_ = glGetUniformLocation(program_, "u_texture");
     vTextureLocation_ = glGetUniformLocation(program_, "v_texture");
+    semiPlanarYTextureLocation_ = glGetUniformLocation(semiPlanarProgram_, "y_texture");
+    uvTextureLocation_ = glGetUniformLocation(semiPlanarProgram_, "uv_texture");
+    uvSwapLocation_ = glGetUniformLocation(semiPlanarProgram_, "uv_swap");
 
     texturesInitialized_ = true;
 
@@ -497,6 +489,34 @@ bool EGLCore::InitYUVTextures() {
 
 
 bool EGLCore::RenderYUVFrame(const VideoFrame &frame) {
+    // 成功与失败都只计数，由LogSummary定期输出
+    bool rendered = RenderFrame(frame);
+    if (rendered) {
+        renderedFrameCount_++;
+    } else {
+        renderFailureCount_++;
+    }
+    LogSummary();
+    return rendered;
+}
+
+void EGLCore::LogSummary() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - summaryTime_ < RENDER_SUMMARY_INTERVAL) {
+        return;
+    }
+    uint64_t rendered = renderedFrameCount_.load();
+    double seconds = std::chrono::duration<double>(now - summaryTime_).count();
+    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore",
+                 "Rendered %{public}llu frames, %{public}.1f fps, failures %{public}llu, fence waits %{public}llu",
+                 static_cast<unsigned long long>(rendered), (rendered - summaryFrameCount_) / seconds,
+                 static_cast<unsigned long long>(renderFailureCount_.load()),
+                 static_cast<unsigned long long>(fenceWaitCount_.load()));
+    summaryTime_ = now;
+    summaryFrameCount_ = rendered;
+}
+
+bool EGLCore::RenderFrame(const VideoFrame &frame) {
     if (!texturesInitialized_) {
         OH_LOG_Print(LOG_APP, LOG_ERROR, LOG_PRINT_DOMAIN, "EGLCore", "Textures not initialized");
         return false;
@@ -514,18 +534,8 @@ bool EGLCore::RenderYUVFrame(const VideoFrame &frame) {
 //        return true; // 返回true表示"成功"，但实际上跳过了渲染
 //    }
 
-     //todo test 直接使用自生成的帧进行测试
-     // LoadYUVFromRawfile(frame);
-    
-      // 打印第一帧的详细数据
-//     if (frame.data[0] != nullptr) {
-//         PrintFirstFrameDataAndExit(frame);
-//     }
-    
-    
-
-    // 确保EGL上下文是当前的
-    if (!eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_)) {
+    // 上下文由渲染线程在初始化时绑定，这里只做检查
+    if (!MakeCurrent()) {
         OH_LOG_Print(LOG_APP, LOG_ERROR, LOG_PRINT_DOMAIN, "EGLCore", "RenderYUVFrame: eglMakeCurrent failed");
         return false;
     }
@@ -536,32 +546,28 @@ bool EGLCore::RenderYUVFrame(const VideoFrame &frame) {
         return false;
     }
 
+    std::shared_ptr<StartupTrace> trace;
+    if (traceArmed_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(traceMutex_);
+        trace = startupTrace_;
+        if (trace) {
+            trace->mark(StartupPhase::FirstTextureUpload);
+        }
+    }
+
     // Clear and prepare for rendering
     glViewport(DEFAULT_X_POSITION, DEFAULT_Y_POSITION, width_, height_);
     glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // Use shader program
-    glUseProgram(program_);
-
-    // Bind textures
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, yTexture_);
-    glUniform1i(yTextureLocation_, 0);
-
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, uTexture_);
-    glUniform1i(uTextureLocation_, 1);
-
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, vTexture_);
-    glUniform1i(vTextureLocation_, 2);
+    // Use shader program and bind textures
+    BindYUVTextures();
 
     // Draw the quad
     DrawQuad();
 
-    // 检查OpenGL错误
-    if (!CheckGLError("after DrawQuad")) {
+    // 检查OpenGL错误：错误标志在查询前一直保留，每帧只在这里查询一次，上传和绘制中的错误都会在此报告
+    if (!CheckGLError("RenderYUVFrame")) {
         return false;
     }
 
@@ -575,6 +581,11 @@ bool EGLCore::RenderYUVFrame(const VideoFrame &frame) {
         return false;
     }
 
+    if (trace) {
+        trace->mark(StartupPhase::FirstSwap);
+        traceArmed_ = false;
+    }
+
     // 标记第一帧已经渲染完成
 //    if (!firstFrameRendered_) {
 //        firstFrameRendered_ = true;
@@ -582,10 +593,73 @@ bool EGLCore::RenderYUVFrame(const VideoFrame &frame) {
 //                     "First frame rendered successfully. Subsequent frames will be skipped.");
 //    }
 
-    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore", "Frame rendered successfully to surface");
     return true;
 }
 
+bool EGLCore::EnsureYUVTextures(int width, int height, int format) {
+    // 尺寸和平面布局不变时沿用现有存储；NV12与NV21之间只是采样顺序不同
+    if (width == textureWidth_ && height == textureHeight_ &&
+        IsSemiPlanarFormat(format) == IsSemiPlanarFormat(textureFormat_)) {
+        textureFormat_ = format;
+        return true;
+    }
+
+    // 不可变存储无法重新指定尺寸，尺寸或布局变化时整体重建
+    if (yTexture_ != 0) {
+        GLuint textures[] = {yTexture_, uTexture_, vTexture_};
+        glDeleteTextures(3, textures);
+        yTexture_ = uTexture_ = vTexture_ = 0;
+    }
+
+    TexturePlane planes[3];
+    const int planeCount = GetTexturePlanes(width, height, format, planes);
+    GLuint *textures[] = {&yTexture_, &uTexture_, &vTexture_};
+    for (int i = 0; i < planeCount; i++) {
+        glGenTextures(1, textures[i]);
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, *textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexStorage2D(GL_TEXTURE_2D, 1, planes[i].bytesPerPixel == 2 ? GL_RG8 : GL_R8, planes[i].width,
+                       planes[i].height);
+    }
+    if (!CheckGLError("EnsureYUVTextures")) {
+        return false;
+    }
+
+    textureWidth_ = width;
+    textureHeight_ = height;
+    textureFormat_ = format;
+    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore",
+                 "YUV texture storage allocated: %{public}dx%{public}d, %{public}d planes", width, height, planeCount);
+    return true;
+}
+
+void EGLCore::BindYUVTextures() {
+    // 半平面格式时uTexture_存放交错的UV平面，vTexture_不使用
+    const bool semiPlanar = IsSemiPlanarFormat(textureFormat_);
+    glUseProgram(semiPlanar ? semiPlanarProgram_ : program_);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, yTexture_);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, uTexture_);
+    if (semiPlanar) {
+        glUniform1i(semiPlanarYTextureLocation_, 0);
+        glUniform1i(uvTextureLocation_, 1);
+        glUniform1i(uvSwapLocation_, textureFormat_ == AV_PIX_FMT_NV21);
+        return;
+    }
+
+    glUniform1i(yTextureLocation_, 0);
+    glUniform1i(uTextureLocation_, 1);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, vTexture_);
+    glUniform1i(vTextureLocation_, 2);
+}
+
 bool EGLCore::UpdateYUVTextures(const VideoFrame &frame) {
     if (frame.data[0] == nullptr) {
         OH_LOG_Print(LOG_APP, LOG_ERROR, LOG_PRINT_DOMAIN, "EGLCore", "Y plane data is null");
@@ -606,109 +680,183 @@ bool EGLCore::UpdateYUVTextures(const VideoFrame &frame) {
     }
 
     // 添加数据验证
-    OH_LOG_Print(
-        LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore",
-        "UpdateYUVTextures: %{public}dx%{public}d, Y_linesize=%{public}d, U_linesize=%{public}d, V_linesize=%{public}d",
-        frame.width, frame.height, frame.linesize[0], frame.linesize[1], frame.linesize[2]);
-
-    // Clear any existing OpenGL errors
-    while (glGetError() != GL_NO_ERROR) {
+    FRAME_LOG(LOG_APP, LOG_DEBUG, LOG_PRINT_DOMAIN, "EGLCore",
+              "UpdateYUVTextures: %{public}dx%{public}d, Y_linesize=%{public}d, U_linesize=%{public}d, "
+              "V_linesize=%{public}d",
+              frame.width, frame.height, frame.linesize[0], frame.linesize[1], frame.linesize[2]);
+
+    // 上传方式的切换在渲染线程生效
+    UploadMode requestedMode = requestedUploadMode_.load(std::memory_order_relaxed);
+    if (requestedMode != uploadMode_) {
+        if (uploadMode_ == UploadMode::PixelBuffer) {
+            ReleasePixelBuffers();
+        }
+        uploadMode_ = requestedMode;
+        OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore", "Upload mode: %{public}s",
+                     uploadMode_ == UploadMode::PixelBuffer ? "pixel buffer" : "direct");
     }
 
-    // 保存当前的像素存储参数
-    GLint oldUnpackAlignment;
-    GLint oldUnpackRowLength;
-    glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldUnpackAlignment);
-    glGetIntegerv(GL_UNPACK_ROW_LENGTH, &oldUnpackRowLength);
-
-//    // Update Y texture with linesize padding handling
-//    glActiveTexture(GL_TEXTURE0);
-//    if (!CheckGLError("glActiveTexture(GL_TEXTURE0)"))
-//        return false;
-//
-//    glBindTexture(GL_TEXTURE_2D, yTexture_);
-//    if (!CheckGLError("glBindTexture Y texture"))
-//        return false;
-
-    // 设置像素存储参数来处理linesize填充
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);                  // 字节对齐
-    
-    
-    // Update Y texture with linesize padding handling
-    glActiveTexture(GL_TEXTURE0);
-    if (!CheckGLError("glActiveTexture(GL_TEXTURE0)"))
+    bool uploaded = uploadMode_ == UploadMode::PixelBuffer ? UploadPlanesViaPixelBuffers(frame)
+                                                            : UploadPlanesDirect(frame);
+    if (!uploaded) {
         return false;
+    }
+    uploadCount_++;
+    return true;
+}
 
-    glBindTexture(GL_TEXTURE_2D, yTexture_);
-    if (!CheckGLError("glBindTexture Y texture"))
+bool EGLCore::UploadPlanesDirect(const VideoFrame &frame) {
+    if (!EnsureYUVTextures(frame.width, frame.height, frame.format)) {
         return false;
-    
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, frame.linesize[0]); // 设置行长度为linesize
-    
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, frame.width, frame.height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE,
-                 frame.data[0]);
-    if (!CheckGLError("Y texture glTexImage2D with linesize"))
-        return false;
-
-    // Update U texture with linesize padding handling
-    if (frame.data[1] != nullptr) {
-        glActiveTexture(GL_TEXTURE1);
-        if (!CheckGLError("glActiveTexture(GL_TEXTURE1)"))
-            return false;
-
-        glBindTexture(GL_TEXTURE_2D, uTexture_);
-        if (!CheckGLError("glBindTexture U texture"))
-            return false;
+    }
 
-        // 设置U平面的行长度
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, frame.linesize[1]);
+    TexturePlane planes[3];
+    const int planeCount = GetTexturePlanes(frame.width, frame.height, frame.format, planes);
+    const GLuint textures[] = {yTexture_, uTexture_, vTexture_};
+    for (int i = 0; i < planeCount; i++) {
+        if (frame.data[i] == nullptr) {
+            continue;
+        }
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        // 行长度（以像素计）设为linesize以跳过FFmpeg的行尾填充
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, frame.linesize[i] / planes[i].bytesPerPixel);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, planes[i].width, planes[i].height,
+                        planes[i].bytesPerPixel == 2 ? GL_RG : GL_RED, GL_UNSIGNED_BYTE, frame.data[i]);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    // glGetError会同步GPU，逐帧的检查只在打开逐帧日志的构建中逐阶段定位，平时由RenderYUVFrame统一检查
+    return !FRAME_LOG_ENABLED || CheckGLError("YUV texture glTexSubImage2D");
+}
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, frame.width / 2, frame.height / 2, 0, GL_LUMINANCE,
-                     GL_UNSIGNED_BYTE, frame.data[1]);
-        if (!CheckGLError("U texture glTexImage2D with linesize"))
-            return false;
+bool EGLCore::UploadPlanesViaPixelBuffers(const VideoFrame &frame) {
+    TexturePlane planes[3];
+    int planeCount = GetTexturePlanes(frame.width, frame.height, frame.format, planes);
+    size_t frameSize = 0;
+    for (int i = 0; i < planeCount; i++) {
+        frameSize += static_cast<size_t>(planes[i].width) * planes[i].bytesPerPixel * planes[i].height;
+    }
+    if (frameSize > pixelBufferSize_ && !AllocatePixelBuffers(frameSize)) {
+        return false;
+    }
+    if (!EnsureYUVTextures(frame.width, frame.height, frame.format)) {
+        return false;
     }
 
-    // Update V texture with linesize padding handling
-    if (frame.data[2] != nullptr) {
-        glActiveTexture(GL_TEXTURE2);
-        if (!CheckGLError("glActiveTexture(GL_TEXTURE2)"))
-            return false;
+    // 1. 等待当前PBO上一轮的纹理读取完成；UNSYNCHRONIZED映射要求这里自行保证GPU不再使用它。
+    //    超时或出错时GPU可能仍在读取，不能覆盖：本帧改为直接上传，fence保留到下次轮到该PBO时再检查
+    const int slot = pixelBufferIndex_;
+    if (pixelBufferFences_[slot] != nullptr) {
+        GLenum status = glClientWaitSync(pixelBufferFences_[slot], 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            fenceWaitCount_++;
+            status = glClientWaitSync(pixelBufferFences_[slot], GL_SYNC_FLUSH_COMMANDS_BIT, PBO_FENCE_TIMEOUT_NS);
+        }
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            fenceTimeoutCount_++;
+            pixelBufferIndex_ = (slot + 1) % PBO_COUNT;
+            return UploadPlanesDirect(frame);
+        }
+        glDeleteSync(pixelBufferFences_[slot]);
+        pixelBufferFences_[slot] = nullptr;
+    }
 
-        glBindTexture(GL_TEXTURE_2D, vTexture_);
-        if (!CheckGLError("glBindTexture V texture"))
-            return false;
+    // 2. 将本帧逐行拷贝进当前PBO（去掉行尾填充）
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers_[slot]);
+    uint8_t *mapped = static_cast<uint8_t *>(
+        glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, frameSize,
+                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    if (mapped == nullptr) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        CheckGLError("glMapBufferRange");
+        return false;
+    }
+    uint8_t *dst = mapped;
+    for (int i = 0; i < planeCount; i++) {
+        const size_t rowBytes = static_cast<size_t>(planes[i].width) * planes[i].bytesPerPixel;
+        const uint8_t *src = frame.data[i];
+        for (int row = 0; row < planes[i].height; row++) {
+            if (src != nullptr) {
+                memcpy(dst, src + static_cast<size_t>(row) * frame.linesize[i], rowBytes);
+            } else {
+                memset(dst, 128, rowBytes);
+            }
+            dst += rowBytes;
+        }
+    }
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // 3. 从本帧的PBO更新纹理。从PBO的传输是异步的，下一帧写入环中的另一个PBO，
+    //    CPU拷贝与本帧的传输重叠，显示不延后
+    const GLuint textures[] = {yTexture_, uTexture_, vTexture_};
+    size_t offset = 0;
+    for (int i = 0; i < planeCount; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, planes[i].width, planes[i].height,
+                        planes[i].bytesPerPixel == 2 ? GL_RG : GL_RED, GL_UNSIGNED_BYTE,
+                        reinterpret_cast<const void *>(offset));
+        offset += static_cast<size_t>(planes[i].width) * planes[i].bytesPerPixel * planes[i].height;
+    }
+    pixelBufferFences_[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
-        // 设置V平面的行长度
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, frame.linesize[2]);
+    pixelBufferIndex_ = (slot + 1) % PBO_COUNT;
+    return !FRAME_LOG_ENABLED || CheckGLError("YUV texture upload from pixel buffer");
+}
 
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, frame.width / 2, frame.height / 2, 0, GL_LUMINANCE,
-                     GL_UNSIGNED_BYTE, frame.data[2]);
-        if (!CheckGLError("V texture glTexImage2D with linesize"))
-            return false;
+bool EGLCore::AllocatePixelBuffers(size_t size) {
+    ReleasePixelBuffers();
+    glGenBuffers(PBO_COUNT, pixelBuffers_);
+    for (int i = 0; i < PBO_COUNT; i++) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers_[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (!CheckGLError("AllocatePixelBuffers")) {
+        ReleasePixelBuffers();
+        return false;
     }
+    pixelBufferSize_ = size;
+    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore",
+                 "Allocated %{public}d pixel buffers of %{public}zu bytes", PBO_COUNT, size);
+    return true;
+}
 
-    // 恢复原来的像素存储参数
-    glPixelStorei(GL_UNPACK_ALIGNMENT, oldUnpackAlignment);
-    glPixelStorei(GL_UNPACK_ROW_LENGTH, oldUnpackRowLength);
+void EGLCore::ReleasePixelBuffers() {
+    for (int i = 0; i < PBO_COUNT; i++) {
+        if (pixelBufferFences_[i] != nullptr) {
+            glDeleteSync(pixelBufferFences_[i]);
+            pixelBufferFences_[i] = nullptr;
+        }
+    }
+    if (pixelBufferSize_ > 0) {
+        glDeleteBuffers(PBO_COUNT, pixelBuffers_);
+        for (int i = 0; i < PBO_COUNT; i++) {
+            pixelBuffers_[i] = 0;
+        }
+    }
+    pixelBufferSize_ = 0;
+    pixelBufferIndex_ = 0;
+}
 
-    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "EGLCore",
-                 "YUV textures updated successfully with linesize padding handled");
+void EGLCore::SetUploadMode(UploadMode mode) { requestedUploadMode_ = mode; }
 
-    return true;
+RenderStats EGLCore::GetRenderStats() const {
+    RenderStats stats;
+    stats.renderedFrames = renderedFrameCount_.load();
+    stats.renderFailures = renderFailureCount_.load();
+    stats.uploads = uploadCount_.load();
+    stats.fenceWaits = fenceWaitCount_.load();
+    stats.fenceTimeouts = fenceTimeoutCount_.load();
+    return stats;
 }
 
+// 错误由调用方在帧末统一检查
 void EGLCore::DrawQuad() {
     glBindVertexArray(VAO_);
-    if (!CheckGLError("glBindVertexArray"))
-        return;
-
     glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    if (!CheckGLError("glDrawElements"))
-        return;
-
     glBindVertexArray(0);
-    CheckGLError("glBindVertexArray(0)");
 }
 
 GLuint EGLCore::LoadShader(GLenum type, const char *shaderSrc) {
@@ -822,7 +970,7 @@ void EGLCore::UpdateSize(int width, int height) {
                          "Rendering test frame with padding after size update");
 
             // 确保EGL上下文是当前的
-            if (eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_)) {
+            if (MakeCurrent()) {
                 // 清除屏幕
                 glViewport(DEFAULT_X_POSITION, DEFAULT_Y_POSITION, width_, height_);
                 glClearColor(0.0f, 0.0f, 1.0f, 1.0f); // 蓝色背景
@@ -830,20 +978,8 @@ void EGLCore::UpdateSize(int width, int height) {
 
                 // 更新纹理并渲染
                 if (UpdateYUVTextures(testFrame)) {
-                    glUseProgram(program_);
-
                     // 绑定纹理
-                    glActiveTexture(GL_TEXTURE0);
-                    glBindTexture(GL_TEXTURE_2D, yTexture_);
-                    glUniform1i(yTextureLocation_, 0);
-
-                    glActiveTexture(GL_TEXTURE1);
-                    glBindTexture(GL_TEXTURE_2D, uTexture_);
-                    glUniform1i(uTextureLocation_, 1);
-
-                    glActiveTexture(GL_TEXTURE2);
-                    glBindTexture(GL_TEXTURE_2D, vTexture_);
-                    glUniform1i(vTextureLocation_, 2);
+                    BindYUVTextures();
 
                     // 绘制
                     glBindVertexArray(VAO_);
@@ -871,18 +1007,34 @@ void EGLCore::UpdateSize(int width, int height) {
     }
 }
 
+void EGLCore::SetStartupTrace(std::shared_ptr<StartupTrace> trace) {
+    std::lock_guard<std::mutex> lock(traceMutex_);
+    startupTrace_ = trace;
+    traceArmed_ = trace != nullptr && !trace->isComplete();
+}
+
 void EGLCore::Release() {
     // Cleanup textures and buffers
     if (texturesInitialized_) {
-        glDeleteTextures(1, &yTexture_);
-        glDeleteTextures(1, &uTexture_);
-        glDeleteTextures(1, &vTexture_);
+        ReleasePixelBuffers();
+        if (yTexture_ != 0) {
+            GLuint textures[] = {yTexture_, uTexture_, vTexture_};
+            glDeleteTextures(3, textures);
+            yTexture_ = uTexture_ = vTexture_ = 0;
+            textureWidth_ = textureHeight_ = 0;
+            textureFormat_ = AV_PIX_FMT_NONE;
+        }
         glDeleteVertexArrays(1, &VAO_);
         glDeleteBuffers(1, &VBO_);
         glDeleteBuffers(1, &EBO_);
         texturesInitialized_ = false;
     }
 
+    // 先从渲染线程解绑，上下文和surface才会被真正销毁
+    if (eglDisplay_ != nullptr) {
+        eglMakeCurrent(eglDisplay_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
     if ((eglDisplay_ == nullptr) || (eglSurface_ == nullptr) || (!eglDestroySurface(eglDisplay_, eglSurface_))) {
         OH_LOG_Print(LOG_APP, LOG_ERROR, LOG_PRINT_DOMAIN, "EGLCore", "Release eglDestroySurface failed");
     }
@@ -11,26 +11,56 @@
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
 #include <GLES3/gl3.h>
+#include <chrono>
 
 namespace VideoStreamNS {
+// 纹理上传方式
+enum class UploadMode {
+    Direct,      // glTexSubImage2D直接从帧内存同步上传
+    PixelBuffer, // 经PBO环形缓冲异步上传，CPU拷贝与上一帧的传输重叠
+};
+
+// 渲染统计
+struct RenderStats {
+    uint64_t renderedFrames = 0; // 成功上屏的帧数
+    uint64_t renderFailures = 0;
+    uint64_t queueDrops = 0; // 渲染线程跟不上、在队列中被新帧替换的帧数
+    uint64_t uploads = 0;
+    uint64_t fenceWaits = 0;    // 写入PBO前其fence尚未完成、需要等待的次数
+    uint64_t fenceTimeouts = 0; // 等待超时仍未完成、该帧改为直接上传的次数
+};
+
 class EGLCore {
 public:
     explicit EGLCore()
         : yTexture_(0), uTexture_(0), vTexture_(0), VAO_(0), VBO_(0), EBO_(0), texturesInitialized_(false), width_(0),
-          height_(0), firstFrameRendered_(false) {};
+          height_(0), textureWidth_(0), textureHeight_(0), firstFrameRendered_(false),
+          summaryTime_(std::chrono::steady_clock::now()) {};
     ~EGLCore() {}
     bool EglContextInit(void *window);
     bool CreateEnvironment();
     bool RenderYUVFrame(const VideoFrame &frame);
     void Release();
     void UpdateSize(int width, int height);
+    void SetStartupTrace(std::shared_ptr<StartupTrace> trace);
+    void SetUploadMode(UploadMode mode);
+    RenderStats GetRenderStats() const;
 
 private:
+    bool MakeCurrent();
     GLuint LoadShader(GLenum type, const char *shaderSrc);
     GLuint CreateProgram(const char *vertexShader, const char *fragShader);
     bool InitYUVTextures();
+    bool EnsureYUVTextures(int width, int height, int format);
+    void BindYUVTextures();
     bool UpdateYUVTextures(const VideoFrame &frame);
+    bool UploadPlanesDirect(const VideoFrame &frame);
+    bool UploadPlanesViaPixelBuffers(const VideoFrame &frame);
+    bool AllocatePixelBuffers(size_t size);
+    void ReleasePixelBuffers();
     void DrawQuad();
+    bool RenderFrame(const VideoFrame &frame);
+    void LogSummary();
 
 private:
     EGLNativeWindowType eglWindow_;
@@ -39,6 +69,7 @@ private:
     EGLSurface eglSurface_ = EGL_NO_SURFACE;
     EGLContext eglContext_ = EGL_NO_CONTEXT;
     GLuint program_;
+    GLuint semiPlanarProgram_ = 0; // NV12/NV21
     int width_;
     int height_;
 
@@ -52,8 +83,35 @@ private:
     GLint yTextureLocation_;
     GLint uTextureLocation_;
     GLint vTextureLocation_;
+    GLint semiPlanarYTextureLocation_ = -1;
+    GLint uvTextureLocation_ = -1;
+    GLint uvSwapLocation_ = -1;
     bool texturesInitialized_;
+    int textureWidth_; // 当前纹理存储对应的帧尺寸
+    int textureHeight_;
+    int textureFormat_ = AV_PIX_FMT_NONE; // 当前纹理内容的像素格式，决定平面布局和着色器
     bool firstFrameRendered_; // 标记是否已经渲染了第一帧
+
+    // PBO环形缓冲，每个PBO按平面顺序紧凑存放一帧
+    static const int PBO_COUNT = 3;
+    std::atomic<UploadMode> requestedUploadMode_{UploadMode::Direct};
+    UploadMode uploadMode_ = UploadMode::Direct;
+    GLuint pixelBuffers_[PBO_COUNT] = {0};
+    GLsync pixelBufferFences_[PBO_COUNT] = {nullptr};
+    size_t pixelBufferSize_ = 0;
+    int pixelBufferIndex_ = 0;
+    std::atomic<uint64_t> renderedFrameCount_{0};
+    std::atomic<uint64_t> renderFailureCount_{0};
+    std::atomic<uint64_t> uploadCount_{0};
+    std::chrono::steady_clock::time_point summaryTime_; // 上次输出汇总日志的时间，仅渲染线程访问
+    uint64_t summaryFrameCount_ = 0;
+    std::atomic<uint64_t> fenceWaitCount_{0};
+    std::atomic<uint64_t> fenceTimeoutCount_{0};
+
+    // 启动时间线，记录到首次上屏后不再访问
+    std::mutex traceMutex_;
+    std::shared_ptr<StartupTrace> startupTrace_;
+    std::atomic<bool> traceArmed_{false};
 };
 } // namespace VideoStreamNS
 
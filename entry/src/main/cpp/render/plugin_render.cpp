@@ -7,13 +7,89 @@
 #include "plugin_render.h"
 #include "../common/common.h"
 #include <cstdint>
+#include <future>
 #include <hilog/log.h>
 
 namespace VideoStreamNS {
-VideoRenderer::VideoRenderer(int64_t surfaceId) {
+namespace {
+// 待渲染帧队列长度，渲染跟不上时丢弃最旧的帧，始终显示最新画面
+const size_t FRAME_QUEUE_CAPACITY = 2;
+} // namespace
+
+VideoRenderer::VideoRenderer(int64_t surfaceId) : stopping_(false), queueDrops_(0) {
     this->surfaceId_ = surfaceId;
     this->eglCore_ = new EGLCore();
     isInitialized_ = false;
+    renderThread_ = std::thread(&VideoRenderer::RenderLoop, this);
+}
+
+VideoRenderer::~VideoRenderer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frames_.clear();
+        EGLCore *eglCore = eglCore_;
+        tasks_.push_back([eglCore]() { eglCore->Release(); });
+        stopping_ = true;
+    }
+    cond_.notify_one();
+    if (renderThread_.joinable()) {
+        renderThread_.join();
+    }
+    delete eglCore_;
+    eglCore_ = nullptr;
+}
+
+void VideoRenderer::RenderLoop() {
+    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "VideoRenderer", "Render thread started for surface %{public}lld",
+                 static_cast<long long>(surfaceId_));
+    while (true) {
+        std::function<void()> task;
+        VideoFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this]() { return stopping_ || !tasks_.empty() || !frames_.empty(); });
+            if (!tasks_.empty()) {
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            } else if (!frames_.empty()) {
+                frame = std::move(frames_.front());
+                frames_.pop_front();
+            } else {
+                break;
+            }
+        }
+
+        if (task) {
+            task();
+        } else if (isInitialized_) {
+            eglCore_->RenderYUVFrame(frame);
+        }
+    }
+    OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "VideoRenderer", "Render thread ended for surface %{public}lld",
+                 static_cast<long long>(surfaceId_));
+}
+
+bool VideoRenderer::PostTask(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return false;
+        }
+        tasks_.push_back(std::move(task));
+    }
+    cond_.notify_one();
+    return true;
+}
+
+void VideoRenderer::RunTask(std::function<void()> task) {
+    auto done = std::make_shared<std::promise<void>>();
+    std::future<void> future = done->get_future();
+    if (PostTask([task, done]() {
+            task();
+            done->set_value();
+        })) {
+        future.wait();
+    }
 }
 
 bool VideoRenderer::RenderYUVFrame(const VideoFrame &frame) {
@@ -22,11 +98,31 @@ bool VideoRenderer::RenderYUVFrame(const VideoFrame &frame) {
         return false;
     }
 
-    return eglCore_->RenderYUVFrame(frame);
+    // 队列中持有帧缓冲区的引用，调用方随即可以释放自己的帧
+    VideoFrame queued = frame.ref();
+    if (!queued.isValid()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return false;
+        }
+        if (frames_.size() >= FRAME_QUEUE_CAPACITY) {
+            frames_.pop_front();
+            queueDrops_++;
+        }
+        frames_.push_back(std::move(queued));
+    }
+    cond_.notify_one();
+    return true;
 }
 
 void VideoRenderer::InitNativeWindow(OHNativeWindow *window) {
-    if (eglCore_->EglContextInit(window)) {
+    // EGL上下文在渲染线程上创建并保持绑定；等待结果以便调用方随后查询IsInitialized
+    bool success = false;
+    RunTask([this, window, &success]() { success = eglCore_->EglContextInit(window); });
+    if (success) {
         isInitialized_ = true;
         OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "VideoRenderer", "InitNativeWindow success");
     } else {
@@ -36,11 +132,30 @@ void VideoRenderer::InitNativeWindow(OHNativeWindow *window) {
 
 void VideoRenderer::UpdateSize(int width, int height) {
     if (eglCore_ != nullptr) {
-        eglCore_->UpdateSize(width, height);
+        PostTask([this, width, height]() { eglCore_->UpdateSize(width, height); });
         OH_LOG_Print(LOG_APP, LOG_INFO, LOG_PRINT_DOMAIN, "VideoRenderer", "UpdateSize: %{public}dx%{public}d", width,
                      height);
     }
 }
 
+void VideoRenderer::SetStartupTrace(std::shared_ptr<StartupTrace> trace) {
+    if (eglCore_ != nullptr) {
+        eglCore_->SetStartupTrace(trace);
+    }
+}
+
+void VideoRenderer::SetUploadMode(UploadMode mode) {
+    if (eglCore_ != nullptr) {
+        eglCore_->SetUploadMode(mode);
+    }
+}
+
+RenderStats VideoRenderer::GetRenderStats() const {
+    RenderStats stats = eglCore_ != nullptr ? eglCore_->GetRenderStats() : RenderStats();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.queueDrops = queueDrops_;
+    return stats;
+}
+
 bool VideoRenderer::IsInitialized() const { return isInitialized_; }
 } // namespace VideoStreamNS
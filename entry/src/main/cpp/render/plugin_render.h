@@ -10,29 +10,45 @@
 #include "../video_stream_handler.h"
 #include "egl_core.h"
 #include <ace/xcomponent/native_interface_xcomponent.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <native_window/external_window.h>
+#include <thread>
 
 namespace VideoStreamNS {
+// 每个VideoRenderer拥有一个常驻渲染线程，EGL上下文只在该线程上创建、绑定和销毁。
+// RenderYUVFrame只把帧引用放入队列；初始化、尺寸变化和释放都投递到渲染线程执行。
 class VideoRenderer {
 public:
     explicit VideoRenderer(int64_t surfaceId);
-    ~VideoRenderer() {
-        if (eglCore_ != nullptr) {
-            eglCore_->Release();
-            delete eglCore_;
-            eglCore_ = nullptr;
-        }
-    }
+    ~VideoRenderer();
 
     bool RenderYUVFrame(const VideoFrame &frame);
     bool IsInitialized() const;
     void InitNativeWindow(OHNativeWindow *window);
     void UpdateSize(int width, int height);
+    void SetStartupTrace(std::shared_ptr<StartupTrace> trace);
+    void SetUploadMode(UploadMode mode);
+    RenderStats GetRenderStats() const;
 
 private:
+    void RenderLoop();
+    bool PostTask(std::function<void()> task);
+    void RunTask(std::function<void()> task); // 投递并等待执行完成
+
     EGLCore *eglCore_;
     int64_t surfaceId_;
-    bool isInitialized_;
+    std::atomic<bool> isInitialized_;
+
+    std::thread renderThread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<std::function<void()>> tasks_; // 优先于帧执行
+    std::deque<VideoFrame> frames_;
+    bool stopping_;
+    uint64_t queueDrops_; // 渲染跟不上时丢弃的旧帧数
 };
 } // namespace VideoStreamNS
 
@@ -0,0 +1,186 @@
+#include "snapshot.h"
+#include "color/yuv_to_rgb.h"
+#include "common/log.h"
+#include <algorithm>
+#include <memory>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "Snapshot"
+
+namespace {
+// MJPEG的量化参数，2-31，越小质量越高
+const int JPEG_QSCALE = 3;
+
+struct FrameDeleter {
+    void operator()(AVFrame *frame) const { av_frame_free(&frame); }
+};
+struct CodecContextDeleter {
+    void operator()(AVCodecContext *context) const { avcodec_free_context(&context); }
+};
+struct SwsDeleter {
+    void operator()(SwsContext *context) const { sws_freeContext(context); }
+};
+
+using FramePtr = std::unique_ptr<AVFrame, FrameDeleter>;
+
+bool IsJpegRangeI420(const VideoFrame &frame) {
+    const AVFrame *avFrame = frame.avFrame();
+    return avFrame && (frame.format == AV_PIX_FMT_YUVJ420P ||
+                       (frame.format == AV_PIX_FMT_YUV420P && avFrame->color_range == AVCOL_RANGE_JPEG));
+}
+
+FramePtr AllocImage(int width, int height, AVPixelFormat format) {
+    FramePtr image(av_frame_alloc());
+    if (!image) {
+        return nullptr;
+    }
+    image->width = width;
+    image->height = height;
+    image->format = format;
+    if (av_frame_get_buffer(image.get(), 0) < 0) {
+        return nullptr;
+    }
+    return image;
+}
+
+// 缩放和色彩转换一次完成，源帧的色彩矩阵和范围未知时按BT.601有限范围处理
+FramePtr ScaleImage(const VideoFrame &frame, int width, int height, AVPixelFormat format) {
+    FramePtr image = AllocImage(width, height, format);
+    if (!image) {
+        return nullptr;
+    }
+    std::unique_ptr<SwsContext, SwsDeleter> sws(sws_getContext(frame.width, frame.height,
+                                                                static_cast<AVPixelFormat>(frame.format), width,
+                                                                height, format, SWS_AREA, nullptr, nullptr, nullptr));
+    if (!sws) {
+        return nullptr;
+    }
+
+    const AVFrame *avFrame = frame.avFrame();
+    int srcSpace = avFrame && avFrame->colorspace == AVCOL_SPC_BT709 ? SWS_CS_ITU709 : SWS_CS_ITU601;
+    int srcFull = avFrame && avFrame->color_range == AVCOL_RANGE_JPEG ? 1 : 0;
+    int dstFull = format == AV_PIX_FMT_YUVJ420P ? 1 : 0;
+    // 不支持的转换保持swscale按像素格式推断的默认值
+    sws_setColorspaceDetails(sws.get(), sws_getCoefficients(srcSpace), srcFull, sws_getCoefficients(SWS_CS_ITU601),
+                             dstFull, 0, 1 << 16, 1 << 16);
+
+    const uint8_t *const srcData[4] = {frame.data[0], frame.data[1], frame.data[2], nullptr};
+    const int srcLinesize[4] = {frame.linesize[0], frame.linesize[1], frame.linesize[2], 0};
+    if (sws_scale(sws.get(), srcData, srcLinesize, 0, frame.height, image->data, image->linesize) != height) {
+        return nullptr;
+    }
+    return image;
+}
+
+// 原尺寸转换为RGB24，只在调用线程上执行，不占用解码共享的执行器
+FramePtr ConvertImage(const VideoFrame &frame) {
+    FramePtr image = AllocImage(frame.width, frame.height, AV_PIX_FMT_RGB24);
+    if (!image) {
+        return nullptr;
+    }
+    YuvPlanes planes = {{frame.data[0], frame.data[1], frame.data[2]},
+                        {frame.linesize[0], frame.linesize[1], frame.linesize[2]},
+                        frame.width,
+                        frame.height,
+                        frame.format};
+    YuvToRgbOptions options = YuvToRgbOptionsForFrame(frame.avFrame());
+    options.threads = 1;
+    if (!ConvertYuvToRgb(planes, image->data[0], image->linesize[0], RgbFormat::RGB24, options)) {
+        return nullptr;
+    }
+    return image;
+}
+
+bool EncodeImage(AVFrame *image, SnapshotFormat format, AVPacket *output, std::string &error) {
+    AVCodecID codecId = format == SnapshotFormat::Jpeg ? AV_CODEC_ID_MJPEG : AV_CODEC_ID_PNG;
+    const AVCodec *codec = avcodec_find_encoder(codecId);
+    if (!codec) {
+        error = std::string("Encoder not available: ") + avcodec_get_name(codecId);
+        return false;
+    }
+    std::unique_ptr<AVCodecContext, CodecContextDeleter> context(avcodec_alloc_context3(codec));
+    if (!context) {
+        error = "Failed to allocate encoder context";
+        return false;
+    }
+    context->width = image->width;
+    context->height = image->height;
+    context->pix_fmt = static_cast<AVPixelFormat>(image->format);
+    context->time_base = {1, 25};
+    context->thread_count = 1;
+    if (format == SnapshotFormat::Jpeg) {
+        context->color_range = AVCOL_RANGE_JPEG;
+        context->flags |= AV_CODEC_FLAG_QSCALE;
+        context->global_quality = FF_QP2LAMBDA * JPEG_QSCALE;
+        image->quality = context->global_quality;
+    }
+    if (avcodec_open2(context.get(), codec, nullptr) < 0) {
+        error = std::string("Failed to open encoder: ") + codec->name;
+        return false;
+    }
+
+    image->pts = 0;
+    image->pict_type = AV_PICTURE_TYPE_NONE;
+    if (avcodec_send_frame(context.get(), image) < 0 || avcodec_send_frame(context.get(), nullptr) < 0 ||
+        avcodec_receive_packet(context.get(), output) < 0) {
+        error = std::string("Failed to encode snapshot with ") + codec->name;
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+bool EncodeSnapshot(const VideoFrame &frame, const SnapshotOptions &options, AVPacket *output, std::string &error) {
+    if (!frame.isValid() || frame.width <= 0 || frame.height <= 0) {
+        error = "No decoded frame";
+        return false;
+    }
+
+    int width = frame.width;
+    int height = frame.height;
+    if (options.maxWidth > 0 && options.maxWidth < frame.width) {
+        width = options.maxWidth;
+        height = std::max(1, static_cast<int>((static_cast<int64_t>(frame.height) * width + frame.width / 2) /
+                                              frame.width));
+    }
+    bool scaled = width != frame.width || height != frame.height;
+
+    // 每条路径最多写一次像素：缩放（含转换）、原尺寸RGB转换，或直接引用解码缓冲区
+    FramePtr image;
+    if (options.format == SnapshotFormat::Jpeg) {
+        if (!scaled && IsJpegRangeI420(frame)) {
+            image.reset(av_frame_clone(frame.avFrame()));
+        } else {
+            image = ScaleImage(frame, width, height, AV_PIX_FMT_YUVJ420P);
+        }
+    } else {
+        if (!scaled) {
+            image = ConvertImage(frame);
+        }
+        // 需要缩小，或ConvertYuvToRgb不支持的像素格式，交给swscale
+        if (!image) {
+            image = ScaleImage(frame, width, height, AV_PIX_FMT_RGB24);
+        }
+    }
+    if (!image) {
+        error = "Failed to convert frame for snapshot";
+        return false;
+    }
+
+    if (!EncodeImage(image.get(), options.format, output, error)) {
+        OH_LOG_ERROR(LOG_APP, "%{public}s", error.c_str());
+        return false;
+    }
+    OH_LOG_INFO(LOG_APP, "Snapshot %{public}dx%{public}d -> %{public}dx%{public}d %{public}s, %{public}zu bytes",
+                frame.width, frame.height, width, height, options.format == SnapshotFormat::Jpeg ? "jpeg" : "png",
+                output->size);
+    return true;
+}
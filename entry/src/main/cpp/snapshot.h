@@ -0,0 +1,25 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "video_stream_handler.h"
+#include <cstdint>
+#include <string>
+
+// 截图的编码格式
+enum class SnapshotFormat {
+    Jpeg,
+    Png,
+};
+
+struct SnapshotOptions {
+    int maxWidth = 0; // 宽度超过时按比例缩小，0表示保持原尺寸
+    SnapshotFormat format = SnapshotFormat::Jpeg;
+};
+
+// 把一帧解码输出编码为JPEG或PNG，在调用线程上同步完成，应在后台线程调用。
+// 缩放和转换合并为一次写入目标图像：需要缩小时由swscale完成，原尺寸PNG用ConvertYuvToRgb，
+// 原尺寸且已是全范围I420的JPEG直接引用帧缓冲区编码，不复制像素。
+// 编码结果的引用移入调用方分配的output，不复制编码数据。失败时返回false并在error中给出原因
+bool EncodeSnapshot(const VideoFrame &frame, const SnapshotOptions &options, AVPacket *output, std::string &error);
+
+#endif // SNAPSHOT_H
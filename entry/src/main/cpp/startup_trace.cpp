@@ -0,0 +1,132 @@
+#include "startup_trace.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+const int PHASE_COUNT = static_cast<int>(StartupPhase::Count);
+const int64_t NOT_RECORDED = -1;
+
+const char *PHASE_NAMES[PHASE_COUNT] = {"threadSpawned",     "inputOpened",        "streamInfoFound",
+                                        "decoderOpened",     "firstPacket",        "firstKeyframe",
+                                        "firstDecodedFrame", "firstTextureUpload", "firstSwap"};
+} // namespace
+
+StartupTrace::StartupTrace() : startNs_(nowNs()) {
+    for (auto &phase : phaseNs_) {
+        phase = NOT_RECORDED;
+    }
+}
+
+int64_t StartupTrace::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void StartupTrace::reset() {
+    for (auto &phase : phaseNs_) {
+        phase = NOT_RECORDED;
+    }
+    startNs_ = nowNs();
+}
+
+void StartupTrace::mark(StartupPhase phase) {
+    auto &slot = phaseNs_[static_cast<int>(phase)];
+    if (slot.load(std::memory_order_relaxed) != NOT_RECORDED) {
+        return;
+    }
+    int64_t expected = NOT_RECORDED;
+    if (slot.compare_exchange_strong(expected, nowNs()) && phase == StartupPhase::FirstSwap) {
+        StartupHistogram::instance().record(*this);
+    }
+}
+
+double StartupTrace::elapsedMs(StartupPhase phase) const {
+    int64_t ns = phaseNs_[static_cast<int>(phase)].load();
+    if (ns == NOT_RECORDED) {
+        return -1;
+    }
+    return (ns - startNs_.load()) / 1e6;
+}
+
+bool StartupTrace::isComplete() const {
+    return phaseNs_[static_cast<int>(StartupPhase::FirstSwap)].load() != NOT_RECORDED;
+}
+
+const char *StartupTrace::phaseName(StartupPhase phase) {
+    int index = static_cast<int>(phase);
+    return index >= 0 && index < PHASE_COUNT ? PHASE_NAMES[index] : "unknown";
+}
+
+StartupHistogram &StartupHistogram::instance() {
+    static StartupHistogram histogram;
+    return histogram;
+}
+
+StartupHistogram::StartupHistogram() : phases_(PHASE_COUNT) {
+    for (auto &data : phases_) {
+        data.buckets.assign(bucketBoundsMs().size() + 1, 0);
+    }
+}
+
+const std::vector<double> &StartupHistogram::bucketBoundsMs() {
+    static const std::vector<double> bounds = {10, 25, 50, 100, 200, 300, 500, 750, 1000, 1500, 2000, 3000, 5000};
+    return bounds;
+}
+
+void StartupHistogram::record(const StartupTrace &trace) {
+    const auto &bounds = bucketBoundsMs();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        double ms = trace.elapsedMs(static_cast<StartupPhase>(i));
+        if (ms < 0) {
+            continue;
+        }
+        PhaseData &data = phases_[i];
+        data.minMs = data.count == 0 ? ms : std::min(data.minMs, ms);
+        data.maxMs = data.count == 0 ? ms : std::max(data.maxMs, ms);
+        data.count++;
+        data.sumMs += ms;
+
+        size_t bucket = 0;
+        while (bucket < bounds.size() && ms > bounds[bucket]) {
+            bucket++;
+        }
+        data.buckets[bucket]++;
+    }
+}
+
+double StartupHistogram::percentile(const PhaseData &data, double fraction) const {
+    // 以桶上界近似分位数，溢出桶使用最大值
+    const auto &bounds = bucketBoundsMs();
+    uint64_t target = static_cast<uint64_t>(fraction * data.count + 0.5);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < data.buckets.size(); i++) {
+        seen += data.buckets[i];
+        if (seen >= target && seen > 0) {
+            return i < bounds.size() ? std::min(bounds[i], data.maxMs) : data.maxMs;
+        }
+    }
+    return data.maxMs;
+}
+
+std::vector<StartupPhaseSummary> StartupHistogram::summarize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<StartupPhaseSummary> summaries;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        const PhaseData &data = phases_[i];
+        StartupPhaseSummary summary;
+        summary.phase = static_cast<StartupPhase>(i);
+        summary.count = data.count;
+        summary.buckets = data.buckets;
+        if (data.count > 0) {
+            summary.minMs = data.minMs;
+            summary.maxMs = data.maxMs;
+            summary.meanMs = data.sumMs / data.count;
+            summary.p50Ms = percentile(data, 0.5);
+            summary.p90Ms = percentile(data, 0.9);
+        }
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
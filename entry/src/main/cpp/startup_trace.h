@@ -0,0 +1,82 @@
+#ifndef STARTUP_TRACE_H
+#define STARTUP_TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 启动路径上的各个阶段，按发生顺序排列
+enum class StartupPhase {
+    ThreadSpawned = 0,  // 流线程开始运行
+    InputOpened,        // avformat_open_input完成
+    StreamInfoFound,    // avformat_find_stream_info完成（或被跳过）
+    DecoderOpened,      // avcodec_open2完成
+    FirstPacket,        // 收到第一个视频数据包
+    FirstKeyframe,      // 收到第一个关键帧数据包
+    FirstDecodedFrame,  // 解码出第一帧
+    FirstTextureUpload, // 第一帧上传到纹理
+    FirstSwap,          // 第一次eglSwapBuffers成功
+    Count
+};
+
+// 单次启动的时间线。
+// 每个阶段只记录第一次发生的单调时钟时间，起点为reset()；各线程可并发调用mark()。
+// FirstSwap记录后整条时间线会汇总到StartupHistogram。
+class StartupTrace {
+public:
+    StartupTrace();
+
+    void reset();
+    void mark(StartupPhase phase);
+
+    // 阶段相对起点的耗时，未发生时返回-1
+    double elapsedMs(StartupPhase phase) const;
+    bool isComplete() const;
+
+    static const char *phaseName(StartupPhase phase);
+    static int64_t nowNs();
+
+private:
+    std::atomic<int64_t> startNs_;
+    std::atomic<int64_t> phaseNs_[static_cast<int>(StartupPhase::Count)];
+};
+
+// 单个阶段在多次启动间的耗时分布
+struct StartupPhaseSummary {
+    StartupPhase phase;
+    uint64_t count = 0;
+    double minMs = 0;
+    double maxMs = 0;
+    double meanMs = 0;
+    double p50Ms = 0;
+    double p90Ms = 0;
+    std::vector<uint64_t> buckets; // 与bucketBoundsMs()一一对应，最后一个桶为溢出桶
+};
+
+// 进程内所有启动的耗时直方图
+class StartupHistogram {
+public:
+    static StartupHistogram &instance();
+
+    void record(const StartupTrace &trace);
+    std::vector<StartupPhaseSummary> summarize() const;
+    static const std::vector<double> &bucketBoundsMs();
+
+private:
+    struct PhaseData {
+        uint64_t count = 0;
+        double sumMs = 0;
+        double minMs = 0;
+        double maxMs = 0;
+        std::vector<uint64_t> buckets;
+    };
+
+    StartupHistogram();
+    double percentile(const PhaseData &data, double fraction) const;
+
+    mutable std::mutex mutex_;
+    std::vector<PhaseData> phases_;
+};
+
+#endif // STARTUP_TRACE_H
@@ -0,0 +1,117 @@
+#include "stream_executor.h"
+#include "common/log.h"
+#include <algorithm>
+
+#undef LOG_DOMAIN
+#undef LOG_TAG
+#define LOG_DOMAIN 0x3200
+#define LOG_TAG "StreamExecutor"
+
+namespace {
+// 工作线程数的下限，单核设备上也保留一个线程给其他流
+const size_t MIN_WORKERS = 2;
+
+// 当前线程所属的执行器和工作线程编号，外部线程为空
+thread_local const StreamExecutor *g_currentExecutor = nullptr;
+thread_local size_t g_currentWorker = 0;
+} // namespace
+
+StreamExecutor::StreamExecutor(size_t workerCount)
+    : pendingTasks_(0), nextWorker_(0), stopping_(false), executedTasks_(0), stolenTasks_(0) {
+    workerCount = std::max(workerCount, MIN_WORKERS);
+    for (size_t i = 0; i < workerCount; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < workerCount; i++) {
+        workers_[i]->thread = std::thread(&StreamExecutor::workerLoop, this, i);
+    }
+    OH_LOG_INFO(LOG_APP, "Stream executor started with %{public}zu workers", workerCount);
+}
+
+StreamExecutor::~StreamExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        stopping_ = true;
+    }
+    idleCond_.notify_all();
+    for (auto &worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+StreamExecutor &StreamExecutor::shared() {
+    static StreamExecutor executor(std::thread::hardware_concurrency());
+    return executor;
+}
+
+void StreamExecutor::submit(Task task, StreamPriority priority) {
+    size_t index = g_currentExecutor == this ? g_currentWorker : nextWorker_++ % workers_.size();
+    int level = static_cast<int>(priority);
+    // 先计数再入队，取走任务后的递减不会早于这里的递增
+    {
+        std::lock_guard<std::mutex> lock(idleMutex_);
+        pendingTasks_++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->queues[level].push_back(std::move(task));
+    }
+    idleCond_.notify_one();
+}
+
+bool StreamExecutor::takeTask(size_t index, Task &task) {
+    for (int level = PRIORITY_LEVELS - 1; level >= 0; level--) {
+        {
+            Worker &own = *workers_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.queues[level].empty()) {
+                task = std::move(own.queues[level].front());
+                own.queues[level].pop_front();
+                return true;
+            }
+        }
+        // 自己没有该优先级的任务时，从其他线程的队尾窃取
+        for (size_t offset = 1; offset < workers_.size(); offset++) {
+            Worker &victim = *workers_[(index + offset) % workers_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.queues[level].empty()) {
+                task = std::move(victim.queues[level].back());
+                victim.queues[level].pop_back();
+                stolenTasks_++;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void StreamExecutor::workerLoop(size_t index) {
+    g_currentExecutor = this;
+    g_currentWorker = index;
+    while (true) {
+        Task task;
+        if (takeTask(index, task)) {
+            pendingTasks_--;
+            task();
+            executedTasks_++;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        idleCond_.wait(lock, [this]() { return stopping_ || pendingTasks_ > 0; });
+        if (stopping_ && pendingTasks_ == 0) {
+            break;
+        }
+    }
+}
+
+StreamExecutorStats StreamExecutor::getStats() const {
+    StreamExecutorStats stats;
+    stats.workers = workers_.size();
+    stats.pendingTasks = pendingTasks_.load();
+    stats.executedTasks = executedTasks_.load();
+    stats.stolenTasks = stolenTasks_.load();
+    return stats;
+}
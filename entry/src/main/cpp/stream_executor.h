@@ -0,0 +1,70 @@
+#ifndef STREAM_EXECUTOR_H
+#define STREAM_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 流的调度优先级，数值越大越先获得解码时间
+enum class StreamPriority {
+    Low = 0,    // 不可见或后台
+    Normal = 1, // 可见
+    High = 2,   // 获得焦点或全屏
+};
+
+// 执行器统计
+struct StreamExecutorStats {
+    size_t workers = 0;
+    size_t pendingTasks = 0;
+    uint64_t executedTasks = 0;
+    uint64_t stolenTasks = 0; // 从其他工作线程队列中取走的任务数
+};
+
+// 多路流共享的解码执行器。
+// 固定数量的工作线程（按CPU核数），每个线程按优先级各有一个任务队列：工作线程提交的任务进入自己的队列，
+// 外部线程提交的任务轮流分配。取任务时按优先级从高到低，先取自己队列的队首，没有再从其他线程队列的队尾窃取，
+// 因此高优先级的任务在任何队列中都先于低优先级的任务执行。
+// 任务应当是短小的片段（如一次解码若干个数据包），需要继续时重新提交，以便不同流之间交替执行。
+class StreamExecutor {
+public:
+    using Task = std::function<void()>;
+
+    explicit StreamExecutor(size_t workerCount);
+    ~StreamExecutor();
+
+    // 进程内共享的实例，首次使用时创建
+    static StreamExecutor &shared();
+
+    void submit(Task task, StreamPriority priority);
+
+    StreamExecutorStats getStats() const;
+
+private:
+    static const int PRIORITY_LEVELS = 3;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> queues[PRIORITY_LEVELS];
+        std::thread thread;
+    };
+
+    void workerLoop(size_t index);
+    bool takeTask(size_t index, Task &task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex idleMutex_;
+    std::condition_variable idleCond_;
+    std::atomic<size_t> pendingTasks_;
+    std::atomic<size_t> nextWorker_;
+    std::atomic<bool> stopping_;
+    std::atomic<uint64_t> executedTasks_;
+    std::atomic<uint64_t> stolenTasks_;
+};
+
+#endif // STREAM_EXECUTOR_H
@@ -0,0 +1,390 @@
+// 软件解码后端的主机端测试。
+// 用MPEG-4编码器生成一段每帧亮度不同的片段，分别检查：
+//   1. SoftwareDecoderBackend的打开、解码和transfer（内存帧原样保留）
+//   2. 注入的后端中途出错时VideoStreamHandler回退软件解码，从下一个关键帧继续
+//   3. 以Software模式通过VideoStreamHandler完整播放片段文件
+// 任一检查失败时返回非零，由ctest运行。
+
+#include "common/log.h"
+#include "decoder_backend.h"
+#include "frame_pool.h"
+#include "video_stream_handler.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+namespace {
+const int CLIP_WIDTH = 320;
+const int CLIP_HEIGHT = 240;
+const int CLIP_FRAMES = 48;
+const int CLIP_GOP = 12;
+const int CLIP_FPS = 25;
+
+// 解码后亮度均值与编码前的允许偏差，MPEG-4在纯色画面上的误差远小于该值
+const double LUMA_TOLERANCE = 3.0;
+
+// 播放整段片段的时间上限
+const auto PLAYBACK_TIMEOUT = std::chrono::seconds(20);
+
+int g_failures = 0;
+
+#define CHECK(condition)                                                                                           \
+    do {                                                                                                           \
+        if (!(condition)) {                                                                                        \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);                          \
+            g_failures++;                                                                                          \
+        }                                                                                                          \
+    } while (0)
+
+// 第index帧的亮度，逐帧递增以便检查帧序和内容
+int ExpectedLuma(int index) { return 32 + index * 4; }
+
+double MeanLuma(const uint8_t *data, int linesize, int width, int height) {
+    int64_t sum = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            sum += data[y * linesize + x];
+        }
+    }
+    return static_cast<double>(sum) / (static_cast<int64_t>(width) * height);
+}
+
+struct Clip {
+    AVCodecParameters *parameters = nullptr;
+    AVRational timeBase{1, CLIP_FPS};
+    std::vector<AVPacket *> packets;
+
+    ~Clip() {
+        for (AVPacket *packet : packets) {
+            av_packet_free(&packet);
+        }
+        avcodec_parameters_free(&parameters);
+    }
+};
+
+bool GenerateClip(Clip &clip) {
+    const AVCodec *encoder = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+    if (!encoder) {
+        fprintf(stderr, "MPEG-4 encoder not available\n");
+        return false;
+    }
+    AVCodecContext *context = avcodec_alloc_context3(encoder);
+    context->width = CLIP_WIDTH;
+    context->height = CLIP_HEIGHT;
+    context->pix_fmt = AV_PIX_FMT_YUV420P;
+    context->time_base = clip.timeBase;
+    context->framerate = {CLIP_FPS, 1};
+    context->gop_size = CLIP_GOP;
+    context->max_b_frames = 0;
+    context->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    if (avcodec_open2(context, encoder, nullptr) < 0) {
+        avcodec_free_context(&context);
+        return false;
+    }
+
+    AVFrame *frame = av_frame_alloc();
+    frame->width = CLIP_WIDTH;
+    frame->height = CLIP_HEIGHT;
+    frame->format = AV_PIX_FMT_YUV420P;
+    av_frame_get_buffer(frame, 0);
+    AVPacket *packet = av_packet_alloc();
+    for (int i = 0; i <= CLIP_FRAMES; i++) {
+        int ret;
+        if (i < CLIP_FRAMES) {
+            av_frame_make_writable(frame);
+            for (int y = 0; y < CLIP_HEIGHT; y++) {
+                memset(frame->data[0] + y * frame->linesize[0], ExpectedLuma(i), CLIP_WIDTH);
+            }
+            for (int plane = 1; plane < 3; plane++) {
+                for (int y = 0; y < CLIP_HEIGHT / 2; y++) {
+                    memset(frame->data[plane] + y * frame->linesize[plane], 128, CLIP_WIDTH / 2);
+                }
+            }
+            frame->pts = i;
+            ret = avcodec_send_frame(context, frame);
+        } else {
+            ret = avcodec_send_frame(context, nullptr);
+        }
+        while (ret >= 0 && avcodec_receive_packet(context, packet) >= 0) {
+            clip.packets.push_back(av_packet_clone(packet));
+            av_packet_unref(packet);
+        }
+    }
+    clip.parameters = avcodec_parameters_alloc();
+    avcodec_parameters_from_context(clip.parameters, context);
+
+    av_packet_free(&packet);
+    av_frame_free(&frame);
+    avcodec_free_context(&context);
+    return static_cast<int>(clip.packets.size()) == CLIP_FRAMES;
+}
+
+// 把片段写入Matroska文件，供VideoStreamHandler读取
+bool WriteClipFile(const Clip &clip, const std::string &path) {
+    AVFormatContext *output = nullptr;
+    if (avformat_alloc_output_context2(&output, nullptr, "matroska", path.c_str()) < 0) {
+        return false;
+    }
+    AVStream *stream = avformat_new_stream(output, nullptr);
+    bool ok = stream && avcodec_parameters_copy(stream->codecpar, clip.parameters) >= 0;
+    if (ok) {
+        stream->time_base = clip.timeBase;
+        ok = avio_open(&output->pb, path.c_str(), AVIO_FLAG_WRITE) >= 0 && avformat_write_header(output, nullptr) >= 0;
+    }
+    for (size_t i = 0; ok && i < clip.packets.size(); i++) {
+        AVPacket *packet = av_packet_clone(clip.packets[i]);
+        av_packet_rescale_ts(packet, clip.timeBase, stream->time_base);
+        packet->stream_index = 0;
+        ok = av_interleaved_write_frame(output, packet) >= 0;
+        av_packet_free(&packet);
+    }
+    if (ok) {
+        ok = av_write_trailer(output) >= 0;
+    }
+    if (output->pb) {
+        avio_closep(&output->pb);
+    }
+    avformat_free_context(output);
+    return ok;
+}
+
+// 与VideoStreamHandler::openDecoder相同的顺序：缓冲池、后端配置、打开解码器
+AVCodecContext *OpenDecoder(const Clip &clip, FramePool *pool, DecoderBackend &backend) {
+    const AVCodec *codec = avcodec_find_decoder(clip.parameters->codec_id);
+    AVCodecContext *context = codec ? avcodec_alloc_context3(codec) : nullptr;
+    if (!context) {
+        return nullptr;
+    }
+    if (avcodec_parameters_to_context(context, clip.parameters) < 0) {
+        avcodec_free_context(&context);
+        return nullptr;
+    }
+    context->pkt_timebase = clip.timeBase;
+    pool->attach(context);
+    if (!backend.configure(context) || avcodec_open2(context, codec, nullptr) < 0) {
+        avcodec_free_context(&context);
+        return nullptr;
+    }
+    return context;
+}
+
+// 模拟硬件后端在第failAfter帧之后下载失败
+class FailingBackend : public DecoderBackend {
+public:
+    explicit FailingBackend(int failAfter) : remaining_(failAfter) {}
+    const char *name() const override { return "failing"; }
+    bool isHardware() const override { return true; }
+    bool configure(AVCodecContext *) override { return true; }
+    int transfer(AVFrame *) override { return remaining_-- > 0 ? 0 : AVERROR(EIO); }
+
+private:
+    int remaining_;
+};
+
+struct DecodeResult {
+    std::vector<int64_t> pts;
+    int lumaMismatches = 0;
+    bool backendFailed = false;
+};
+
+// 送入全部数据包并冲刷解码器，后端出错时停止
+void Decode(const Clip &clip, AVCodecContext *context, DecoderBackend &backend, DecodeResult &result) {
+    AVFrame *frame = av_frame_alloc();
+    for (size_t i = 0; i <= clip.packets.size() && !result.backendFailed; i++) {
+        avcodec_send_packet(context, i < clip.packets.size() ? clip.packets[i] : nullptr);
+        while (avcodec_receive_frame(context, frame) >= 0) {
+            const uint8_t *before = frame->data[0];
+            if (backend.transfer(frame) < 0) {
+                av_frame_unref(frame);
+                result.backendFailed = true;
+                break;
+            }
+            if (!backend.isHardware()) {
+                // 软件后端不做下载，帧原样保留
+                CHECK(frame->data[0] == before);
+                CHECK(frame->format == AV_PIX_FMT_YUV420P);
+            }
+            int index = static_cast<int>(frame->pts);
+            double luma = MeanLuma(frame->data[0], frame->linesize[0], frame->width, frame->height);
+            if (std::fabs(luma - ExpectedLuma(index)) > LUMA_TOLERANCE) {
+                result.lumaMismatches++;
+            }
+            result.pts.push_back(frame->pts);
+            av_frame_unref(frame);
+        }
+    }
+    av_frame_free(&frame);
+}
+
+void TestSoftwareBackend(const Clip &clip) {
+    std::unique_ptr<DecoderBackend> backend =
+        CreateDecoderBackend(DecoderBackendMode::Software, avcodec_find_decoder(clip.parameters->codec_id));
+    CHECK(backend != nullptr);
+    CHECK(std::string(backend->name()) == "software");
+    CHECK(!backend->isHardware());
+
+    FramePool *pool = FramePool::create();
+    AVCodecContext *context = OpenDecoder(clip, pool, *backend);
+    CHECK(context != nullptr);
+    if (context) {
+        DecodeResult result;
+        Decode(clip, context, *backend, result);
+        CHECK(!result.backendFailed);
+        CHECK(static_cast<int>(result.pts.size()) == CLIP_FRAMES);
+        CHECK(result.lumaMismatches == 0);
+        for (size_t i = 0; i < result.pts.size(); i++) {
+            CHECK(result.pts[i] == static_cast<int64_t>(i));
+        }
+        avcodec_free_context(&context);
+    }
+    // 解码输出经缓冲池分配
+    FramePoolStats stats = pool->getStats();
+    CHECK(stats.hits + stats.misses > 0);
+    CHECK(stats.outstandingBuffers == 0);
+    pool->release();
+
+    // 没有可用的解码器信息时Auto也返回软件后端
+    std::unique_ptr<DecoderBackend> fallback = CreateDecoderBackend(DecoderBackendMode::Auto, nullptr);
+    CHECK(fallback && !fallback->isHardware());
+}
+
+// 通过startStream注入会出错的后端，走VideoStreamHandler自身的回退路径：
+// backendError_ -> reopenSoftwareDecoder -> beginKeyframeWait
+void TestFallback(const std::string &path) {
+    const int failAfter = CLIP_GOP + 3;
+    VideoStreamHandler handler;
+    std::vector<int> indices; // 只在渲染线程写入，stopStream之后读取
+    std::atomic<int> mismatches(0);
+    handler.addFrameSubscriber(0, [&](const VideoFrame &frame) {
+        double luma = MeanLuma(frame.data[0], frame.linesize[0], frame.width, frame.height);
+        int index = static_cast<int>(std::lround((luma - ExpectedLuma(0)) / (ExpectedLuma(1) - ExpectedLuma(0))));
+        if (std::fabs(luma - ExpectedLuma(index)) > LUMA_TOLERANCE) {
+            mismatches++;
+        }
+        indices.push_back(index);
+    });
+
+    // 单线程解码，出错时解码器内没有积压的后续帧，回退后从下一个GOP的关键帧继续
+    StreamOptions options;
+    options.decoderBackendFactory = [failAfter](const AVCodec *) {
+        return std::unique_ptr<DecoderBackend>(new FailingBackend(failAfter));
+    };
+    options.decodeThreadCount = 1;
+    options.targetLatencyMs = 0;
+    options.autoReconnect = false;
+    CHECK(handler.startStream(path, options));
+
+    auto deadline = std::chrono::steady_clock::now() + PLAYBACK_TIMEOUT;
+    while (handler.isActive() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(!handler.isActive());
+    handler.stopStream();
+
+    DecoderInfo info = handler.getDecoderInfo();
+    CHECK(info.hardwareFallbacks == 1);
+    CHECK(info.backend == "software");
+
+    // 起播一次、回退一次等待关键帧；出错帧之后到下一个关键帧之前的数据包被丢弃
+    KeyframeSyncStats sync = handler.getKeyframeSyncStats();
+    CHECK(sync.resyncs == 2);
+    CHECK(sync.discardedPackets == static_cast<uint64_t>(2 * CLIP_GOP - failAfter - 1));
+    CHECK(!sync.awaitingKeyframe);
+
+    // 出错前的帧和关键帧之后的帧都送达（呈现调度丢弃的迟到帧除外），中间的帧一帧也不出现
+    int expected = failAfter + CLIP_FRAMES - 2 * CLIP_GOP;
+    CHECK(static_cast<int>(indices.size()) + static_cast<int>(handler.getPresentationStats().droppedLate) == expected);
+    CHECK(mismatches.load() == 0);
+    bool resumed = false;
+    for (size_t i = 0; i < indices.size(); i++) {
+        CHECK(indices[i] < failAfter || indices[i] >= 2 * CLIP_GOP);
+        CHECK(i == 0 || indices[i] > indices[i - 1]);
+        resumed = resumed || indices[i] >= 2 * CLIP_GOP;
+    }
+    CHECK(resumed);
+}
+
+void TestHandlerPlayback(const std::string &path) {
+    VideoStreamHandler handler;
+    std::atomic<int> frames(0);
+    std::atomic<int> mismatches(0);
+    int lastIndex = -1;
+    // 呈现调度可能丢弃迟到帧，按亮度反推帧序号，检查内容正确且顺序递增
+    handler.addFrameSubscriber(0, [&](const VideoFrame &frame) {
+        double luma = MeanLuma(frame.data[0], frame.linesize[0], frame.width, frame.height);
+        int index = static_cast<int>(std::lround((luma - ExpectedLuma(0)) / (ExpectedLuma(1) - ExpectedLuma(0))));
+        if (std::fabs(luma - ExpectedLuma(index)) > LUMA_TOLERANCE || index <= lastIndex) {
+            mismatches++;
+        }
+        lastIndex = index;
+        frames++;
+    });
+
+    // 按pts呈现：帧队列满时反压解码，除呈现调度判定的迟到帧外不应丢帧
+    StreamOptions options;
+    options.decoderBackend = DecoderBackendMode::Software;
+    options.targetLatencyMs = 0;
+    options.autoReconnect = false;
+    CHECK(handler.startStream(path, options));
+
+    auto deadline = std::chrono::steady_clock::now() + PLAYBACK_TIMEOUT;
+    while (handler.isActive() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    CHECK(!handler.isActive());
+    handler.stopStream();
+
+    CHECK(frames.load() + static_cast<int>(handler.getPresentationStats().droppedLate) == CLIP_FRAMES);
+    CHECK(handler.getPipelineStats().droppedFrames == 0);
+    CHECK(mismatches.load() == 0);
+    DecoderInfo info = handler.getDecoderInfo();
+    CHECK(info.backend == "software");
+    CHECK(info.hardwareFallbacks == 0);
+}
+} // namespace
+
+int main() {
+    HostLogSetLevel(LOG_WARN);
+
+    Clip clip;
+    if (!GenerateClip(clip)) {
+        fprintf(stderr, "Failed to generate test clip\n");
+        return 1;
+    }
+    char path[] = "/tmp/decoder_backend_test_XXXXXX.mkv";
+    int fd = mkstemps(path, 4);
+    if (fd < 0) {
+        perror("mkstemps");
+        return 1;
+    }
+    close(fd);
+    if (!WriteClipFile(clip, path)) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        unlink(path);
+        return 1;
+    }
+
+    TestSoftwareBackend(clip);
+    TestFallback(path);
+    TestHandlerPlayback(path);
+    unlink(path);
+
+    if (g_failures > 0) {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("decoder_backend_test: all checks passed\n");
+    return 0;
+}
@@ -1,11 +1,21 @@
 export interface VideoStreamResult {
   success: boolean;
   url: string;
+  shared: boolean;
+  adoptedSurfaces?: bigint[];
 }
 
 export interface StreamStatus {
   isStreaming: boolean;
   info: string;
+  decoder?: string;
+  decodeThreadMode?: 'frame' | 'slice' | 'none';
+  decodeThreadCount?: number;
+  decoderBackend?: string;
+  hardwareFallbacks?: number;
+  subscribers?: number;
+  reconnecting?: boolean;
+  lastStopLatencyMs?: number;
 }
 
 export interface ActiveStream {
@@ -20,9 +30,120 @@ export interface VideoFrame {
   data: ArrayBuffer;
 }
 
+export interface StreamOptions {
+  packetQueueDepth?: number;
+  frameQueueDepth?: number;
+  decodeThreadMode?: 'auto' | 'frame' | 'slice';
+  decodeThreadCount?: number;
+  decodeCpus?: number[];
+  decoderBackend?: 'auto' | 'software';
+  sharedDecoder?: boolean;
+  priority?: StreamPriority;
+  hiddenDecodeMode?: 'keyframes' | 'suspend';
+  thumbnailFps?: number;
+  lowLatency?: boolean;
+  framePacing?: boolean;
+  keyframeResync?: boolean;
+  targetLatencyMs?: number;
+  autoReconnect?: boolean;
+  reconnectInitialDelayMs?: number;
+  reconnectMaxDelayMs?: number;
+  reconnectJitter?: number;
+  maxReconnectAttempts?: number;
+}
+
 export interface FrameStats {
   frameCount: number;
   frameRate: number;
+  packetQueueSize: number;
+  packetQueueCapacity: number;
+  frameQueueSize: number;
+  frameQueueCapacity: number;
+  droppedFrames: number;
+  poolHits: number;
+  poolMisses: number;
+  pooledBuffers: number;
+  outstandingBuffers: number;
+  timeToFirstFrameMs: number;
+  receiveToRenderMs: number;
+  glassToGlassMs: number;
+  probeSkipped: boolean;
+  targetLatencyMs: number;
+  effectiveLatencyMs: number;
+  playbackRate: number;
+  catchUpLevel: 'none' | 'speedUp' | 'skipNonRef' | 'skipToKeyframe';
+  keyframeSkips: number;
+  skippedPackets: number;
+  flushedFrames: number;
+  framesDisplayed: number;
+  framesDroppedLate: number;
+  framesRepeated: number;
+  reconnects: number;
+  failedReconnectAttempts: number;
+  decoderReopens: number;
+  lastRecoveryMs: number;
+  visibility: SurfaceVisibility;
+  suspendedPackets: number;
+  throttledFrames: number;
+  keyframeResyncs: number;
+  keyframeDiscardedPackets: number;
+  corruptFrames: number;
+  timeToKeyframeMs: number;
+  awaitingKeyframe: boolean;
+}
+
+export interface StartupTrace {
+  threadSpawned: number;
+  inputOpened: number;
+  streamInfoFound: number;
+  decoderOpened: number;
+  firstPacket: number;
+  firstKeyframe: number;
+  firstDecodedFrame: number;
+  firstTextureUpload: number;
+  firstSwap: number;
+}
+
+export interface StartupHistogramBucket {
+  le: number;
+  count: number;
+}
+
+export interface StartupPhaseSummary {
+  phase: string;
+  count: number;
+  minMs: number;
+  maxMs: number;
+  meanMs: number;
+  p50Ms: number;
+  p90Ms: number;
+  buckets: StartupHistogramBucket[];
+}
+
+export type UploadMode = 'direct' | 'pbo';
+
+export type FrameLogLevel = 'off' | 'debug' | 'info';
+
+export type StreamPriority = 'low' | 'normal' | 'high';
+
+export type SurfaceVisibility = 'visible' | 'thumbnail' | 'hidden';
+
+export type SnapshotFormat = 'jpeg' | 'png';
+
+export interface ExecutorStats {
+  workers: number;
+  pendingTasks: number;
+  executedTasks: number;
+  stolenTasks: number;
+}
+
+export interface RenderStats {
+  renderedFrames: number;
+  renderFailures: number;
+  queueDrops: number;
+  uploads: number;
+  fenceWaits: number;
+  fenceTimeouts: number;
 }
 
 type XComponentContextStatus = {
@@ -30,11 +151,20 @@ type XComponentContextStatus = {
   hasChangeColor: boolean,
 };
 
-export const startVideoStream: (url: string, surfaceId: bigint) => VideoStreamResult;
-export const stopVideoStream: (url: string) => boolean;
+export const startVideoStream: (url: string, surfaceId: bigint, options?: StreamOptions) => VideoStreamResult;
+export const stopVideoStream: (url: string, surfaceId?: bigint) => boolean;
 export const getStreamStatus: (url: string) => StreamStatus;
 export const getFrameStats: (url: string) => FrameStats;
+export const getStartupTrace: (url: string) => StartupTrace;
+export const getStartupHistogram: () => StartupPhaseSummary[];
 export const updateVideoSurfaceSize: (surfaceId: bigint, width: number, height: number) => boolean;
+export const setUploadMode: (surfaceId: bigint, mode: UploadMode) => boolean;
+export const getRenderStats: (surfaceId: bigint) => RenderStats;
+export const setFrameLogLevel: (level: FrameLogLevel) => boolean;
+export const setStreamPriority: (url: string, priority: StreamPriority) => boolean;
+export const setSurfaceVisibility: (surfaceId: bigint, visibility: SurfaceVisibility) => boolean;
+export const getExecutorStats: () => ExecutorStats;
+export const captureSnapshot: (url: string, maxWidth?: number, format?: SnapshotFormat) => Promise<ArrayBuffer>;
 
 export const setSurfaceId: (id: bigint) => any;
 export const changeSurface: (id: bigint, w: number, h: number) => any;
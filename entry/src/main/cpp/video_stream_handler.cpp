@@ -1,24 +1,245 @@
 #include "video_stream_handler.h"
-#include "hilog/log.h"
+#include "common/frame_log.h"
+#include "common/log.h"
+#include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <random>
+#include <sched.h>
 #include <thread>
 
+extern "C" {
+#include <libavutil/time.h>
+}
+
 #undef LOG_DOMAIN
 #undef LOG_TAG
 #define LOG_DOMAIN 0x3200
 #define LOG_TAG "VideoStreamHandler"
 
+namespace {
+// 队列空/满时的轮询间隔
+const auto QUEUE_POLL_INTERVAL = std::chrono::milliseconds(1);
+
+// 低延迟模式下的探测上限
+const char *LOW_LATENCY_PROBE_SIZE = "32768";
+const char *LOW_LATENCY_ANALYZE_DURATION = "100000"; // 100ms
+
+// 延迟平滑系数
+const double LATENCY_SMOOTHING = 0.1;
+
+// 渲染线程输出汇总日志的间隔，取代逐帧日志
+const auto LOG_SUMMARY_INTERVAL = std::chrono::seconds(5);
+
+// 等待呈现时间时单次休眠的上限，保证停止请求能及时响应
+const int64_t PRESENT_MAX_SLEEP_US = 5000;
+
+// targetLatencyMs为-1时实时协议采用的目标延迟
+const int DEFAULT_LIVE_TARGET_LATENCY_MS = 1000;
+const int LOW_LATENCY_TARGET_LATENCY_MS = 300;
+
+// 视为实时流的协议前缀
+const char *LIVE_PROTOCOLS[] = {"rtsp://", "rtsps://", "rtmp://", "rtmps://", "rtp://", "udp://", "srt://"};
+
+// 读取暂时没有数据（EAGAIN）时的重试间隔
+const auto READ_RETRY_INTERVAL = std::chrono::milliseconds(10);
+
+// 重连等待期间检查停止请求的间隔
+const auto RECONNECT_POLL_INTERVAL = std::chrono::milliseconds(10);
+
+// 阻塞I/O的时限，超时后由interrupt_callback打断；停止请求则立即打断
+const int64_t OPEN_TIMEOUT_US = 5000000;   // 建立连接、读取头部
+const int64_t PROBE_TIMEOUT_US = 10000000; // find_stream_info，实时流按实际速率到达，需要覆盖analyzeduration
+const int64_t READ_TIMEOUT_US = 5000000;   // 单次av_read_frame，超时视为连接断开
+
+// RTSP套接字读写超时（微秒），作为interrupt_callback之外的兜底
+const char *RTSP_SOCKET_TIMEOUT = "5000000";
+
+// 共享解码时每个片段最多处理的数据包数，片段之间让出工作线程给其他流
+const int DECODE_SLICE_PACKETS = 4;
+
+// 重连后通知解码线程冲刷解码器的哨兵包，以不存在的流索引标记
+const int FLUSH_PACKET_STREAM_INDEX = -1;
+
+// 流是否已经由SDP等头部信息给出了解码所需的参数
+bool HasDecoderParameters(const AVFormatContext *formatContext) {
+    for (unsigned int i = 0; i < formatContext->nb_streams; i++) {
+        const AVCodecParameters *codecpar = formatContext->streams[i]->codecpar;
+        if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO && codecpar->codec_id != AV_CODEC_ID_NONE &&
+            (codecpar->extradata_size > 0 || (codecpar->width > 0 && codecpar->height > 0))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 第attempt次重连前的等待：从初始值按2倍递增到上限，再叠加随机抖动
+int64_t ReconnectDelayMs(const StreamOptions &options, int attempt) {
+    double delayMs = std::max(options.reconnectInitialDelayMs, 0);
+    for (int i = 1; i < attempt && delayMs < options.reconnectMaxDelayMs; i++) {
+        delayMs *= 2;
+    }
+    delayMs = std::min(delayMs, static_cast<double>(options.reconnectMaxDelayMs));
+    if (options.reconnectJitter > 0) {
+        static thread_local std::mt19937 generator(std::random_device{}());
+        std::uniform_real_distribution<double> jitter(-options.reconnectJitter, options.reconnectJitter);
+        delayMs *= 1.0 + jitter(generator);
+    }
+    return std::max<int64_t>(0, static_cast<int64_t>(delayMs));
+}
+
+// 两份编码参数的扩展数据是否一致，任一方未知时不作比较
+bool SameExtradata(const AVCodecParameters *a, const AVCodecParameters *b) {
+    if (a->extradata_size <= 0 || b->extradata_size <= 0) {
+        return true;
+    }
+    return a->extradata_size == b->extradata_size && memcmp(a->extradata, b->extradata, a->extradata_size) == 0;
+}
+
+double Smooth(double previous, double sample) {
+    return previous < 0 ? sample : previous + (sample - previous) * LATENCY_SMOOTHING;
+}
+
+// 将调用线程绑定到指定CPU，previous非空时返回原来的亲和性
+bool SetThreadAffinity(const std::vector<int> &cpus, cpu_set_t *previous) {
+    if (cpus.empty()) {
+        return false;
+    }
+    if (previous && sched_getaffinity(0, sizeof(cpu_set_t), previous) != 0) {
+        return false;
+    }
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &cpuSet);
+        }
+    }
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &cpuSet) != 0) {
+        OH_LOG_WARN(LOG_APP, "sched_setaffinity failed, decode threads are not pinned");
+        return false;
+    }
+    return true;
+}
+
+const char *PixelFormatName(int format) {
+    const char *name = av_get_pix_fmt_name(static_cast<AVPixelFormat>(format));
+    return name ? name : "unknown";
+}
+
+const char *ThreadTypeName(int threadType) {
+    if (threadType & FF_THREAD_FRAME) {
+        return "frame";
+    }
+    if (threadType & FF_THREAD_SLICE) {
+        return "slice";
+    }
+    return "none";
+}
+} // namespace
+
+VideoFrame::VideoFrame() : data{nullptr, nullptr, nullptr}, linesize{0, 0, 0}, width(0), height(0), pts(0),
+                           format(AV_PIX_FMT_YUV420P), avFrame_(nullptr) {}
+
+VideoFrame::~VideoFrame() { reset(); }
+
+VideoFrame::VideoFrame(VideoFrame &&other) noexcept : VideoFrame() { *this = std::move(other); }
+
+VideoFrame &VideoFrame::operator=(VideoFrame &&other) noexcept {
+    if (this != &other) {
+        reset();
+        for (int i = 0; i < 3; i++) {
+            data[i] = other.data[i];
+            linesize[i] = other.linesize[i];
+            other.data[i] = nullptr;
+            other.linesize[i] = 0;
+        }
+        width = other.width;
+        height = other.height;
+        pts = other.pts;
+        format = other.format;
+        avFrame_ = other.avFrame_;
+        other.avFrame_ = nullptr;
+    }
+    return *this;
+}
+
+VideoFrame VideoFrame::fromAVFrame(const AVFrame *src) {
+    VideoFrame videoFrame;
+    if (!src) {
+        return videoFrame;
+    }
+
+    AVFrame *ref = av_frame_alloc();
+    if (!ref || av_frame_ref(ref, src) < 0) {
+        av_frame_free(&ref);
+        return videoFrame;
+    }
+
+    videoFrame.avFrame_ = ref;
+    for (int i = 0; i < 3; i++) {
+        videoFrame.data[i] = ref->data[i];
+        videoFrame.linesize[i] = ref->linesize[i];
+    }
+    videoFrame.width = ref->width;
+    videoFrame.height = ref->height;
+    videoFrame.pts = ref->pts;
+    videoFrame.format = ref->format;
+    return videoFrame;
+}
+
+VideoFrame VideoFrame::ref() const {
+    if (avFrame_) {
+        return fromAVFrame(avFrame_);
+    }
+
+    // 不持有引用的帧只复制指针
+    VideoFrame videoFrame;
+    for (int i = 0; i < 3; i++) {
+        videoFrame.data[i] = data[i];
+        videoFrame.linesize[i] = linesize[i];
+    }
+    videoFrame.width = width;
+    videoFrame.height = height;
+    videoFrame.pts = pts;
+    videoFrame.format = format;
+    return videoFrame;
+}
+
+void VideoFrame::reset() {
+    if (avFrame_) {
+        av_frame_free(&avFrame_);
+    }
+    for (int i = 0; i < 3; i++) {
+        data[i] = nullptr;
+        linesize[i] = 0;
+    }
+}
 
 VideoStreamHandler::VideoStreamHandler()
     : formatContext_(nullptr), codecContext_(nullptr), codec_(nullptr), frame_(nullptr), packet_(nullptr),
-      videoStreamIndex_(-1), isStreaming_(false), shouldStop_(false), frameWidth_(0), frameHeight_(0), frameRate_(0.0),
-      frameCount_(0), currentFrameRate_(0.0) {
+      decoderParameters_(nullptr), framePool_(FramePool::create()), hardwareFailed_(false), backendError_(false),
+      decoderUsable_(false), videoStreamIndex_(-1), isStreaming_(false), shouldStop_(false), streamThreadActive_(false),
+      ioDeadlineUs_(0), lastStopLatencyMs_(-1), demuxFinished_(false), decodeFinished_(false),
+      presentationResync_(false), skippingToKeyframe_(false), awaitingKeyframe_(false), keyframeWaitStartUs_(0),
+      corruptionDetected_(false), decodeVisibility_(SurfaceVisibility::Visible), decoderDrained_(false),
+      visibility_(static_cast<int>(SurfaceVisibility::Visible)), suspendedPackets_(0), throttledFrames_(0),
+      keyframeResyncs_(0), keyframeDiscardedPackets_(0), corruptFrames_(0), lastTimeToKeyframeMs_(-1),
+      decodeScheduled_(false), priority_(static_cast<int>(StreamPriority::Normal)), frameWidth_(0), frameHeight_(0),
+      frameRate_(0.0), frameCount_(0), currentFrameRate_(0.0), droppedFrames_(0), reconnects_(0),
+      failedReconnectAttempts_(0), decoderReopens_(0), lastRecoveryMs_(-1), reconnecting_(false),
+      startupTrace_(std::make_shared<StartupTrace>()), streamTimeBase_{1, AV_TIME_BASE},
+      startTimeRealtime_(AV_NOPTS_VALUE), timeToFirstFrameMs_(-1), receiveToRenderMs_(-1), glassToGlassMs_(-1),
+      probeSkipped_(false), decoderName_(nullptr), backendName_(nullptr), hardwareFallbacks_(0), activeThreadType_(0),
+      activeThreadCount_(0) {
     initializeFFmpeg();
 }
 
 VideoStreamHandler::~VideoStreamHandler() {
     stopStream();
     cleanup();
+    framePool_->release();
 }
 
 bool VideoStreamHandler::initializeFFmpeg() {
@@ -27,10 +248,101 @@ bool VideoStreamHandler::initializeFFmpeg() {
     return true;
 }
 
-void VideoStreamHandler::setFrameCallback(FrameCallback callback) {
+size_t VideoStreamHandler::addFrameSubscriber(int64_t id, FrameCallback callback) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    frameSubscribers_[id] = FrameSubscriber{callback};
+    updateVisibility();
+    OH_LOG_INFO(LOG_APP, "Frame subscriber %{public}lld added, %{public}zu subscribers", static_cast<long long>(id),
+                frameSubscribers_.size());
+    return frameSubscribers_.size();
+}
+
+size_t VideoStreamHandler::removeFrameSubscriber(int64_t id) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    frameSubscribers_.erase(id);
+    updateVisibility();
+    OH_LOG_INFO(LOG_APP, "Frame subscriber %{public}lld removed, %{public}zu subscribers", static_cast<long long>(id),
+                frameSubscribers_.size());
+    return frameSubscribers_.size();
+}
+
+bool VideoStreamHandler::hasFrameSubscriber(int64_t id) const {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    return frameSubscribers_.count(id) > 0;
+}
+
+size_t VideoStreamHandler::getFrameSubscriberCount() const {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    return frameSubscribers_.size();
+}
+
+std::vector<int64_t> VideoStreamHandler::adoptFrameSubscribers(VideoStreamHandler &previous) {
+    std::map<int64_t, FrameSubscriber> subscribers;
+    {
+        std::lock_guard<std::mutex> lock(previous.callbackMutex_);
+        subscribers.swap(previous.frameSubscribers_);
+        previous.updateVisibility();
+    }
+
+    std::vector<int64_t> adopted;
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    for (auto &entry : subscribers) {
+        if (frameSubscribers_.count(entry.first) > 0) {
+            continue;
+        }
+        entry.second.lastDeliveredUs = 0;
+        frameSubscribers_.emplace(entry.first, std::move(entry.second));
+        adopted.push_back(entry.first);
+    }
+    updateVisibility();
+    OH_LOG_INFO(LOG_APP, "Adopted %{public}zu frame subscribers, %{public}zu subscribers", adopted.size(),
+                frameSubscribers_.size());
+    return adopted;
+}
+
+bool VideoStreamHandler::setSubscriberVisibility(int64_t id, SurfaceVisibility visibility) {
     std::lock_guard<std::mutex> lock(callbackMutex_);
-    frameCallback_ = callback;
-    OH_LOG_INFO(LOG_APP, "Frame callback set successfully");
+    auto it = frameSubscribers_.find(id);
+    if (it == frameSubscribers_.end()) {
+        return false;
+    }
+    it->second.visibility = visibility;
+    updateVisibility();
+    return true;
+}
+
+// 调用方持有callbackMutex_
+void VideoStreamHandler::updateVisibility() {
+    SurfaceVisibility highest = SurfaceVisibility::Hidden;
+    for (const auto &subscriber : frameSubscribers_) {
+        highest = std::max(highest, subscriber.second.visibility);
+    }
+    int previous = visibility_.exchange(static_cast<int>(highest));
+    if (previous != static_cast<int>(highest)) {
+        OH_LOG_INFO(LOG_APP, "Stream visibility %{public}d -> %{public}d", previous, static_cast<int>(highest));
+    }
+}
+
+SurfaceVisibility VideoStreamHandler::getVisibility() const {
+    return static_cast<SurfaceVisibility>(visibility_.load(std::memory_order_relaxed));
+}
+
+KeyframeSyncStats VideoStreamHandler::getKeyframeSyncStats() const {
+    KeyframeSyncStats stats;
+    stats.resyncs = keyframeResyncs_.load();
+    stats.discardedPackets = keyframeDiscardedPackets_.load();
+    stats.corruptFrames = corruptFrames_.load();
+    stats.lastTimeToKeyframeMs = lastTimeToKeyframeMs_.load();
+    stats.awaitingKeyframe = awaitingKeyframe_.load();
+    return stats;
+}
+
+VisibilityStats VideoStreamHandler::getVisibilityStats() const {
+    VisibilityStats stats;
+    stats.visibility = getVisibility();
+    stats.suspendedPackets = suspendedPackets_.load();
+    stats.throttledFrames = throttledFrames_.load();
+    return stats;
 }
 
 void VideoStreamHandler::setErrorCallback(ErrorCallback callback) {
@@ -38,47 +350,113 @@ void VideoStreamHandler::setErrorCallback(ErrorCallback callback) {
     errorCallback_ = callback;
 }
 
-bool VideoStreamHandler::startStream(const std::string &url) {
+bool VideoStreamHandler::startStream(const std::string &url, const StreamOptions &options) {
     OH_LOG_INFO(LOG_APP, "VideoStreamHandler::startStream called with URL: %{public}s", url.c_str());
 
-    if (isStreaming_) {
+    if (isStreaming_ || streamThreadActive_) {
         OH_LOG_WARN(LOG_APP, "Stream already running");
         return false;
     }
+    // 上一次的流已自行结束（如文件播放完），回收其线程
+    if (streamThread_.joinable()) {
+        streamThread_.join();
+    }
 
     streamUrl_ = url;
     shouldStop_ = false;
+    demuxFinished_ = false;
+    decodeFinished_ = false;
     frameCount_ = 0;
     currentFrameRate_ = 0.0;
+    droppedFrames_ = 0;
+    suspendedPackets_ = 0;
+    throttledFrames_ = 0;
+    keyframeResyncs_ = 0;
+    keyframeDiscardedPackets_ = 0;
+    corruptFrames_ = 0;
+    lastTimeToKeyframeMs_ = -1;
+    hardwareFailed_ = false;
+    hardwareFallbacks_ = 0;
+    reconnects_ = 0;
+    failedReconnectAttempts_ = 0;
+    decoderReopens_ = 0;
+    lastRecoveryMs_ = -1;
+    reconnecting_ = false;
+    startupTrace_->reset();
+    startTime_ = std::chrono::steady_clock::now();
+    startTimeRealtime_ = AV_NOPTS_VALUE;
+    timeToFirstFrameMs_ = -1;
+    receiveToRenderMs_ = -1;
+    glassToGlassMs_ = -1;
+    probeSkipped_ = false;
+
+    options_ = options;
+    priority_ = static_cast<int>(options_.priority);
+    packetQueue_ = std::make_unique<SpscQueue<AVPacket *>>(options_.packetQueueDepth);
+    frameQueue_ = std::make_unique<SpscQueue<VideoFrame>>(options_.frameQueueDepth);
 
     // 在新线程中开始流处理
     try {
-        streamThread_ = std::thread(&VideoStreamHandler::streamThread, this);
+        streamThreadActive_ = true;
+        streamThread_ = std::thread([this]() {
+            streamThread();
+            streamThreadActive_ = false;
+        });
         OH_LOG_INFO(LOG_APP, "Stream thread started successfully");
         return true;
     } catch (const std::exception &e) {
+        streamThreadActive_ = false;
         OH_LOG_ERROR(LOG_APP, "Failed to start stream thread: %{public}s", e.what());
         return false;
     }
 }
 
 void VideoStreamHandler::stopStream() {
-    if (!isStreaming_) {
+    // 正在打开或重连时isStreaming_还是false，同样需要打断并等待流线程
+    if (!streamThread_.joinable()) {
         return;
     }
 
+    auto stopTime = std::chrono::steady_clock::now();
     shouldStop_ = true;
-
-    if (streamThread_.joinable()) {
-        streamThread_.join();
-    }
+    streamThread_.join();
 
     cleanup();
     isStreaming_ = false;
+    {
+        std::lock_guard<std::mutex> lock(latestFrameMutex_);
+        latestFrame_ = VideoFrame();
+    }
+
+    double stopLatencyMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stopTime).count();
+    lastStopLatencyMs_ = stopLatencyMs;
+    OH_LOG_INFO(LOG_APP, "Stream stopped in %{public}.1f ms", stopLatencyMs);
+}
+
+double VideoStreamHandler::getLastStopLatencyMs() const { return lastStopLatencyMs_.load(); }
+
+int VideoStreamHandler::interruptCallback(void *opaque) {
+    auto *handler = static_cast<VideoStreamHandler *>(opaque);
+    if (handler->shouldStop_) {
+        return 1;
+    }
+    int64_t deadlineUs = handler->ioDeadlineUs_.load(std::memory_order_relaxed);
+    return deadlineUs > 0 && av_gettime_relative() > deadlineUs ? 1 : 0;
+}
+
+void VideoStreamHandler::armIoDeadline(int64_t timeoutUs) {
+    ioDeadlineUs_.store(av_gettime_relative() + timeoutUs, std::memory_order_relaxed);
 }
 
 bool VideoStreamHandler::isStreaming() const { return isStreaming_; }
 
+bool VideoStreamHandler::isActive() const { return streamThreadActive_; }
+
+void VideoStreamHandler::setPriority(StreamPriority priority) { priority_ = static_cast<int>(priority); }
+
+StreamPriority VideoStreamHandler::getPriority() const { return static_cast<StreamPriority>(priority_.load()); }
+
 std::string VideoStreamHandler::getStreamInfo() const {
     if (!isStreaming_) {
         return "Not streaming";
@@ -89,29 +467,25 @@ std::string VideoStreamHandler::getStreamInfo() const {
 }
 
 void VideoStreamHandler::streamThread() {
+    startupTrace_->mark(StartupPhase::ThreadSpawned);
     OH_LOG_INFO(LOG_APP, "Stream thread started for URL: %{public}s", streamUrl_.c_str());
 
     // 打开流
     if (!openInputStream(streamUrl_)) {
         OH_LOG_ERROR(LOG_APP, "Failed to open input stream: %{public}s", streamUrl_.c_str());
-        std::lock_guard<std::mutex> lock(callbackMutex_);
-        if (errorCallback_) {
-            errorCallback_("Failed to open input stream: " + streamUrl_);
-        }
+        reportError("Failed to open input stream: " + streamUrl_);
         return;
     }
 
     // 设置解码器
     if (!setupDecoder()) {
         OH_LOG_ERROR(LOG_APP, "Failed to setup decoder");
-        std::lock_guard<std::mutex> lock(callbackMutex_);
-        if (errorCallback_) {
-            errorCallback_("Failed to setup decoder");
-        }
+        reportError("Failed to setup decoder");
         return;
     }
 
     OH_LOG_INFO(LOG_APP, "Decoder setup successfully");
+    latencyController_.reset(resolveTargetLatencyMs(), streamTimeBase_);
     isStreaming_ = true;
 
     // 分配帧内存
@@ -119,48 +493,67 @@ void VideoStreamHandler::streamThread() {
     packet_ = av_packet_alloc();
 
     if (!frame_ || !packet_) {
-        std::lock_guard<std::mutex> lock(callbackMutex_);
-        if (errorCallback_) {
-            errorCallback_("Failed to allocate frame memory");
-        }
+        reportError("Failed to allocate frame memory");
         return;
     }
 
-    OH_LOG_INFO(LOG_APP, "Starting main decode loop...");
-    int frameCount = 0;
+    // 拉起解码和渲染阶段，本线程继续负责解复用
+    startPipeline();
+
+    OH_LOG_INFO(LOG_APP, "Starting demux loop...");
 
     // 主循环
     while (!shouldStop_) {
+        armIoDeadline(READ_TIMEOUT_US);
         int ret = av_read_frame(formatContext_, packet_);
         if (ret >= 0) {
             if (packet_->stream_index == videoStreamIndex_) {
-                // 发送数据包到解码器
-                if (avcodec_send_packet(codecContext_, packet_) >= 0) {
-                    // 接收解码后的帧
-                    while (avcodec_receive_frame(codecContext_, frame_) >= 0) {
-                        processFrame(frame_);
-                        frameCount_++;
-                        if (frameCount_ % 30 == 0) { // 每30帧输出一次日志
-                            OH_LOG_INFO(LOG_APP, "Processed %{public}d frames", frameCount_.load());
-                        }
-                    }
+                startupTrace_->mark(StartupPhase::FirstPacket);
+                if (packet_->flags & AV_PKT_FLAG_KEY) {
+                    startupTrace_->mark(StartupPhase::FirstKeyframe);
+                }
+                // RTCP发送端报告到达后才能得到墙钟基准
+                if (formatContext_->start_time_realtime != startTimeRealtime_.load()) {
+                    startTimeRealtime_ = formatContext_->start_time_realtime;
+                }
+                latencyController_.onPacketArrival(packet_->pts, av_gettime_relative());
+                AVPacket *queued = av_packet_alloc();
+                if (queued) {
+                    av_packet_move_ref(queued, packet_);
+                    // 到达时间随AV_CODEC_FLAG_COPY_OPAQUE带到解码输出帧上
+                    queued->opaque = reinterpret_cast<void *>(static_cast<intptr_t>(elapsedMs()));
+                    pushPacket(queued);
                 }
             }
             av_packet_unref(packet_);
-        } else {
-            // 读取失败，可能是流结束或网络错误
+            continue;
+        }
+
+        if (ret == AVERROR(EAGAIN)) {
+            std::this_thread::sleep_for(READ_RETRY_INTERVAL);
+            continue;
+        }
+
+        // 读取失败：文件读完正常结束，连接断开则按配置重连
+        if (!shouldReconnect(ret)) {
             if (ret == AVERROR_EOF) {
                 OH_LOG_INFO(LOG_APP, "End of stream reached");
-                break;
-            } else {
+            } else if (!shouldStop_) {
                 char error_str[AV_ERROR_MAX_STRING_SIZE];
                 av_strerror(ret, error_str, AV_ERROR_MAX_STRING_SIZE);
-                OH_LOG_WARN(LOG_APP, "av_read_frame failed: %{public}s", error_str);
+                OH_LOG_ERROR(LOG_APP, "av_read_frame failed: %{public}s", error_str);
+                reportError(std::string("Stream read failed: ") + error_str);
             }
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            break;
+        }
+        if (!reconnect(ret)) {
+            break;
         }
     }
 
+    stopPipeline();
+    drainQueues();
+
     OH_LOG_INFO(LOG_APP, "Main loop ended, processed %{public}d frames total", frameCount_.load());
 
     // 更新当前帧率
@@ -170,6 +563,509 @@ void VideoStreamHandler::streamThread() {
     isStreaming_ = false;
 }
 
+void VideoStreamHandler::startPipeline() {
+    demuxFinished_ = false;
+    decodeFinished_ = false;
+    presentationResync_ = false;
+    skippingToKeyframe_ = false;
+    awaitingKeyframe_ = false;
+    corruptionDetected_ = false;
+    decodeVisibility_ = SurfaceVisibility::Visible;
+    decodeScheduled_ = false;
+    decoderDrained_ = false;
+    pendingFrames_.clear();
+    // 加入正在进行的直播时第一个包多半是P帧，等到关键帧再开始解码
+    if (options_.keyframeResync) {
+        beginKeyframeWait("start");
+    }
+    // 共享解码时由入队的数据包触发解码片段，不单独起线程
+    if (!options_.sharedDecoder) {
+        decodeThread_ = std::thread(&VideoStreamHandler::decodeThread, this);
+    }
+    renderThread_ = std::thread(&VideoStreamHandler::renderThread, this);
+}
+
+// 通知下游没有更多数据，等待解码和渲染阶段排空
+void VideoStreamHandler::stopPipeline() {
+    demuxFinished_ = true;
+    if (options_.sharedDecoder) {
+        // 最后一个片段冲刷解码器后置位decodeFinished_并保持调度标记，此后不会再有片段访问解码器。
+        // 正在运行的片段释放标记后会看到demuxFinished_并重新调度；按pts呈现时排空积压需要按实际速率播放完，
+        // 因此不设超时，停止请求下片段立即收尾
+        scheduleDecode();
+        std::unique_lock<std::mutex> lock(decodeFinishedMutex_);
+        decodeFinishedCond_.wait(lock, [this]() { return decodeFinished_.load(); });
+    }
+    if (decodeThread_.joinable()) {
+        decodeThread_.join();
+    }
+    if (renderThread_.joinable()) {
+        renderThread_.join();
+    }
+}
+
+bool VideoStreamHandler::pushPacket(AVPacket *packet) {
+    // 队列满时阻塞解复用，队列深度用于吸收网络抖动
+    while (!packetQueue_->tryPush(std::move(packet))) {
+        if (shouldStop_) {
+            av_packet_free(&packet);
+            return false;
+        }
+        std::this_thread::sleep_for(QUEUE_POLL_INTERVAL);
+    }
+    if (options_.sharedDecoder) {
+        scheduleDecode();
+    }
+    return true;
+}
+
+bool VideoStreamHandler::shouldReconnect(int readError) const {
+    if (!options_.autoReconnect || shouldStop_) {
+        return false;
+    }
+    // 文件和点播读到结尾是正常结束，实时流的EOF意味着服务端关闭了连接
+    return readError != AVERROR_EOF || isLiveUrl();
+}
+
+bool VideoStreamHandler::reconnect(int readError) {
+    char error_str[AV_ERROR_MAX_STRING_SIZE];
+    av_strerror(readError, error_str, AV_ERROR_MAX_STRING_SIZE);
+    OH_LOG_WARN(LOG_APP, "Stream interrupted (%{public}s), reconnecting", error_str);
+    reportError(std::string("Stream interrupted, reconnecting: ") + error_str);
+
+    auto lostTime = std::chrono::steady_clock::now();
+    reconnecting_ = true;
+    avformat_close_input(&formatContext_);
+
+    // 按退避间隔重新打开输入，期间解码和渲染线程继续消费队列中已有的数据
+    bool connected = false;
+    int attempt = 1;
+    for (; !shouldStop_; attempt++) {
+        if (options_.maxReconnectAttempts >= 0 && attempt > options_.maxReconnectAttempts) {
+            break;
+        }
+        int64_t delayMs = ReconnectDelayMs(options_, attempt);
+        OH_LOG_INFO(LOG_APP, "Reconnect attempt %{public}d in %{public}lld ms", attempt,
+                    static_cast<long long>(delayMs));
+        if (!sleepUnlessStopped(delayMs)) {
+            break;
+        }
+        if (openInputStream(streamUrl_)) {
+            connected = true;
+            break;
+        }
+        if (formatContext_) {
+            avformat_close_input(&formatContext_);
+        }
+        failedReconnectAttempts_++;
+    }
+    reconnecting_ = false;
+
+    if (!connected) {
+        if (!shouldStop_) {
+            OH_LOG_ERROR(LOG_APP, "Reconnect failed after %{public}d attempts", attempt - 1);
+            reportError("Reconnect failed after " + std::to_string(attempt - 1) + " attempts: " + streamUrl_);
+        }
+        return false;
+    }
+
+    if (decoderParametersMatch()) {
+        // 编码参数不变时沿用解码器：解码线程处理完旧连接的数据后收到哨兵包，冲刷解码器并等待新连接的关键帧
+        AVPacket *flushPacket = av_packet_alloc();
+        if (flushPacket) {
+            flushPacket->stream_index = FLUSH_PACKET_STREAM_INDEX;
+            pushPacket(flushPacket);
+        }
+        latencyController_.rebase();
+    } else {
+        // 编码参数变化：排空并停止下游阶段，按新参数重建解码器后重新拉起
+        OH_LOG_INFO(LOG_APP, "Codec parameters changed after reconnect, reopening decoder");
+        stopPipeline();
+        drainQueues();
+        decoderUsable_ = false;
+        avcodec_free_context(&codecContext_);
+        if (!setupDecoder()) {
+            OH_LOG_ERROR(LOG_APP, "Failed to setup decoder after reconnect");
+            reportError("Failed to setup decoder after reconnect");
+            return false;
+        }
+        latencyController_.reset(resolveTargetLatencyMs(), streamTimeBase_);
+        decoderReopens_++;
+        startPipeline();
+    }
+
+    double recoveryMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lostTime).count();
+    lastRecoveryMs_ = recoveryMs;
+    reconnects_++;
+    OH_LOG_INFO(LOG_APP, "Reconnected after %{public}.0f ms, %{public}d attempts", recoveryMs, attempt);
+    reportError("Reconnected after " + std::to_string(static_cast<int>(recoveryMs)) + " ms: " + streamUrl_);
+    return true;
+}
+
+bool VideoStreamHandler::sleepUnlessStopped(int64_t delayMs) const {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMs);
+    while (!shouldStop_) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return true;
+        }
+        std::this_thread::sleep_for(
+            std::min<std::chrono::steady_clock::duration>(deadline - now, RECONNECT_POLL_INTERVAL));
+    }
+    return false;
+}
+
+void VideoStreamHandler::reportError(const std::string &message) {
+    std::lock_guard<std::mutex> lock(callbackMutex_);
+    if (errorCallback_) {
+        errorCallback_(message);
+    }
+}
+
+void VideoStreamHandler::decodeThread() {
+    OH_LOG_INFO(LOG_APP, "Decode thread started");
+    SetThreadAffinity(options_.decodeCpus, nullptr);
+
+    while (!shouldStop_) {
+        AVPacket *packet = nullptr;
+        if (!packetQueue_->tryPop(packet)) {
+            if (demuxFinished_) {
+                break;
+            }
+            std::this_thread::sleep_for(QUEUE_POLL_INTERVAL);
+            continue;
+        }
+        decodePacket(packet);
+    }
+
+    drainDecoder();
+    finishDecode();
+    OH_LOG_INFO(LOG_APP, "Decode thread ended");
+}
+
+void VideoStreamHandler::scheduleDecode() {
+    if (decodeScheduled_.exchange(true)) {
+        return;
+    }
+    StreamExecutor::shared().submit([this]() { runDecodeSlice(); }, getPriority());
+}
+
+bool VideoStreamHandler::frameQueueBackpressured() const {
+    return options_.framePacing && frameQueue_->size() >= frameQueue_->capacity();
+}
+
+void VideoStreamHandler::pushPendingFrames() {
+    while (!pendingFrames_.empty() && frameQueue_->tryPush(std::move(pendingFrames_.front()))) {
+        pendingFrames_.pop_front();
+    }
+}
+
+void VideoStreamHandler::runDecodeSlice() {
+    // 先交出之前的片段因帧队列满暂存的帧；交不完或帧队列已满时不再取数据包，让出工作线程，渲染线程取走帧后重新调度
+    pushPendingFrames();
+    for (int i = 0; i < DECODE_SLICE_PACKETS && !shouldStop_ && pendingFrames_.empty() && !frameQueueBackpressured();
+         i++) {
+        AVPacket *packet = nullptr;
+        if (!packetQueue_->tryPop(packet)) {
+            break;
+        }
+        decodePacket(packet);
+    }
+
+    // 收尾时调度标记保持置位，不会再提交新的片段
+    if (shouldStop_) {
+        pendingFrames_.clear();
+        finishDecode();
+        return;
+    }
+    // 解复用已结束且队列已空时冲刷解码器，冲刷出的帧全部交出后收尾
+    if (demuxFinished_ && packetQueue_->empty() && pendingFrames_.empty()) {
+        if (!decoderDrained_) {
+            decoderDrained_ = true;
+            drainDecoder();
+        }
+        if (pendingFrames_.empty()) {
+            finishDecode();
+            return;
+        }
+    }
+
+    // 释放标记后再检查一次，避免与解复用线程的入队、渲染线程取帧或stopPipeline的结束通知交错而漏掉调度。
+    // 释放后可能有新的片段开始执行，暂存帧的状态须在释放前读取
+    bool hasPendingFrames = !pendingFrames_.empty();
+    decodeScheduled_ = false;
+    if (shouldStop_ ||
+        ((demuxFinished_ || hasPendingFrames || !packetQueue_->empty()) && !frameQueueBackpressured())) {
+        scheduleDecode();
+    }
+}
+
+// 将解码出的帧移交渲染队列。
+// 按pts呈现时队列满说明解码快于实时（文件、点播、突发到达或重连后的积压），阻塞解码并经数据包队列反压到解复用，
+// 迟到帧只由呈现调度丢弃；共享解码不阻塞执行器的工作线程，放不下的帧暂存，由下一个片段先交出。
+// 不按pts呈现时渲染跟不上就丢弃新帧，避免GPU阻塞反压到解码和网络
+void VideoStreamHandler::receiveFrames() {
+    while (avcodec_receive_frame(codecContext_, frame_) >= 0) {
+        startupTrace_->mark(StartupPhase::FirstDecodedFrame);
+        // 入队的是缓冲区引用，frame_随即释放以便解码器继续输出
+        // 参考帧缺失时解码器会做错误隐藏并标记损坏，这样的帧不显示
+        if (options_.keyframeResync && (frame_->flags & AV_FRAME_FLAG_CORRUPT)) {
+            av_frame_unref(frame_);
+            corruptFrames_++;
+            corruptionDetected_ = true;
+            continue;
+        }
+        // 硬件帧下载到内存；失败时丢弃该帧，由decodePacket改用软件解码器
+        if (decoderBackend_->transfer(frame_) < 0) {
+            av_frame_unref(frame_);
+            backendError_ = true;
+            continue;
+        }
+        VideoFrame videoFrame = VideoFrame::fromAVFrame(frame_);
+        av_frame_unref(frame_);
+        if (!videoFrame.isValid()) {
+            continue;
+        }
+        if (!options_.framePacing) {
+            if (!frameQueue_->tryPush(std::move(videoFrame))) {
+                droppedFrames_++;
+            }
+            continue;
+        }
+        if (options_.sharedDecoder) {
+            if (!pendingFrames_.empty() || !frameQueue_->tryPush(std::move(videoFrame))) {
+                pendingFrames_.push_back(std::move(videoFrame));
+            }
+            continue;
+        }
+        while (!frameQueue_->tryPush(std::move(videoFrame))) {
+            if (shouldStop_) {
+                return;
+            }
+            std::this_thread::sleep_for(QUEUE_POLL_INTERVAL);
+        }
+    }
+}
+
+void VideoStreamHandler::decodePacket(AVPacket *packet) {
+    // 软件解码器重建失败后不再解码，只消耗队列
+    if (!codecContext_) {
+        av_packet_free(&packet);
+        return;
+    }
+
+    // 重连哨兵：先取出解码器中旧连接的剩余帧，再冲刷参考帧，从新连接的关键帧开始解码
+    if (packet->stream_index == FLUSH_PACKET_STREAM_INDEX) {
+        if (avcodec_send_packet(codecContext_, nullptr) >= 0) {
+            receiveFrames();
+        }
+        avcodec_flush_buffers(codecContext_);
+        beginKeyframeWait("reconnect");
+        presentationResync_ = true;
+        av_packet_free(&packet);
+        return;
+    }
+
+    // 可见性切换：从不可见恢复时之前的非关键帧没有解码，参考帧不完整，需要从下一个关键帧开始
+    SurfaceVisibility visibility = getVisibility();
+    bool suspend = visibility == SurfaceVisibility::Hidden && options_.hiddenDecodeMode == HiddenDecodeMode::Suspend;
+    if (visibility != decodeVisibility_) {
+        if (decodeVisibility_ == SurfaceVisibility::Hidden) {
+            beginKeyframeWait("visible");
+            if (options_.hiddenDecodeMode == HiddenDecodeMode::Suspend) {
+                avcodec_flush_buffers(codecContext_);
+                presentationResync_ = true;
+            }
+        }
+        decodeVisibility_ = visibility;
+    }
+    if (suspend) {
+        suspendedPackets_++;
+        av_packet_free(&packet);
+        return;
+    }
+    // 解复用层发现的丢包（如TS连续计数错误）：之后的帧参考链已断，丢弃解码器中的参考帧并等待关键帧
+    if (options_.keyframeResync && (packet->flags & AV_PKT_FLAG_CORRUPT) && !(packet->flags & AV_PKT_FLAG_KEY)) {
+        avcodec_flush_buffers(codecContext_);
+        beginKeyframeWait("corrupt packet");
+    }
+    if (awaitingKeyframe_) {
+        if (!(packet->flags & AV_PKT_FLAG_KEY)) {
+            keyframeDiscardedPackets_++;
+            av_packet_free(&packet);
+            return;
+        }
+        awaitingKeyframe_ = false;
+        double waitedMs = (av_gettime_relative() - keyframeWaitStartUs_) / 1000.0;
+        lastTimeToKeyframeMs_ = waitedMs;
+        OH_LOG_INFO(LOG_APP, "Keyframe received after %{public}.0f ms, %{public}llu packets discarded in total", waitedMs,
+                    static_cast<unsigned long long>(keyframeDiscardedPackets_.load()));
+    }
+
+    // 延迟控制：积压严重时丢包直到下一个关键帧，中度积压时只解码参考帧
+    if (latencyController_.takeKeyframeSkip()) {
+        skippingToKeyframe_ = true;
+    }
+    if (skippingToKeyframe_) {
+        if (!(packet->flags & AV_PKT_FLAG_KEY)) {
+            latencyController_.onPacketSkipped();
+            av_packet_free(&packet);
+            return;
+        }
+        // 丢弃解码器内尚未输出的旧帧，从关键帧重新开始
+        avcodec_flush_buffers(codecContext_);
+        skippingToKeyframe_ = false;
+    }
+    // 不可见只解码关键帧，缩略图只解码参考帧，与延迟控制的要求取较严格者
+    AVDiscard visibilityDiscard = AVDISCARD_DEFAULT;
+    if (visibility == SurfaceVisibility::Hidden) {
+        visibilityDiscard = AVDISCARD_NONKEY;
+    } else if (visibility == SurfaceVisibility::Thumbnail) {
+        visibilityDiscard = AVDISCARD_NONREF;
+    }
+    codecContext_->skip_frame = std::max(latencyController_.decodeDiscard(), visibilityDiscard);
+
+    // 发送数据包到解码器
+    int ret = avcodec_send_packet(codecContext_, packet);
+    if (ret >= 0) {
+        // 接收解码后的帧
+        receiveFrames();
+    }
+    av_packet_free(&packet);
+
+    // 码流无法解析或解码出损坏帧：丢弃参考帧，从下一个关键帧重新同步
+    if (options_.keyframeResync && (ret == AVERROR_INVALIDDATA || corruptionDetected_)) {
+        corruptionDetected_ = false;
+        avcodec_flush_buffers(codecContext_);
+        beginKeyframeWait("decode error");
+    }
+
+    if (backendError_) {
+        backendError_ = false;
+        reopenSoftwareDecoder();
+    }
+}
+
+void VideoStreamHandler::beginKeyframeWait(const char *reason) {
+    if (awaitingKeyframe_) {
+        return;
+    }
+    awaitingKeyframe_ = true;
+    keyframeWaitStartUs_ = av_gettime_relative();
+    keyframeResyncs_++;
+    OH_LOG_INFO(LOG_APP, "Waiting for keyframe: %{public}s", reason);
+}
+
+// 流结束时冲刷解码器中缓存的帧
+void VideoStreamHandler::drainDecoder() {
+    if (!shouldStop_ && codecContext_ && avcodec_send_packet(codecContext_, nullptr) >= 0) {
+        receiveFrames();
+    }
+}
+
+void VideoStreamHandler::finishDecode() {
+    // 在锁内通知：等待方被唤醒后可能立即销毁handler，解锁是这里对成员的最后一次访问
+    std::lock_guard<std::mutex> lock(decodeFinishedMutex_);
+    decodeFinished_ = true;
+    decodeFinishedCond_.notify_all();
+}
+
+void VideoStreamHandler::renderThread() {
+    OH_LOG_INFO(LOG_APP, "Render thread started");
+
+    scheduler_.reset(streamTimeBase_, frameRate_);
+    auto summaryTime = std::chrono::steady_clock::now();
+    int summaryFrameCount = frameCount_.load();
+    VideoFrame frame;
+    while (!shouldStop_) {
+        if (!frame.isValid()) {
+            if (!frameQueue_->tryPop(frame)) {
+                if (decodeFinished_) {
+                    break;
+                }
+                std::this_thread::sleep_for(QUEUE_POLL_INTERVAL);
+                continue;
+            }
+            // 共享解码在帧队列满时让出了工作线程，腾出位置后重新调度
+            if (options_.sharedDecoder) {
+                scheduleDecode();
+            }
+        }
+
+        // 重连后pts重新起算，呈现时钟重新锚定
+        if (presentationResync_.exchange(false)) {
+            scheduler_.resync();
+        }
+
+        // 按pts调度呈现：未到时间则等待，已迟到且有后续帧则丢弃
+        if (options_.framePacing) {
+            int64_t waitUs = 0;
+            PresentAction action =
+                scheduler_.evaluate(frame.pts, av_gettime_relative(), !frameQueue_->empty(), waitUs);
+            if (action == PresentAction::Wait) {
+                std::this_thread::sleep_for(std::chrono::microseconds(std::min(waitUs, PRESENT_MAX_SLEEP_US)));
+                continue;
+            }
+            if (action == PresentAction::Drop) {
+                frame = VideoFrame();
+                continue;
+            }
+        }
+
+        if (processFrame(frame)) {
+            updateLatency(frame);
+        }
+        frameCount_++;
+
+        // 按实际排队延迟调整呈现速率；需要跳到关键帧时清掉已解码的积压帧并重新锚定
+        bool needResync = false;
+        double packetQueueFill = static_cast<double>(packetQueue_->size()) / packetQueue_->capacity();
+        double rate =
+            latencyController_.onFramePresented(frame.pts, av_gettime_relative(), packetQueueFill, needResync);
+        scheduler_.setRate(rate);
+        if (needResync) {
+            VideoFrame stale;
+            uint64_t flushed = 0;
+            while (frameQueue_->tryPop(stale)) {
+                flushed++;
+            }
+            latencyController_.onFramesFlushed(flushed);
+            scheduler_.resync();
+        }
+
+        // 定期汇总，同时更新实测帧率
+        auto now = std::chrono::steady_clock::now();
+        if (now - summaryTime >= LOG_SUMMARY_INTERVAL) {
+            int frames = frameCount_.load();
+            double seconds = std::chrono::duration<double>(now - summaryTime).count();
+            currentFrameRate_ = (frames - summaryFrameCount) / seconds;
+            OH_LOG_INFO(LOG_APP,
+                        "Processed %{public}d frames, %{public}.1f fps, dropped %{public}d, "
+                        "queued packets %{public}zu, queued frames %{public}zu",
+                        frames, currentFrameRate_.load(), droppedFrames_.load(), packetQueue_->size(),
+                        frameQueue_->size());
+            summaryTime = now;
+            summaryFrameCount = frames;
+        }
+        frame = VideoFrame();
+    }
+
+    OH_LOG_INFO(LOG_APP, "Render thread ended");
+}
+
+void VideoStreamHandler::drainQueues() {
+    AVPacket *packet = nullptr;
+    while (packetQueue_ && packetQueue_->tryPop(packet)) {
+        av_packet_free(&packet);
+    }
+
+    VideoFrame frame;
+    while (frameQueue_ && frameQueue_->tryPop(frame)) {
+    }
+    pendingFrames_.clear();
+}
+
 bool VideoStreamHandler::openInputStream(const std::string &url) {
     OH_LOG_INFO(LOG_APP, "Opening input stream: %{public}s", url.c_str());
 
@@ -179,15 +1075,29 @@ bool VideoStreamHandler::openInputStream(const std::string &url) {
         return false;
     }
 
+    // 阻塞在连接、读取中的操作由停止请求或超时打断
+    formatContext_->interrupt_callback.callback = &VideoStreamHandler::interruptCallback;
+    formatContext_->interrupt_callback.opaque = this;
+
     // 设置选项用于RTSP/RTP
     AVDictionary *options = nullptr;
     av_dict_set(&options, "rtsp_transport", "tcp", 0);
-    av_dict_set(&options, "stimeout", "5000000", 0); // 5秒超时
+    // FFmpeg 5起stimeout更名为timeout；RTMP的timeout含义是监听等待，只对RTSP设置
+    if (url.compare(0, 4, "rtsp") == 0) {
+        av_dict_set(&options, "timeout", RTSP_SOCKET_TIMEOUT, 0);
+    }
     av_dict_set(&options, "user_agent", "FFmpeg/VideoStream", 0);
     av_dict_set(&options, "max_delay", "500000", 0); // 最大延迟500ms
+    if (options_.lowLatency) {
+        av_dict_set(&options, "fflags", "nobuffer", 0);
+        av_dict_set(&options, "probesize", LOW_LATENCY_PROBE_SIZE, 0);
+        av_dict_set(&options, "analyzeduration", LOW_LATENCY_ANALYZE_DURATION, 0);
+        av_dict_set(&options, "max_delay", "0", 0);
+    }
 
     // 打开流
     OH_LOG_INFO(LOG_APP, "Attempting to open input with avformat_open_input...");
+    armIoDeadline(OPEN_TIMEOUT_US);
     int ret = avformat_open_input(&formatContext_, url.c_str(), nullptr, &options);
     if (ret != 0) {
         char error_str[AV_ERROR_MAX_STRING_SIZE];
@@ -200,18 +1110,26 @@ bool VideoStreamHandler::openInputStream(const std::string &url) {
     }
 
     av_dict_free(&options);
+    startupTrace_->mark(StartupPhase::InputOpened);
     OH_LOG_INFO(LOG_APP, "avformat_open_input succeeded");
 
-    // 寻找流信息
-    OH_LOG_INFO(LOG_APP, "Finding stream info...");
-    ret = avformat_find_stream_info(formatContext_, nullptr);
-    if (ret < 0) {
-        char error_str[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, error_str, AV_ERROR_MAX_STRING_SIZE);
-        OH_LOG_ERROR(LOG_APP, "avformat_find_stream_info failed with error code %{public}d: %{public}s", ret,
-                     error_str);
-        return false;
+    // 寻找流信息；低延迟模式或重连时若SDP已给出编码参数，则直接交给解码器从码流中获取其余信息
+    if ((options_.lowLatency || reconnecting_) && HasDecoderParameters(formatContext_)) {
+        OH_LOG_INFO(LOG_APP, "Codec parameters available from stream header, skipping find_stream_info");
+        probeSkipped_ = true;
+    } else {
+        OH_LOG_INFO(LOG_APP, "Finding stream info...");
+        armIoDeadline(PROBE_TIMEOUT_US);
+        ret = avformat_find_stream_info(formatContext_, nullptr);
+        if (ret < 0) {
+            char error_str[AV_ERROR_MAX_STRING_SIZE];
+            av_strerror(ret, error_str, AV_ERROR_MAX_STRING_SIZE);
+            OH_LOG_ERROR(LOG_APP, "avformat_find_stream_info failed with error code %{public}d: %{public}s", ret,
+                         error_str);
+            return false;
+        }
     }
+    startupTrace_->mark(StartupPhase::StreamInfoFound);
 
     OH_LOG_INFO(LOG_APP, "Stream info found, total streams: %{public}u", formatContext_->nb_streams);
 
@@ -261,47 +1179,54 @@ bool VideoStreamHandler::setupDecoder() {
 
     OH_LOG_INFO(LOG_APP, "Found decoder: %{public}s", codec_->name);
 
-    // 分配解码器上下文
-    codecContext_ = avcodec_alloc_context3(codec_);
-    if (!codecContext_) {
-        OH_LOG_ERROR(LOG_APP, "Failed to allocate codec context");
-        return false;
+    // 优先使用注入的后端或平台提供的硬件解码，打开失败时回退软件解码
+    decoderBackend_.reset();
+    if (options_.decoderBackendFactory && !hardwareFailed_) {
+        decoderBackend_ = options_.decoderBackendFactory(codec_);
     }
-
-    // 从流参数复制到解码器上下文
-    int ret = avcodec_parameters_to_context(codecContext_, codecpar);
-    if (ret < 0) {
-        char error_str[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, error_str, AV_ERROR_MAX_STRING_SIZE);
-        OH_LOG_ERROR(LOG_APP, "Failed to copy codec parameters: %{public}s", error_str);
+    if (!decoderBackend_) {
+        decoderBackend_ =
+            CreateDecoderBackend(hardwareFailed_ ? DecoderBackendMode::Software : options_.decoderBackend, codec_);
+    }
+    bool opened = openDecoder(codecpar);
+    if (!opened && decoderBackend_->isHardware()) {
+        fallBackToSoftware("failed to open");
+        opened = openDecoder(codecpar);
+    }
+    if (!opened) {
         return false;
     }
+    startupTrace_->mark(StartupPhase::DecoderOpened);
 
-    // 打开解码器
-    ret = avcodec_open2(codecContext_, codec_, nullptr);
-    if (ret < 0) {
-        char error_str[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, error_str, AV_ERROR_MAX_STRING_SIZE);
-        OH_LOG_ERROR(LOG_APP, "Failed to open codec: %{public}s", error_str);
-        return false;
+    // 记录打开解码器时的参数，重连后比较
+    if (!decoderParameters_) {
+        decoderParameters_ = avcodec_parameters_alloc();
+    }
+    if (decoderParameters_ && avcodec_parameters_copy(decoderParameters_, codecpar) < 0) {
+        avcodec_parameters_free(&decoderParameters_);
     }
 
     frameWidth_ = codecContext_->width;
     frameHeight_ = codecContext_->height;
     OH_LOG_INFO(LOG_APP, "Decoder opened successfully, frame size: %{public}dx%{public}d", frameWidth_, frameHeight_);
 
+    decoderName_ = codec_->name;
+    backendName_ = decoderBackend_->name();
+
     // 输出解码器像素格式信息
     const char *decoder_pix_fmt_name = av_get_pix_fmt_name(codecContext_->pix_fmt);
     OH_LOG_INFO(LOG_APP, "Decoder pixel format: %{public}d (%{public}s)", codecContext_->pix_fmt,
                 decoder_pix_fmt_name ? decoder_pix_fmt_name : "unknown");
 
-    // 检查是否为YUV420P
-    if (codecContext_->pix_fmt != AV_PIX_FMT_YUV420P) {
-        OH_LOG_WARN(LOG_APP, "Warning: Decoder output format is not YUV420P, may need conversion");
+    // 渲染端直接支持YUV420P和NV12/NV21
+    if (codecContext_->pix_fmt != AV_PIX_FMT_YUV420P && codecContext_->pix_fmt != AV_PIX_FMT_YUVJ420P &&
+        codecContext_->pix_fmt != AV_PIX_FMT_NV12 && codecContext_->pix_fmt != AV_PIX_FMT_NV21) {
+        OH_LOG_WARN(LOG_APP, "Warning: Decoder output format is not YUV420P or NV12/NV21, may need conversion");
     }
 
     // 计算帧率
     AVRational timeBase = formatContext_->streams[videoStreamIndex_]->time_base;
+    streamTimeBase_ = timeBase;
     AVRational frameRate = formatContext_->streams[videoStreamIndex_]->r_frame_rate;
     if (frameRate.num > 0 && frameRate.den > 0) {
         frameRate_ = av_q2d(frameRate);
@@ -313,47 +1238,235 @@ bool VideoStreamHandler::setupDecoder() {
     return true;
 }
 
-bool VideoStreamHandler::processFrame(AVFrame *frame) {
-    // 详细的帧信息诊断
-    const char *frame_pix_fmt_name = av_get_pix_fmt_name((enum AVPixelFormat)frame->format);
-    OH_LOG_INFO(LOG_APP, "Frame format: %{public}d (%{public}s), key_frame: %{public}d, pict_type: %{public}d",
-                frame->format, frame_pix_fmt_name ? frame_pix_fmt_name : "unknown", frame->key_frame, frame->pict_type);
+// 按当前解码后端分配、配置并打开解码器上下文，失败时释放上下文
+bool VideoStreamHandler::openDecoder(const AVCodecParameters *codecpar) {
+    // 分配解码器上下文
+    codecContext_ = avcodec_alloc_context3(codec_);
+    if (!codecContext_) {
+        OH_LOG_ERROR(LOG_APP, "Failed to allocate codec context");
+        return false;
+    }
+
+    // 从流参数复制到解码器上下文
+    int ret = avcodec_parameters_to_context(codecContext_, codecpar);
+    if (ret < 0) {
+        char error_str[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, error_str, AV_ERROR_MAX_STRING_SIZE);
+        OH_LOG_ERROR(LOG_APP, "Failed to copy codec parameters: %{public}s", error_str);
+        avcodec_free_context(&codecContext_);
+        return false;
+    }
+
+    // 解码输出图像从缓冲池分配，稳态解码不再反复申请整帧内存
+    framePool_->attach(codecContext_);
+
+    // 数据包到达时间透传到输出帧，用于延迟测量
+    codecContext_->flags |= AV_CODEC_FLAG_COPY_OPAQUE;
+    if (options_.lowLatency) {
+        codecContext_->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        codecContext_->flags2 |= AV_CODEC_FLAG2_FAST;
+    }
+
+    // 多线程解码配置
+    switch (options_.decodeThreadMode) {
+    case DecodeThreadMode::Frame:
+        codecContext_->thread_type = FF_THREAD_FRAME;
+        break;
+    case DecodeThreadMode::Slice:
+        codecContext_->thread_type = FF_THREAD_SLICE;
+        break;
+    default:
+        // 帧级多线程每个线程都会多缓存一帧，低延迟模式下只用片级多线程
+        codecContext_->thread_type = options_.lowLatency ? FF_THREAD_SLICE : FF_THREAD_FRAME | FF_THREAD_SLICE;
+        break;
+    }
+    codecContext_->thread_count = options_.decodeThreadCount;
+    if (codecContext_->thread_count <= 0 && !options_.decodeCpus.empty()) {
+        codecContext_->thread_count = static_cast<int>(options_.decodeCpus.size());
+    }
+    // 共享解码时并发来自多路流，解码器内部不再各开一个线程池
+    if (codecContext_->thread_count <= 0 && options_.sharedDecoder) {
+        codecContext_->thread_count = 1;
+    }
+
+    if (!decoderBackend_->configure(codecContext_)) {
+        OH_LOG_ERROR(LOG_APP, "Failed to configure %{public}s decoder backend", decoderBackend_->name());
+        avcodec_free_context(&codecContext_);
+        return false;
+    }
+
+    // FFmpeg的工作线程在avcodec_open2中创建并继承调用线程的亲和性，打开期间临时绑定到目标CPU
+    cpu_set_t previousAffinity;
+    bool pinned = SetThreadAffinity(options_.decodeCpus, &previousAffinity);
+
+    // 打开解码器
+    ret = avcodec_open2(codecContext_, codec_, nullptr);
+
+    if (pinned) {
+        sched_setaffinity(0, sizeof(cpu_set_t), &previousAffinity);
+    }
+    if (ret < 0) {
+        char error_str[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, error_str, AV_ERROR_MAX_STRING_SIZE);
+        OH_LOG_ERROR(LOG_APP, "Failed to open codec with %{public}s backend: %{public}s", decoderBackend_->name(),
+                     error_str);
+        avcodec_free_context(&codecContext_);
+        return false;
+    }
+
+    activeThreadType_ = codecContext_->active_thread_type;
+    activeThreadCount_ = codecContext_->thread_count;
+    decoderUsable_ = true;
+    OH_LOG_INFO(LOG_APP, "Decoder threading: %{public}s, %{public}d threads, pinned: %{public}s",
+                ThreadTypeName(activeThreadType_), activeThreadCount_.load(), pinned ? "yes" : "no");
+    return true;
+}
+
+void VideoStreamHandler::fallBackToSoftware(const char *reason) {
+    OH_LOG_WARN(LOG_APP, "Hardware decoder backend %{public}s %{public}s, falling back to software",
+                decoderBackend_->name(), reason);
+    hardwareFailed_ = true;
+    hardwareFallbacks_++;
+    decoderBackend_ = CreateDecoderBackend(DecoderBackendMode::Software, codec_);
+    backendName_ = decoderBackend_->name();
+}
+
+// 硬件后端在解码中途出错：在解码线程内按打开时的参数重建软件解码器，从下一个关键帧开始
+void VideoStreamHandler::reopenSoftwareDecoder() {
+    decoderUsable_ = false;
+    avcodec_free_context(&codecContext_);
+    fallBackToSoftware("failed while decoding");
+    if (!decoderParameters_ || !openDecoder(decoderParameters_)) {
+        OH_LOG_ERROR(LOG_APP, "Failed to reopen software decoder");
+        reportError("Failed to reopen software decoder: " + streamUrl_);
+        return;
+    }
+    beginKeyframeWait("decoder fallback");
+}
+
+bool VideoStreamHandler::processFrame(const VideoFrame &videoFrame) {
+    // 详细的帧信息诊断，仅在打开逐帧日志时输出
+    const AVFrame *frame = videoFrame.avFrame();
+    if (frame) {
+        FRAME_LOG(LOG_APP, LOG_DEBUG, LOG_DOMAIN, LOG_TAG,
+                  "Frame format: %{public}d (%{public}s), key_frame: %{public}d, pict_type: %{public}d",
+                  frame->format, PixelFormatName(frame->format), frame->key_frame, frame->pict_type);
+    }
 
     // 检查帧数据有效性
-    if (!frame->data[0] || !frame->data[1] || !frame->data[2]) {
-        OH_LOG_ERROR(LOG_APP, "Frame data is NULL! Y=%{public}p, U=%{public}p, V=%{public}p", frame->data[0],
-                     frame->data[1], frame->data[2]);
+    // 半平面格式（NV12/NV21）只有两个平面
+    if (!videoFrame.data[0] || !videoFrame.data[1] || (!videoFrame.isSemiPlanar() && !videoFrame.data[2])) {
+        OH_LOG_ERROR(LOG_APP, "Frame data is NULL! Y=%{public}p, U=%{public}p, V=%{public}p", videoFrame.data[0],
+                     videoFrame.data[1], videoFrame.data[2]);
         return false;
     }
 
-    // 创建VideoFrame结构
-    VideoFrame videoFrame;
-    videoFrame.width = frameWidth_;
-    videoFrame.height = frameHeight_;
-    videoFrame.pts = frame->pts;
-
-    // 设置YUV平面数据
-    videoFrame.data[0] = frame->data[0];         // Y平面
-    videoFrame.data[1] = frame->data[1];         // U平面
-    videoFrame.data[2] = frame->data[2];         // V平面
-    videoFrame.linesize[0] = frame->linesize[0]; // Y平面行大小
-    videoFrame.linesize[1] = frame->linesize[1]; // U平面行大小
-    videoFrame.linesize[2] = frame->linesize[2]; // V平面行大小
-
-    // OH_LOG_INFO(LOG_APP, "VideoFrame created: %{public}dx%{public}d, pts=%{public}ld, Y_linesize=%{public}d",
-    //             videoFrame.width, videoFrame.height, static_cast<long>(videoFrame.pts), videoFrame.linesize[0]);
-
-    // 调用回调函数
+    // 替换最近一帧的引用，旧引用在锁外释放
+    VideoFrame previous = videoFrame.ref();
+    {
+        std::lock_guard<std::mutex> latestLock(latestFrameMutex_);
+        std::swap(previous, latestFrame_);
+    }
+
+    // 分发给所有订阅者，各自按需增加引用，不复制像素数据。
+    // 不可见的surface只在关键帧时刷新，重新可见时立即有一幅较新的画面；缩略图按thumbnailFps限速
+    bool keyFrame = !frame || frame->key_frame;
+    int64_t nowUs = av_gettime_relative();
+    int64_t thumbnailIntervalUs = options_.thumbnailFps > 0 ? AV_TIME_BASE / options_.thumbnailFps : 0;
     std::lock_guard<std::mutex> lock(callbackMutex_);
-    if (frameCallback_) {
-        frameCallback_(videoFrame);
-    } else {
-        OH_LOG_ERROR(LOG_APP, "No frame callback set!");
+    if (frameSubscribers_.empty()) {
+        OH_LOG_ERROR(LOG_APP, "No frame subscriber!");
+    }
+    for (auto &entry : frameSubscribers_) {
+        FrameSubscriber &subscriber = entry.second;
+        if ((subscriber.visibility == SurfaceVisibility::Hidden && !keyFrame) ||
+            (subscriber.visibility == SurfaceVisibility::Thumbnail &&
+             nowUs - subscriber.lastDeliveredUs < thumbnailIntervalUs)) {
+            throttledFrames_++;
+            continue;
+        }
+        subscriber.lastDeliveredUs = nowUs;
+        subscriber.callback(videoFrame);
     }
 
     return true;
 }
 
+// 解复用线程调用：解码线程可能正在重建解码器，不访问codecContext_
+bool VideoStreamHandler::decoderParametersMatch() const {
+    if (!decoderParameters_ || !decoderUsable_) {
+        return false;
+    }
+    const AVStream *stream = formatContext_->streams[videoStreamIndex_];
+    const AVCodecParameters *codecpar = stream->codecpar;
+    const AVCodecParameters *previous = decoderParameters_;
+    if (codecpar->codec_id != previous->codec_id || !SameExtradata(codecpar, previous)) {
+        return false;
+    }
+    // 跳过探测时尺寸和像素格式可能未知，只比较两边都已知的字段
+    if (codecpar->width > 0 && previous->width > 0 &&
+        (codecpar->width != previous->width || codecpar->height != previous->height)) {
+        return false;
+    }
+    if (codecpar->format != AV_PIX_FMT_NONE && previous->format != AV_PIX_FMT_NONE &&
+        codecpar->format != previous->format) {
+        return false;
+    }
+    // 时间基变化时呈现调度和延迟控制需要按新时间基重新初始化
+    return av_cmp_q(stream->time_base, streamTimeBase_) == 0;
+}
+
+bool VideoStreamHandler::isLiveUrl() const {
+    for (const char *prefix : LIVE_PROTOCOLS) {
+        if (streamUrl_.compare(0, strlen(prefix), prefix) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int VideoStreamHandler::resolveTargetLatencyMs() const {
+    if (options_.targetLatencyMs >= 0) {
+        return options_.targetLatencyMs;
+    }
+    if (isLiveUrl()) {
+        return options_.lowLatency ? LOW_LATENCY_TARGET_LATENCY_MS : DEFAULT_LIVE_TARGET_LATENCY_MS;
+    }
+    return 0;
+}
+
+int64_t VideoStreamHandler::elapsedMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime_)
+        .count();
+}
+
+void VideoStreamHandler::updateLatency(const VideoFrame &videoFrame) {
+    int64_t nowMs = elapsedMs();
+    if (timeToFirstFrameMs_ < 0) {
+        timeToFirstFrameMs_ = static_cast<double>(nowMs);
+        OH_LOG_INFO(LOG_APP, "Time to first frame: %{public}lld ms", static_cast<long long>(nowMs));
+    }
+
+    const AVFrame *frame = videoFrame.avFrame();
+    if (!frame) {
+        return;
+    }
+
+    int64_t receivedMs = static_cast<int64_t>(reinterpret_cast<intptr_t>(frame->opaque));
+    if (receivedMs > 0 && receivedMs <= nowMs) {
+        receiveToRenderMs_ = Smooth(receiveToRenderMs_, static_cast<double>(nowMs - receivedMs));
+    }
+
+    int64_t realtimeBase = startTimeRealtime_.load();
+    if (realtimeBase != AV_NOPTS_VALUE && frame->pts != AV_NOPTS_VALUE) {
+        int64_t capturedUs = realtimeBase + av_rescale_q(frame->pts, streamTimeBase_, AVRational{1, 1000000});
+        double glassToGlass = (av_gettime() - capturedUs) / 1000.0;
+        if (glassToGlass >= 0) {
+            glassToGlassMs_ = Smooth(glassToGlassMs_, glassToGlass);
+        }
+    }
+}
+
 void VideoStreamHandler::cleanup() {
     if (packet_) {
         av_packet_free(&packet_);
@@ -363,9 +1476,15 @@ void VideoStreamHandler::cleanup() {
         av_frame_free(&frame_);
     }
 
+    decoderUsable_ = false;
     if (codecContext_) {
         avcodec_free_context(&codecContext_);
     }
+    decoderBackend_.reset();
+
+    if (decoderParameters_) {
+        avcodec_parameters_free(&decoderParameters_);
+    }
 
     if (formatContext_) {
         avformat_close_input(&formatContext_);
@@ -374,6 +1493,63 @@ void VideoStreamHandler::cleanup() {
     videoStreamIndex_ = -1;
 }
 
+VideoFrame VideoStreamHandler::getLatestFrame() const {
+    std::lock_guard<std::mutex> lock(latestFrameMutex_);
+    return latestFrame_.ref();
+}
+
 int VideoStreamHandler::getFrameCount() const { return frameCount_.load(); }
 
 double VideoStreamHandler::getCurrentFrameRate() const { return currentFrameRate_.load(); }
+
+FramePoolStats VideoStreamHandler::getFramePoolStats() const { return framePool_->getStats(); }
+
+DecoderInfo VideoStreamHandler::getDecoderInfo() const {
+    DecoderInfo info;
+    const char *name = decoderName_.load();
+    info.codecName = name ? name : "";
+    info.threadMode = ThreadTypeName(activeThreadType_.load());
+    info.threadCount = activeThreadCount_.load();
+    const char *backend = backendName_.load();
+    info.backend = backend ? backend : "";
+    info.hardwareFallbacks = hardwareFallbacks_.load();
+    return info;
+}
+
+std::shared_ptr<StartupTrace> VideoStreamHandler::getStartupTrace() const { return startupTrace_; }
+
+LatencyStats VideoStreamHandler::getLatencyStats() const {
+    LatencyStats stats;
+    stats.timeToFirstFrameMs = timeToFirstFrameMs_.load();
+    stats.receiveToRenderMs = receiveToRenderMs_.load();
+    stats.glassToGlassMs = glassToGlassMs_.load();
+    stats.probeSkipped = probeSkipped_.load();
+    stats.control = latencyController_.getStats();
+    return stats;
+}
+
+PresentationStats VideoStreamHandler::getPresentationStats() const { return scheduler_.getStats(); }
+
+ReconnectStats VideoStreamHandler::getReconnectStats() const {
+    ReconnectStats stats;
+    stats.reconnects = reconnects_.load();
+    stats.failedAttempts = failedReconnectAttempts_.load();
+    stats.decoderReopens = decoderReopens_.load();
+    stats.lastRecoveryMs = lastRecoveryMs_.load();
+    stats.reconnecting = reconnecting_.load();
+    return stats;
+}
+
+PipelineStats VideoStreamHandler::getPipelineStats() const {
+    PipelineStats stats;
+    if (packetQueue_) {
+        stats.packetQueueSize = packetQueue_->size();
+        stats.packetQueueCapacity = packetQueue_->capacity();
+    }
+    if (frameQueue_) {
+        stats.frameQueueSize = frameQueue_->size();
+        stats.frameQueueCapacity = frameQueue_->capacity();
+    }
+    stats.droppedFrames = droppedFrames_.load();
+    return stats;
+}
@@ -1,12 +1,24 @@
 #ifndef VIDEO_STREAM_HANDLER_H
 #define VIDEO_STREAM_HANDLER_H
 
+#include "common/spsc_queue.h"
+#include "decoder_backend.h"
+#include "frame_pool.h"
+#include "latency_controller.h"
+#include "presentation_scheduler.h"
+#include "startup_trace.h"
+#include "stream_executor.h"
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -15,12 +27,155 @@ extern "C" {
 #include <libavutil/imgutils.h>
 }
 
+// 解码后的视频帧。
+// 通过av_frame_ref持有AVFrame缓冲区的引用，仅可移动：持有期间data指针始终有效，
+// 不会被解码器复用，因此可以入队、丢弃或交给其他消费者而无需拷贝像素数据。
 struct VideoFrame {
-    uint8_t *data[3]; // Y, U, V平面数据指针
+    uint8_t *data[3]; // Y, U, V平面数据指针；NV12/NV21时data[1]为交错的UV平面，data[2]为空
     int linesize[3];  // Y, U, V平面的行大小
     int width;
     int height;
     int64_t pts;
+    int format; // AVPixelFormat
+
+    VideoFrame();
+    ~VideoFrame();
+    VideoFrame(VideoFrame &&other) noexcept;
+    VideoFrame &operator=(VideoFrame &&other) noexcept;
+    VideoFrame(const VideoFrame &) = delete;
+    VideoFrame &operator=(const VideoFrame &) = delete;
+
+    // 引用src的缓冲区（零拷贝），失败时返回无效帧
+    static VideoFrame fromAVFrame(const AVFrame *src);
+
+    // 对同一缓冲区再增加一个引用，供其他消费者持有
+    VideoFrame ref() const;
+
+    bool isValid() const { return data[0] != nullptr; }
+    bool isSemiPlanar() const { return format == AV_PIX_FMT_NV12 || format == AV_PIX_FMT_NV21; }
+    const AVFrame *avFrame() const { return avFrame_; }
+
+private:
+    void reset();
+
+    AVFrame *avFrame_; // 为空时data仅为外部指针（如测试帧），不持有引用
+};
+
+// 解码器多线程模式
+enum class DecodeThreadMode {
+    Auto,  // 由FFmpeg按编解码器能力选择帧级或片级多线程
+    Frame, // 帧级多线程：吞吐优先，每增加一个线程多一帧延迟
+    Slice, // 片级多线程：低延迟，依赖码流按slice切分
+};
+
+// surface的可见状态，同一路流取所有订阅者中最高的一级决定解码方式
+enum class SurfaceVisibility {
+    Hidden = 0,    // 不可见：只在关键帧时刷新
+    Thumbnail = 1, // 缩略图：只解码参考帧，按thumbnailFps限速交给渲染
+    Visible = 2,
+};
+
+// 所有订阅者都不可见时的解码方式
+enum class HiddenDecodeMode {
+    KeyframesOnly, // 只解码关键帧（AVDISCARD_NONKEY），保持连接和解码器状态
+    Suspend,       // 停止解码，重新可见时冲刷解码器并从下一个关键帧恢复
+};
+
+// 流配置
+struct StreamOptions {
+    // 流水线：解复用 -> 解码 -> 渲染 三个线程之间的队列深度
+    size_t packetQueueDepth = 128; // 解复用到解码的AVPacket队列
+    size_t frameQueueDepth = 4;    // 解码到渲染的VideoFrame队列
+
+    // 解码器线程
+    DecodeThreadMode decodeThreadMode = DecodeThreadMode::Auto;
+    int decodeThreadCount = 0;   // 0表示按CPU核数自动选择
+    std::vector<int> decodeCpus; // 解码线程绑定的CPU，如大核编号；为空表示不绑定
+
+    // 解码后端：Auto在平台提供硬件解码设备时使用硬件解码，打开或解码出错时回退软件解码
+    DecoderBackendMode decoderBackend = DecoderBackendMode::Auto;
+    DecoderBackendFactory decoderBackendFactory; // 非空时代替decoderBackend创建首选后端，回退仍用软件后端
+
+    // 多路宫格：解码放到所有流共享的StreamExecutor上，不再每路一个解码线程；
+    // 未指定decodeThreadCount时解码器单线程，并发来自多路流而不是各自的FFmpeg线程池
+    bool sharedDecoder = false;
+    StreamPriority priority = StreamPriority::Normal; // 共享解码时的调度优先级
+
+    // 不可见和缩略图surface的解码节流
+    HiddenDecodeMode hiddenDecodeMode = HiddenDecodeMode::KeyframesOnly;
+    int thumbnailFps = 5; // 缩略图surface每秒最多刷新的帧数，0表示不限
+
+    // 低延迟直播模式：限制探测量、关闭解复用缓冲、解码器low_delay，SDP已给出编码参数时跳过find_stream_info
+    bool lowLatency = false;
+
+    // 起播和检测到丢包、码流损坏后丢弃数据包直到关键帧，并丢弃解码器标记为损坏的帧，避免解码无法参考的帧和花屏
+    bool keyframeResync = true;
+
+    // 按pts节奏呈现并丢弃迟到帧，帧队列满时反压解码；关闭时解码出的帧立即交给渲染，渲染跟不上时丢弃
+    bool framePacing = true;
+
+    // 目标延迟（毫秒）：超过后依次加快呈现、只解码参考帧、丢包到下一个关键帧。
+    // -1按协议自动选择（实时协议启用，文件和点播关闭），0只测量不干预
+    int targetLatencyMs = -1;
+
+    // 断线重连：读取出错（实时流收到EOF也视为断开）后按指数退避重新打开输入，编码参数不变时沿用现有解码器
+    bool autoReconnect = true;
+    int reconnectInitialDelayMs = 100; // 第一次重试前的等待
+    int reconnectMaxDelayMs = 5000;    // 退避等待的上限
+    double reconnectJitter = 0.2;      // 每次等待随机浮动的比例，避免多路流同时重连
+    int maxReconnectAttempts = -1;     // 单次断开后的最大尝试次数，-1表示不限
+};
+
+// 延迟测量结果，单位毫秒，未知时为-1
+struct LatencyStats {
+    double timeToFirstFrameMs = -1; // startStream到首帧交给渲染回调
+    double receiveToRenderMs = -1;  // 数据包到达到渲染回调完成（平滑值）
+    double glassToGlassMs = -1;     // 依据RTCP发送端时钟估算的采集到显示延迟（平滑值），要求两端时钟同步
+    bool probeSkipped = false;      // 是否因SDP参数完整而跳过了find_stream_info
+    LatencyControlStats control;    // 自适应延迟控制
+};
+
+// 解码器实际生效的配置
+struct DecoderInfo {
+    std::string codecName;
+    std::string threadMode; // "frame"、"slice"或"none"
+    int threadCount = 0;
+    std::string backend;       // 实际生效的解码后端："software"或硬件设备类型名
+    int hardwareFallbacks = 0; // 硬件解码不可用而回退软件解码的次数
+};
+
+// 断线重连统计
+struct ReconnectStats {
+    int reconnects = 0;         // 成功重连次数
+    int failedAttempts = 0;     // 失败的连接尝试次数
+    int decoderReopens = 0;     // 因编码参数变化而重建解码器的次数
+    double lastRecoveryMs = -1; // 最近一次从检测到断开到重新连上的耗时
+    bool reconnecting = false;
+};
+
+// 可见性节流统计
+struct VisibilityStats {
+    SurfaceVisibility visibility = SurfaceVisibility::Visible; // 所有订阅者中最高的可见级别
+    uint64_t suspendedPackets = 0; // 暂停解码期间丢弃的数据包数
+    uint64_t throttledFrames = 0;  // 因surface不可见或缩略图限速而未交给渲染的帧数
+};
+
+// 关键帧同步统计
+struct KeyframeSyncStats {
+    int resyncs = 0;                  // 起播、重连、丢包或恢复可见后开始等待关键帧的次数
+    uint64_t discardedPackets = 0;    // 等待关键帧期间丢弃的数据包数
+    uint64_t corruptFrames = 0;       // 解码器标记为损坏而丢弃的帧数
+    double lastTimeToKeyframeMs = -1; // 最近一次从开始等待到收到关键帧的耗时
+    bool awaitingKeyframe = false;
+};
+
+// 各阶段队列占用情况
+struct PipelineStats {
+    size_t packetQueueSize = 0;
+    size_t packetQueueCapacity = 0;
+    size_t frameQueueSize = 0;
+    size_t frameQueueCapacity = 0;
+    int droppedFrames = 0; // 渲染队列满时丢弃的帧数
 };
 
 class VideoStreamHandler {
@@ -31,33 +186,118 @@ public:
     VideoStreamHandler();
     ~VideoStreamHandler();
 
-    // 设置回调函数
-    void setFrameCallback(FrameCallback callback);
+    // 订阅解码输出，id通常为surfaceId，已存在时替换其回调；返回订阅后的订阅者数。
+    // 同一路流的连接和解码由所有订阅者共享，每个订阅者在回调中各自持有帧的引用
+    size_t addFrameSubscriber(int64_t id, FrameCallback callback);
+
+    // 取消订阅，返回剩余的订阅者数
+    size_t removeFrameSubscriber(int64_t id);
+    bool hasFrameSubscriber(int64_t id) const;
+    size_t getFrameSubscriberCount() const;
+
+    // 接管另一个处理器的订阅者（保留可见状态），本处理器已有的id不覆盖；返回接管的订阅者id
+    std::vector<int64_t> adoptFrameSubscribers(VideoStreamHandler &previous);
+
+    // 设置订阅者surface的可见状态，订阅者不存在时返回false
+    bool setSubscriberVisibility(int64_t id, SurfaceVisibility visibility);
+    VisibilityStats getVisibilityStats() const;
+
+    // 获取关键帧同步统计
+    KeyframeSyncStats getKeyframeSyncStats() const;
+
     void setErrorCallback(ErrorCallback callback);
 
     // 开始播放流
-    bool startStream(const std::string &url);
+    bool startStream(const std::string &url, const StreamOptions &options = StreamOptions());
 
-    // 停止播放流
+    // 停止播放流，阻塞中的网络操作会被立即打断
     void stopStream();
 
+    // 最近一次stopStream的耗时（毫秒），未停止过为-1
+    double getLastStopLatencyMs() const;
+
     // 获取流状态
     bool isStreaming() const;
 
+    // 流线程是否仍在运行，包括打开和重连阶段
+    bool isActive() const;
+
+    // 调整共享解码的调度优先级，对下一个解码片段生效
+    void setPriority(StreamPriority priority);
+    StreamPriority getPriority() const;
+
     // 获取流信息
     std::string getStreamInfo() const;
 
+    // 最近一次交给渲染的帧，返回对同一缓冲区的引用（零拷贝），还没有帧时返回无效帧。
+    // 供截图等旁路消费者在自己的线程上使用，不经过解码线程
+    VideoFrame getLatestFrame() const;
+
     // 获取帧统计信息
     int getFrameCount() const;
     double getCurrentFrameRate() const;
 
+    // 获取流水线队列占用
+    PipelineStats getPipelineStats() const;
+
+    // 获取解码输出缓冲池命中情况
+    FramePoolStats getFramePoolStats() const;
+
+    // 获取解码器实际使用的线程模式
+    DecoderInfo getDecoderInfo() const;
+
+    // 获取首帧时间和端到端延迟
+    LatencyStats getLatencyStats() const;
+
+    // 获取按pts呈现的统计：显示、迟到丢弃和重复帧数
+    PresentationStats getPresentationStats() const;
+
+    // 获取断线重连统计
+    ReconnectStats getReconnectStats() const;
+
+    // 启动时间线，以startStream调用为起点；渲染端通过它记录首次上传纹理和首次上屏
+    std::shared_ptr<StartupTrace> getStartupTrace() const;
+
+    // startStream以来的毫秒数，与解码输出帧opaque中携带的数据包到达时间同一时基
+    int64_t elapsedMs() const;
+
 private:
     void streamThread();
+    static int interruptCallback(void *opaque);
+    void armIoDeadline(int64_t timeoutUs);
+    void decodeThread();
+    void scheduleDecode();
+    bool frameQueueBackpressured() const;
+    void pushPendingFrames();
+    void runDecodeSlice();
+    void decodePacket(AVPacket *packet);
+    void receiveFrames();
+    void drainDecoder();
+    void finishDecode();
+    void beginKeyframeWait(const char *reason);
+    void updateVisibility();
+    SurfaceVisibility getVisibility() const;
+    void renderThread();
+    void startPipeline();
+    void stopPipeline();
+    bool pushPacket(AVPacket *packet);
+    bool shouldReconnect(int readError) const;
+    bool reconnect(int readError);
+    bool sleepUnlessStopped(int64_t delayMs) const;
+    void reportError(const std::string &message);
+    void drainQueues();
     void cleanup();
     bool initializeFFmpeg();
     bool openInputStream(const std::string &url);
     bool setupDecoder();
-    bool processFrame(AVFrame *frame);
+    bool openDecoder(const AVCodecParameters *codecpar);
+    void fallBackToSoftware(const char *reason);
+    void reopenSoftwareDecoder();
+    bool decoderParametersMatch() const;
+    bool isLiveUrl() const;
+    bool processFrame(const VideoFrame &videoFrame);
+    void updateLatency(const VideoFrame &videoFrame);
+    int resolveTargetLatencyMs() const;
 
     // FFmpeg 相关
     AVFormatContext *formatContext_;
@@ -65,19 +305,74 @@ private:
     const AVCodec *codec_;
     AVFrame *frame_;
     AVPacket *packet_;
+    AVCodecParameters *decoderParameters_; // 打开解码器时的编码参数，重连后据此判断能否沿用解码器
+    FramePool *framePool_; // 本路流独占，重连和重建解码器后沿用，随handler销毁释放
+    std::unique_ptr<DecoderBackend> decoderBackend_;
+    bool hardwareFailed_; // 本次播放中硬件后端出过错，之后重建解码器只用软件后端
+    bool backendError_;   // 解码线程内：硬件帧下载失败，待改用软件解码器
+    // 解码器上下文已打开可用；解码线程重建解码器时codecContext_会被替换，解复用线程重连时只读这个标志
+    std::atomic<bool> decoderUsable_;
 
     int videoStreamIndex_;
 
     // 线程和状态管理
-    std::thread streamThread_;
+    std::thread streamThread_; // 解复用线程，同时负责打开流和拉起后两个阶段
+    std::thread decodeThread_;
+    std::thread renderThread_;
     std::atomic<bool> isStreaming_;
     std::atomic<bool> shouldStop_;
-    std::mutex callbackMutex_;
+    std::atomic<bool> streamThreadActive_; // 流线程尚未退出，包括打开和重连阶段
+    std::atomic<int64_t> ioDeadlineUs_;    // 当前阻塞I/O的截止时间(av_gettime_relative)
+    std::atomic<double> lastStopLatencyMs_;
+    std::atomic<bool> demuxFinished_;
+    std::atomic<bool> decodeFinished_;
+    std::mutex decodeFinishedMutex_; // 共享解码时stopPipeline据此等待最后一个片段收尾
+    std::condition_variable decodeFinishedCond_;
+    std::atomic<bool> presentationResync_; // 重连后由解码线程置位，渲染线程据此重新锚定呈现时钟
+
+    // 解码状态，同一时刻只有解码线程或一个解码片段访问
+    bool skippingToKeyframe_; // 延迟控制要求丢包到下一个关键帧
+    std::atomic<bool> awaitingKeyframe_; // 起播、重连、丢包或恢复可见后等待第一个关键帧
+    int64_t keyframeWaitStartUs_;
+    bool corruptionDetected_; // receiveFrames发现损坏帧，由decodePacket处理
+    SurfaceVisibility decodeVisibility_; // 解码端上次采用的可见级别，用于检测切换
+    std::deque<VideoFrame> pendingFrames_; // 共享解码时帧队列放不下的帧，下一个片段先交出
+    bool decoderDrained_;                  // 共享解码时流结束的冲刷已经做过
+
+    // 可见性节流
+    std::atomic<int> visibility_; // SurfaceVisibility，订阅者中最高的一级
+    std::atomic<uint64_t> suspendedPackets_;
+    std::atomic<uint64_t> throttledFrames_;
+
+    // 关键帧同步
+    std::atomic<int> keyframeResyncs_;
+    std::atomic<uint64_t> keyframeDiscardedPackets_;
+    std::atomic<uint64_t> corruptFrames_;
+    std::atomic<double> lastTimeToKeyframeMs_;
+
+    // 共享解码：已提交或正在执行解码片段时置位，保证同一路流的片段串行执行
+    std::atomic<bool> decodeScheduled_;
+    std::atomic<int> priority_;
+
+    // 阶段间队列
+    StreamOptions options_;
+    std::unique_ptr<SpscQueue<AVPacket *>> packetQueue_;
+    std::unique_ptr<SpscQueue<VideoFrame>> frameQueue_;
+    mutable std::mutex callbackMutex_;
 
     // 回调函数
-    FrameCallback frameCallback_;
+    struct FrameSubscriber {
+        FrameCallback callback;
+        SurfaceVisibility visibility = SurfaceVisibility::Visible;
+        int64_t lastDeliveredUs = 0; // 缩略图限速用
+    };
+    std::map<int64_t, FrameSubscriber> frameSubscribers_;
     ErrorCallback errorCallback_;
 
+    // 渲染线程保存的最近一帧引用，供截图使用，多占用一块缓冲池缓冲区
+    mutable std::mutex latestFrameMutex_;
+    VideoFrame latestFrame_;
+
     // 流信息
     std::string streamUrl_;
     int frameWidth_;
@@ -87,6 +382,33 @@ private:
     // 帧统计
     std::atomic<int> frameCount_;
     std::atomic<double> currentFrameRate_;
+    std::atomic<int> droppedFrames_;
+    PresentationScheduler scheduler_; // 只在渲染线程上调度
+    LatencyController latencyController_;
+
+    // 断线重连
+    std::atomic<int> reconnects_;
+    std::atomic<int> failedReconnectAttempts_;
+    std::atomic<int> decoderReopens_;
+    std::atomic<double> lastRecoveryMs_;
+    std::atomic<bool> reconnecting_;
+
+    // 延迟测量
+    std::shared_ptr<StartupTrace> startupTrace_;
+    std::chrono::steady_clock::time_point startTime_;
+    AVRational streamTimeBase_;
+    std::atomic<int64_t> startTimeRealtime_; // 流中pts=0对应的发送端墙钟时间(us)
+    std::atomic<double> timeToFirstFrameMs_;
+    std::atomic<double> receiveToRenderMs_;
+    std::atomic<double> glassToGlassMs_;
+    std::atomic<bool> probeSkipped_;
+
+    // 解码器实际生效的线程配置
+    std::atomic<const char *> decoderName_;
+    std::atomic<const char *> backendName_;
+    std::atomic<int> hardwareFallbacks_;
+    std::atomic<int> activeThreadType_;
+    std::atomic<int> activeThreadCount_;
 };
 
 #endif // VIDEO_STREAM_HANDLER_H